@@ -0,0 +1,329 @@
+// Offline AOB scanner: searches a list of signatures in PE and ELF images on disk, without running them,
+// using the same matching engine as AobScanMan. Results are printed to stdout as JSON.
+//
+// Usage: AobScan [-j threads] [-m max_matches] [--all-sections] <signature file> <image>...
+//
+// Signature files contain one signature per line, as a name followed by a CE-style AOB string:
+//     # Comment
+//     PlayerUpdate = 48 8B ?? 89 5C 24 ?8
+//
+// The exit code is 0 if every signature matched exactly once in every image, 1 if some were missing or
+// ambiguous, and 2 on usage or I/O errors.
+
+#include "ImageFile.h"
+#include "Include/AobPattern.h"
+#include "Implementation/AobScanner.h"
+#include "Implementation/AobMultiScanner.h"
+#include "Implementation/ThreadPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+
+using namespace MCF;
+using namespace AobScan;
+
+namespace
+{
+	struct Signature
+	{
+		std::string name;
+		CompiledAob aob;
+	};
+
+	/// <summary>
+	/// Matches of a signature in an image. At most max_matches RVAs are kept, and counting stops past that.
+	/// </summary>
+	struct SignatureResult
+	{
+		std::vector<uint64_t> rvas;
+		size_t count = 0;
+	};
+
+	struct ImageResult
+	{
+		std::string path;
+		ImageFile image;
+		std::string error;
+		bool opened = false;
+		std::vector<SignatureResult> results;
+	};
+
+	void Usage()
+	{
+		fprintf(stderr, "Usage: AobScan [-j threads] [-m max_matches] [--all-sections] <signature file> <image>...\n");
+	}
+
+	bool LoadSignatures(const char* path, std::vector<Signature>& signatures)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			fprintf(stderr, "Could not open signature file %s\n", path);
+			return false;
+		}
+
+		std::string line;
+		for (size_t line_num = 1; std::getline(file, line); line_num++)
+		{
+			size_t comment = line.find('#');
+			if (comment != std::string::npos) line.resize(comment);
+
+			size_t eq = line.find('=');
+			if (eq == std::string::npos)
+			{
+				if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+				fprintf(stderr, "%s:%zu: expected 'name = pattern'\n", path, line_num);
+				return false;
+			}
+
+			std::string name = line.substr(0, eq);
+			name.erase(name.find_last_not_of(" \t") + 1);
+			name.erase(0, name.find_first_not_of(" \t"));
+
+			std::vector<uint8_t> bytes, masks;
+			const char* s = line.c_str() + eq + 1;
+			AobChar c;
+			AobParser::Status st;
+			while ((st = AobParser::NextToken(s, c)) == AobParser::Status::Ok)
+			{
+				bytes.push_back(c.byte);
+				masks.push_back(c.mask);
+			}
+			if (name.empty() || st == AobParser::Status::Malformed || bytes.empty())
+			{
+				fprintf(stderr, "%s:%zu: malformed signature\n", path, line_num);
+				return false;
+			}
+			signatures.push_back(Signature{ name, CompiledAob(bytes.data(), masks.data(), bytes.size()) });
+		}
+		return true;
+	}
+
+	// Size of the pieces of sections scanned in parallel
+	constexpr size_t ChunkSize = 1 << 20;
+
+	/// <summary>
+	/// Piece of a section scanned by one task. Matches start in [begin, end) and may extend up to scan_end.
+	/// </summary>
+	struct Chunk
+	{
+		size_t image;
+		uint64_t rva; // RVA of begin
+		const uint8_t* begin;
+		const uint8_t* end;
+		const uint8_t* scan_end;
+		std::vector<std::pair<size_t, uint64_t>> matches; // Signature and RVA, in increasing order for each signature
+	};
+
+	// Below this number of signatures left to search for, a pass of the automaton is slower than one pass of
+	// AobScanner per signature (see AobScanManImp::MultiScanThreshold)
+	constexpr size_t MultiScanThreshold = 16;
+
+	// Find the matches of every signature in a chunk. Each pass of the automaton searches for the next match of the
+	// signatures which are not done, from their last match + 1, until max_matches + 1 were counted
+	void ScanChunk(const AobMultiScanner& scanner, const std::vector<Signature>& signatures, Chunk& chunk, size_t max_matches)
+	{
+		size_t num_signatures = signatures.size();
+		std::vector<const uint8_t*> next(num_signatures, chunk.begin);
+		std::vector<const uint8_t*> results(num_signatures);
+		std::vector<bool> done(num_signatures);
+		std::vector<size_t> counts(num_signatures);
+		for (size_t pass = 0; pass <= max_matches; pass++)
+		{
+			// Signatures which are done are marked as found so that the scanner skips them
+			const uint8_t* begin = chunk.end;
+			size_t pending = 0;
+			for (size_t k = 0; k < num_signatures; k++)
+			{
+				results[k] = done[k] ? chunk.scan_end : nullptr;
+				if (done[k]) continue;
+				begin = (std::min)(begin, next[k]);
+				pending++;
+			}
+			if (pending == 0) return;
+
+			if (pending < MultiScanThreshold)
+			{
+				for (size_t k = 0; k < num_signatures; k++)
+				{
+					for (const uint8_t* p = next[k]; !done[k] && counts[k] <= max_matches; p++)
+					{
+						p = AobScanner::Find(signatures[k].aob, p, chunk.scan_end);
+						if (p == nullptr || p >= chunk.end) break;
+						chunk.matches.emplace_back(k, chunk.rva + (p - chunk.begin));
+						counts[k]++;
+					}
+				}
+				return;
+			}
+			scanner.FindNext(begin, chunk.scan_end, next.data(), results.data());
+
+			for (size_t k = 0; k < num_signatures; k++)
+			{
+				if (done[k]) continue;
+
+				// Matches starting past the end of the chunk belong to the next one
+				const uint8_t* match = results[k];
+				if (match == nullptr || match >= chunk.end)
+				{
+					done[k] = true;
+					continue;
+				}
+				chunk.matches.emplace_back(k, chunk.rva + (match - chunk.begin));
+				counts[k]++;
+				next[k] = match + 1;
+			}
+		}
+	}
+
+	void PrintString(const char* s)
+	{
+		putchar('"');
+		for (; *s; s++)
+		{
+			if (*s == '"' || *s == '\\') printf("\\%c", *s);
+			// Bytes of other encodings than UTF-8 would make the output invalid, so non-ASCII bytes are escaped
+			else if ((unsigned char)*s < 0x20 || (unsigned char)*s >= 0x80) printf("\\u%04x", (unsigned char)*s);
+			else putchar(*s);
+		}
+		putchar('"');
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t num_threads = 0;
+	size_t max_matches = 16;
+	bool all_sections = false;
+
+	int arg = 1;
+	for (; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		if (strcmp(argv[arg], "--all-sections") == 0) all_sections = true;
+		else if (strcmp(argv[arg], "-j") == 0 && arg + 1 < argc) num_threads = strtoul(argv[++arg], nullptr, 10);
+		else if (strcmp(argv[arg], "-m") == 0 && arg + 1 < argc) max_matches = (std::max)((size_t)1, (size_t)strtoul(argv[++arg], nullptr, 10));
+		else
+		{
+			Usage();
+			return 2;
+		}
+	}
+	if (argc - arg < 2)
+	{
+		Usage();
+		return 2;
+	}
+
+	std::vector<Signature> signatures;
+	if (!LoadSignatures(argv[arg++], signatures)) return 2;
+
+	std::vector<std::unique_ptr<ImageResult>> images;
+	for (; arg < argc; arg++)
+	{
+		auto img = std::make_unique<ImageResult>();
+		img->path = argv[arg];
+		img->results.resize(signatures.size());
+		images.push_back(std::move(img));
+	}
+
+	ThreadPool pool(num_threads);
+	pool.ParallelFor(images.size(), [&](size_t i) {
+		images[i]->opened = images[i]->image.Open(images[i]->path.c_str(), images[i]->error);
+	});
+
+	// Sections are split in chunks, so that a few large images still use all threads
+	size_t overlap = 0;
+	std::vector<const CompiledAob*> aobs;
+	for (const auto& sig : signatures)
+	{
+		aobs.push_back(&sig.aob);
+		overlap = (std::max)(overlap, sig.aob.length - 1);
+	}
+	AobMultiScanner scanner(aobs.data(), aobs.size());
+
+	std::vector<Chunk> chunks;
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		if (!images[i]->opened) continue;
+		for (const auto& section : images[i]->image.Sections())
+		{
+			if (!all_sections && !section.executable) continue;
+
+			const uint8_t* end = section.data + section.size;
+			for (const uint8_t* p = section.data; p < end; p += (std::min)(ChunkSize, (size_t)(end - p)))
+			{
+				size_t left = end - p;
+				chunks.push_back(Chunk{
+					.image = i,
+					.rva = section.rva + (p - section.data),
+					.begin = p,
+					.end = p + (std::min)(ChunkSize, left),
+					.scan_end = p + (std::min)(ChunkSize + overlap, left)
+				});
+			}
+		}
+	}
+	pool.ParallelFor(chunks.size(), [&](size_t c) {
+		ScanChunk(scanner, signatures, chunks[c], max_matches);
+	});
+
+	// Chunks are in the order of their image's sections, so the matches are merged in the same order as a
+	// sequential scan
+	for (const Chunk& chunk : chunks)
+	{
+		for (const auto& [sig, rva] : chunk.matches)
+		{
+			SignatureResult& res = images[chunk.image]->results[sig];
+			if (res.count > max_matches) continue;
+			if (res.rvas.size() < max_matches) res.rvas.push_back(rva);
+			res.count++;
+		}
+	}
+
+	int exit_code = 0;
+	printf("{\n\t\"images\": [");
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		const ImageResult& img = *images[i];
+		printf(i ? ",\n\t\t{\n" : "\n\t\t{\n");
+		printf("\t\t\t\"path\": ");
+		PrintString(img.path.c_str());
+		if (!img.opened)
+		{
+			printf(",\n\t\t\t\"error\": ");
+			PrintString(img.error.c_str());
+			printf("\n\t\t}");
+			exit_code = 2;
+			continue;
+		}
+		printf(",\n\t\t\t\"format\": \"%s\",\n", img.image.FormatName());
+		printf("\t\t\t\"image_base\": \"0x%llx\",\n", (unsigned long long)img.image.ImageBase());
+		printf("\t\t\t\"signatures\": {");
+
+		size_t found = 0, ambiguous = 0, missing = 0;
+		for (size_t s = 0; s < signatures.size(); s++)
+		{
+			const SignatureResult& res = img.results[s];
+			const char* status = res.count == 0 ? "missing" : res.count == 1 ? "found" : "ambiguous";
+			(res.count == 0 ? missing : res.count == 1 ? found : ambiguous)++;
+
+			printf(s ? ",\n\t\t\t\t" : "\n\t\t\t\t");
+			PrintString(signatures[s].name.c_str());
+			printf(": { \"status\": \"%s\", \"count\": %zu%s, \"rvas\": [", status,
+				(std::min)(res.count, max_matches), res.count > max_matches ? ", \"truncated\": true" : "");
+			for (size_t r = 0; r < res.rvas.size(); r++)
+				printf(r ? ", \"0x%llx\"" : "\"0x%llx\"", (unsigned long long)res.rvas[r]);
+			printf("] }");
+		}
+		printf("\n\t\t\t},\n\t\t\t\"summary\": { \"found\": %zu, \"ambiguous\": %zu, \"missing\": %zu }\n\t\t}", found, ambiguous, missing);
+		if ((ambiguous || missing) && exit_code == 0) exit_code = 1;
+	}
+	printf("\n\t]\n}\n");
+	return exit_code;
+}
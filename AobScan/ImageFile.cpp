@@ -0,0 +1,265 @@
+#include "ImageFile.h"
+#include <string.h>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace AobScan
+{
+	namespace
+	{
+		template<typename T>
+		T Read(const uint8_t* data, size_t size, uint64_t offset)
+		{
+			T v{ };
+			if (offset <= size && sizeof(T) <= size - offset) memcpy(&v, data + offset, sizeof(T));
+			return v;
+		}
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const char* path)
+	{
+		Close();
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+		size = (size_t)file_size.QuadPart;
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != NULL) data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data) UnmapViewOfFile(data);
+		if (mapping != NULL) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+		data = nullptr;
+		size = 0;
+		mapping = NULL;
+		file = INVALID_HANDLE_VALUE;
+	}
+#else
+	bool MappedFile::Open(const char* path)
+	{
+		Close();
+		fd = open(path, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			Close();
+			return false;
+		}
+		size = (size_t)st.st_size;
+
+		void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+		madvise(p, size, MADV_WILLNEED);
+		data = (const uint8_t*)p;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data) munmap((void*)data, size);
+		if (fd >= 0) close(fd);
+		data = nullptr;
+		size = 0;
+		fd = -1;
+	}
+#endif
+
+	bool ImageFile::Open(const char* path, std::string& error)
+	{
+		sections.clear();
+		format = Format::Unknown;
+		if (!file.Open(path))
+		{
+			error = "could not map file";
+			return false;
+		}
+
+		const uint8_t* data = file.Data();
+		size_t size = file.Size();
+		if (size >= 2 && data[0] == 'M' && data[1] == 'Z') return ParsePE(error);
+		if (size >= 4 && memcmp(data, "\x7F" "ELF", 4) == 0) return ParseELF(error);
+
+		error = "not a PE or ELF image";
+		return false;
+	}
+
+	const char* ImageFile::FormatName() const
+	{
+		switch (format)
+		{
+		case Format::PE: return "PE";
+		case Format::ELF: return "ELF";
+		default: return "unknown";
+		}
+	}
+
+	void ImageFile::AddSection(std::string name, uint64_t rva, uint64_t offset, uint64_t size, bool executable)
+	{
+		if (offset >= file.Size()) return;
+		size = (std::min)(size, (uint64_t)file.Size() - offset);
+		if (size == 0) return;
+
+		sections.push_back(ImageSection{
+			.name = std::move(name),
+			.rva = rva,
+			.data = file.Data() + offset,
+			.size = (size_t)size,
+			.executable = executable
+		});
+	}
+
+	bool ImageFile::ParsePE(std::string& error)
+	{
+		const uint8_t* data = file.Data();
+		size_t size = file.Size();
+
+		uint32_t nt = Read<uint32_t>(data, size, 0x3C);
+		if (Read<uint32_t>(data, size, nt) != 0x00004550) // "PE\0\0"
+		{
+			error = "invalid PE signature";
+			return false;
+		}
+		format = Format::PE;
+
+		uint16_t num_sections = Read<uint16_t>(data, size, nt + 6);
+		uint16_t optional_size = Read<uint16_t>(data, size, nt + 20);
+		uint64_t optional = nt + 24;
+		switch (Read<uint16_t>(data, size, optional))
+		{
+		case 0x10B: image_base = Read<uint32_t>(data, size, optional + 28); break;
+		case 0x20B: image_base = Read<uint64_t>(data, size, optional + 24); break;
+		default:
+			error = "unknown PE optional header";
+			return false;
+		}
+
+		constexpr uint32_t ScnCntCode = 0x00000020, ScnMemExecute = 0x20000000;
+		uint64_t table = optional + optional_size;
+		for (uint16_t i = 0; i < num_sections; i++)
+		{
+			uint64_t header = table + 40ull * i;
+			char name[9]{ };
+			if (header + 40 > size) break;
+			memcpy(name, data + header, 8);
+
+			uint32_t virtual_size = Read<uint32_t>(data, size, header + 8);
+			uint32_t rva = Read<uint32_t>(data, size, header + 12);
+			uint32_t raw_size = Read<uint32_t>(data, size, header + 16);
+			uint32_t raw_offset = Read<uint32_t>(data, size, header + 20);
+			uint32_t characteristics = Read<uint32_t>(data, size, header + 36);
+
+			uint32_t mapped = virtual_size ? (std::min)(virtual_size, raw_size) : raw_size;
+			AddSection(name, rva, raw_offset, mapped, (characteristics & (ScnCntCode | ScnMemExecute)) != 0);
+		}
+		return true;
+	}
+
+	bool ImageFile::ParseELF(std::string& error)
+	{
+		const uint8_t* data = file.Data();
+		size_t size = file.Size();
+
+		// Only the magic was checked by Open: the class and byte order are in the rest of e_ident
+		constexpr size_t IdentSize = 16;
+		if (size < IdentSize)
+		{
+			error = "truncated ELF header";
+			return false;
+		}
+
+		bool is64 = data[4] == 2;
+		if ((data[4] != 1 && data[4] != 2) || data[5] != 1)
+		{
+			error = "unsupported ELF class or byte order";
+			return false;
+		}
+		format = Format::ELF;
+
+		auto word = [&](uint64_t offset) -> uint64_t {
+			return is64 ? Read<uint64_t>(data, size, offset) : Read<uint32_t>(data, size, offset);
+		};
+
+		constexpr uint32_t PtLoad = 1, PfX = 1, ShtNobits = 8, ShfExecInstr = 4;
+
+		// The image base is the lowest address of a loadable segment
+		uint64_t phoff = word(is64 ? 0x20 : 0x1C);
+		uint16_t phentsize = Read<uint16_t>(data, size, is64 ? 0x36 : 0x2A);
+		uint16_t phnum = Read<uint16_t>(data, size, is64 ? 0x38 : 0x2C);
+		image_base = UINT64_MAX;
+		for (uint16_t i = 0; i < phnum; i++)
+		{
+			uint64_t ph = phoff + (uint64_t)phentsize * i;
+			if (Read<uint32_t>(data, size, ph) != PtLoad) continue;
+			image_base = (std::min)(image_base, word(ph + (is64 ? 16 : 8)));
+		}
+		if (image_base == UINT64_MAX) image_base = 0;
+
+		uint64_t shoff = word(is64 ? 0x28 : 0x20);
+		uint16_t shentsize = Read<uint16_t>(data, size, is64 ? 0x3A : 0x2E);
+		uint16_t shnum = Read<uint16_t>(data, size, is64 ? 0x3C : 0x30);
+		uint16_t shstrndx = Read<uint16_t>(data, size, is64 ? 0x3E : 0x32);
+		if (shoff != 0 && shnum != 0)
+		{
+			uint64_t strtab = word(shoff + (uint64_t)shentsize * shstrndx + (is64 ? 24 : 16));
+			for (uint16_t i = 0; i < shnum; i++)
+			{
+				uint64_t sh = shoff + (uint64_t)shentsize * i;
+				uint32_t name_offset = Read<uint32_t>(data, size, sh);
+				uint32_t type = Read<uint32_t>(data, size, sh + 4);
+				uint64_t flags = word(sh + 8);
+				uint64_t addr = word(sh + (is64 ? 16 : 12));
+				uint64_t offset = word(sh + (is64 ? 24 : 16));
+				uint64_t sec_size = word(sh + (is64 ? 32 : 20));
+				if (type == ShtNobits || addr == 0) continue;
+
+				std::string name;
+				for (uint64_t p = strtab + name_offset; p < size && data[p] != 0; p++) name.push_back((char)data[p]);
+				AddSection(std::move(name), addr - image_base, offset, sec_size, (flags & ShfExecInstr) != 0);
+			}
+			return true;
+		}
+
+		// Stripped of section headers: fall back to the loadable segments
+		for (uint16_t i = 0; i < phnum; i++)
+		{
+			uint64_t ph = phoff + (uint64_t)phentsize * i;
+			if (Read<uint32_t>(data, size, ph) != PtLoad) continue;
+
+			uint32_t flags = Read<uint32_t>(data, size, ph + (is64 ? 4 : 24));
+			uint64_t offset = word(ph + (is64 ? 8 : 4));
+			uint64_t vaddr = word(ph + (is64 ? 16 : 8));
+			uint64_t filesz = word(ph + (is64 ? 32 : 16));
+			AddSection("LOAD" + std::to_string(i), vaddr - image_base, offset, filesz, (flags & PfX) != 0);
+		}
+		return true;
+	}
+}
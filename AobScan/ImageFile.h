@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#endif
+
+namespace AobScan
+{
+	/// <summary>
+	/// Read-only memory mapping of a whole file.
+	/// </summary>
+	class MappedFile
+	{
+	private:
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+#else
+		int fd = -1;
+#endif
+
+	public:
+		MappedFile() { }
+		MappedFile(MappedFile&) = delete;
+		~MappedFile() { Close(); }
+
+		bool Open(const char* path);
+		void Close();
+
+		const uint8_t* Data() const { return data; }
+		size_t Size() const { return size; }
+	};
+
+	/// <summary>
+	/// Section of an image file, with its bytes as stored on disk. Bytes past the end of the raw data (which
+	/// would be zero-filled in memory) are not included.
+	/// </summary>
+	struct ImageSection
+	{
+		std::string name;
+		uint64_t rva; // Address relative to the image base once loaded
+		const uint8_t* data;
+		size_t size;
+		bool executable;
+	};
+
+	/// <summary>
+	/// PE or ELF image mapped from disk, its sections being placed at their virtual addresses without loading it.
+	/// Only little-endian images are supported. ELF images without section headers use their loadable segments.
+	/// </summary>
+	class ImageFile
+	{
+	public:
+		enum class Format { Unknown, PE, ELF };
+
+	private:
+		MappedFile file;
+		Format format = Format::Unknown;
+		uint64_t image_base = 0;
+		std::vector<ImageSection> sections;
+
+		bool ParsePE(std::string& error);
+		bool ParseELF(std::string& error);
+		void AddSection(std::string name, uint64_t rva, uint64_t offset, uint64_t size, bool executable);
+
+	public:
+		/// <summary>
+		/// Map and parse an image file. On failure, error is set to a description of the problem.
+		/// </summary>
+		bool Open(const char* path, std::string& error);
+
+		Format GetFormat() const { return format; }
+		const char* FormatName() const;
+		uint64_t ImageBase() const { return image_base; }
+		const std::vector<ImageSection>& Sections() const { return sections; }
+	};
+}
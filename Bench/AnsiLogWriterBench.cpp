@@ -0,0 +1,127 @@
+// Benchmark of AnsiLogWriter writing to a pipe drained by another thread, compared to one write call per line.
+// Also checks that every line written reaches the pipe, or is reported as dropped. By default the writer may buffer
+// 256 MiB, so that no line is dropped; a small limit measures the cost of dropping lines the pipe cannot take.
+// Usage: AnsiLogWriterBench [lines] [max pending KiB]
+#include "AnsiLogWriter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace MCF;
+
+namespace
+{
+	void WriteAll(int fd, const char* data, size_t size)
+	{
+		while (size > 0)
+		{
+			ssize_t n = write(fd, data, size);
+			if (n <= 0) return;
+			data += n;
+			size -= n;
+		}
+	}
+
+	// Read a pipe until it is closed, counting the lines read and those reported as dropped
+	struct Drain
+	{
+		int fd;
+		uint64_t lines = 0;
+		uint64_t dropped = 0;
+		std::thread thread;
+
+		Drain(int fd) : fd(fd), thread([this] { Run(); }) { }
+
+		void Run()
+		{
+			static constexpr const char* DroppedText = " lines dropped";
+			std::string line;
+			char buf[1 << 16];
+			ssize_t n;
+			while ((n = read(fd, buf, sizeof(buf))) > 0)
+			{
+				for (ssize_t i = 0; i < n; i++)
+				{
+					if (buf[i] != '\n')
+					{
+						line.push_back(buf[i]);
+						continue;
+					}
+					size_t at = line.find(DroppedText);
+					if (at == std::string::npos) lines++;
+					else
+					{
+						// The count follows the time prefix
+						size_t start = line.rfind(' ', at - 1) + 1;
+						dropped += strtoull(line.c_str() + start, nullptr, 10);
+					}
+					line.clear();
+				}
+			}
+		}
+	};
+
+	double Run(bool batched, size_t lines, size_t max_pending, uint64_t& received, uint64_t& dropped)
+	{
+		int fds[2];
+		if (pipe(fds) != 0) return 0;
+		Drain drain(fds[0]);
+
+		auto start = std::chrono::steady_clock::now();
+		std::string msg;
+		if (batched)
+		{
+			AnsiLogWriter writer([&](const char* data, size_t size) { WriteAll(fds[1], data, size); },
+				1 << 16, std::chrono::milliseconds(16), max_pending);
+			for (size_t i = 0; i < lines; i++)
+			{
+				msg = "Entity " + std::to_string(i) + " moved to (12.5, 3.25, -7.0)";
+				writer.Write("debug", "Bench", msg.c_str(), 0x0A0A);
+			}
+			writer.Flush();
+		}
+		else
+		{
+			// The line rendering of AnsiLogWriter, written to the pipe as soon as it is rendered
+			for (size_t i = 0; i < lines; i++)
+			{
+				msg = "\x1b[0;92;40m[12:00:00] [\x1b[0;92;40mdebug\x1b[0;92;40m] [Bench] Entity " + std::to_string(i)
+					+ " moved to (12.5, 3.25, -7.0)\x1b[0m\n";
+				WriteAll(fds[1], msg.data(), msg.size());
+			}
+		}
+		close(fds[1]);
+		drain.thread.join();
+		close(fds[0]);
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		received = drain.lines;
+		dropped = drain.dropped;
+		return seconds;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t lines = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+	size_t max_pending = (argc > 2 ? strtoull(argv[2], nullptr, 10) : 1 << 18) << 10;
+
+	for (bool batched : { false, true })
+	{
+		uint64_t received, dropped;
+		double seconds = Run(batched, lines, max_pending, received, dropped);
+		printf("%-16s %6.0f k lines/s written, %6.0f k lines/s received, %llu dropped\n", batched ? "AnsiLogWriter" : "write per line",
+			lines / seconds / 1000, received / seconds / 1000, (unsigned long long)dropped);
+		if (received + dropped != lines)
+		{
+			printf("line count mismatch: %zu written\n", lines);
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,57 @@
+// Differential test of AobGramIndex queries against AobScanner, for every stride up to MaxStride, on a random buffer
+// with a small alphabet and patterns taken from it, with wildcards and altered bytes. Usage: AobGramIndexTest [queries] [seed]
+#include "AobGramIndex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+#include <vector>
+
+using namespace MCF;
+
+int main(int argc, char* argv[])
+{
+	long queries = argc > 1 ? atol(argv[1]) : 500;
+	std::mt19937_64 rng(argc > 2 ? strtoull(argv[2], nullptr, 0) : 1);
+
+	std::vector<uint8_t> buf(1 << 22);
+	for (auto& b : buf) b = (uint8_t)(rng() % 4 == 0 ? rng() : rng() % 8);
+
+	long tested = 0, queried = 0, found = 0;
+	for (uint32_t stride = 1; stride <= AobGramIndex::MaxStride; stride++)
+	{
+		AobGramIndex index(buf.data(), buf.size(), stride);
+		if (index.MemoryUsage() != AobGramIndex::MemoryFor(buf.size(), stride))
+		{
+			printf("stride %u: memory usage %zu does not match MemoryFor\n", stride, index.MemoryUsage());
+			return 1;
+		}
+
+		for (long q = 0; q < queries; q++)
+		{
+			size_t length = 4 + rng() % 40;
+			size_t pos = rng() % (buf.size() - length);
+			std::vector<uint8_t> bytes(buf.begin() + pos, buf.begin() + pos + length), masks(length, 0xFF);
+			for (size_t i = 0; i < length; i++) if (rng() % 6 == 0) masks[i] = rng() % 2 ? 0 : 0xF0;
+			if (q % 3 == 0) bytes[rng() % length] ^= 0x55; // Most likely not found
+			CompiledAob aob(bytes.data(), masks.data(), length);
+
+			tested++;
+			if (!index.CanQuery(aob)) continue;
+			queried++;
+
+			const uint8_t* expected = AobScanner::Find(aob, buf.data(), buf.data() + buf.size());
+			const uint8_t* result = index.FindFirst(aob);
+			if (result != expected)
+			{
+				printf("stride %u, query %ld: found offset %td, expected %td\n", stride, q,
+					result ? result - buf.data() : -1, expected ? expected - buf.data() : -1);
+				return 1;
+			}
+			if (result) found++;
+		}
+		printf("stride %2u: %zu bytes\n", stride, index.MemoryUsage());
+	}
+	printf("%ld of %ld patterns queryable, %ld found, all match AobScanner\n", queried, tested, found);
+	return 0;
+}
@@ -0,0 +1,143 @@
+// Scaling of single-pass multi-pattern scanning with AobMultiScanner from 1 to 2000 patterns, compared to one
+// AobScanner pass per pattern. Results of FindFirst and FindNext are first checked against AobScanner on random buffers.
+// Usage: AobMultiScanBench [file with machine code, default: this executable] [buffer size in MB]
+#include "AobMultiScanner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+using namespace MCF;
+
+namespace
+{
+	double Ms(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::vector<const CompiledAob*> Pointers(const std::vector<CompiledAob>& aobs)
+	{
+		std::vector<const CompiledAob*> ptrs;
+		for (const auto& aob : aobs) ptrs.push_back(&aob);
+		return ptrs;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::ifstream file(argc > 1 ? argv[1] : "/proc/self/exe", std::ios::binary);
+	std::vector<uint8_t> code((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (code.size() < 1 << 16)
+	{
+		printf("could not read enough machine code\n");
+		return 1;
+	}
+	size_t size = (argc > 2 ? strtoull(argv[2], nullptr, 0) : 64) << 20;
+	std::mt19937_64 rng(7);
+
+	// Correctness on small buffers with a small alphabet, where fragments and partial matches are frequent
+	for (int trial = 0; trial < 300; trial++)
+	{
+		std::vector<uint8_t> buf(20000);
+		for (auto& b : buf) b = (uint8_t)(rng() % 5 == 0 ? rng() : rng() % 3);
+
+		size_t count = 1 + rng() % 200;
+		std::vector<CompiledAob> aobs;
+		for (size_t k = 0; k < count; k++)
+		{
+			size_t length = 1 + rng() % 24;
+			size_t src = rng() % (buf.size() - length);
+			std::vector<uint8_t> bytes(length), masks(length);
+			for (size_t i = 0; i < length; i++)
+			{
+				int r = rng() % 6;
+				masks[i] = r < 3 ? 0xFF : r == 3 ? 0xF0 : r == 4 ? 0x0F : 0;
+				bytes[i] = rng() % 4 ? buf[src + i] : (uint8_t)rng();
+			}
+			aobs.emplace_back(bytes.data(), masks.data(), length);
+		}
+
+		auto ptrs = Pointers(aobs);
+		AobMultiScanner scanner(ptrs.data(), ptrs.size());
+		std::vector<const uint8_t*> results(count, nullptr);
+		const uint8_t* begin = buf.data() + rng() % 100;
+		scanner.FindFirst(begin, buf.data() + buf.size(), results.data());
+
+		for (size_t k = 0; k < count; k++)
+		{
+			if (results[k] != AobScanner::Find(aobs[k], begin, buf.data() + buf.size()))
+			{
+				printf("mismatch in trial %d, pattern %zu\n", trial, k);
+				return 1;
+			}
+		}
+
+		// Next occurences from a different position for each pattern
+		std::vector<const uint8_t*> from(count);
+		for (auto& f : from) f = begin + rng() % (buf.data() + buf.size() - begin);
+		std::fill(results.begin(), results.end(), nullptr);
+		scanner.FindNext(begin, buf.data() + buf.size(), from.data(), results.data());
+
+		for (size_t k = 0; k < count; k++)
+		{
+			if (results[k] != AobScanner::Find(aobs[k], from[k], buf.data() + buf.size()))
+			{
+				printf("FindNext mismatch in trial %d, pattern %zu\n", trial, k);
+				return 1;
+			}
+		}
+	}
+	printf("results match AobScanner\n");
+
+	// Scan buffer made of random pieces of the code
+	std::vector<uint8_t> buf(size);
+	for (size_t i = 0; i < buf.size(); i += 4096)
+	{
+		size_t n = (std::min)((size_t)4096, buf.size() - i);
+		memcpy(&buf[i], &code[rng() % (code.size() - 4096)], n);
+	}
+
+	printf("%zu MB buffer\n", size >> 20);
+	for (size_t count : { 1, 10, 100, 500, 1000, 2000 })
+	{
+		// Signatures taken from the code with some wildcards, and one byte changed so that most are not found
+		std::vector<CompiledAob> aobs;
+		for (size_t k = 0; k < count; k++)
+		{
+			size_t length = 12 + rng() % 20;
+			size_t src = rng() % (code.size() - length);
+			std::vector<uint8_t> bytes(code.begin() + src, code.begin() + src + length), masks(length, 0xFF);
+			for (size_t i = 0; i < length; i++) if (rng() % 5 == 0) masks[i] = 0;
+			bytes[length / 2] ^= 0x5A;
+			masks[length / 2] = 0xFF;
+			aobs.emplace_back(bytes.data(), masks.data(), length);
+		}
+		auto ptrs = Pointers(aobs);
+
+		auto start = std::chrono::steady_clock::now();
+		AobMultiScanner scanner(ptrs.data(), ptrs.size());
+		double build_ms = Ms(start);
+
+		std::vector<const uint8_t*> results(count, nullptr);
+		start = std::chrono::steady_clock::now();
+		size_t found = scanner.FindFirst(buf.data(), buf.data() + buf.size(), results.data());
+		double scan_ms = Ms(start);
+
+		// One pass per pattern, extrapolated from the first 100 patterns
+		size_t sampled = (std::min)(count, (size_t)100);
+		start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < sampled; k++) AobScanner::Find(aobs[k], buf.data(), buf.data() + buf.size());
+		double single_ms = Ms(start) * count / sampled;
+
+		printf("%5zu patterns: %6zu states, build %7.1f ms, scan %7.1f ms (%zu found), one pass per pattern %9.1f ms\n",
+			count, scanner.NumStates(), build_ms, scan_ms, found, single_ms);
+	}
+	return 0;
+}
@@ -0,0 +1,79 @@
+// Throughput of the AobScanner kernels over synthetic buffers with a byte distribution resembling x86 code.
+// Usage: AobScannerBench [pattern] [sizes in MB...]
+#include "AobScanner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace MCF;
+
+namespace
+{
+	int HexDigit(char c)
+	{
+		if (c >= '0' && c <= '9') return c - '0';
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		return -1;
+	}
+
+	// Parse a pattern such as "48 8B ?? ?5", where ? is a wildcard nibble
+	bool ParsePattern(const char* str, std::vector<uint8_t>& bytes, std::vector<uint8_t>& masks)
+	{
+		for (const char* p = str; *p; )
+		{
+			if (*p == ' ') { p++; continue; }
+			if (!p[1]) return false;
+
+			int hi = HexDigit(p[0]), lo = HexDigit(p[1]);
+			if ((hi < 0 && p[0] != '?') || (lo < 0 && p[1] != '?')) return false;
+			bytes.push_back((uint8_t)((hi < 0 ? 0 : hi << 4) | (lo < 0 ? 0 : lo)));
+			masks.push_back((uint8_t)((hi < 0 ? 0 : 0xF0) | (lo < 0 ? 0 : 0x0F)));
+			p += 2;
+		}
+		return !bytes.empty();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* pattern = argc > 1 ? argv[1] : "48 8B 05 ?? ?? ?? ?? 48 85 C0 74 ?? 8B";
+	std::vector<size_t> sizes_mb;
+	for (int i = 2; i < argc; i++) sizes_mb.push_back(strtoull(argv[i], nullptr, 0));
+	if (sizes_mb.empty()) sizes_mb = { 64, 256, 1024 };
+
+	std::vector<uint8_t> bytes, masks;
+	if (!ParsePattern(pattern, bytes, masks))
+	{
+		printf("invalid pattern \"%s\"\n", pattern);
+		return 1;
+	}
+	CompiledAob aob(bytes.data(), masks.data(), bytes.size());
+
+	static constexpr const char* kernel_names[] = { "scalar", "SSE4.2", "AVX2" };
+	AobScanner::Kernel best = AobScanner::BestKernel();
+
+	for (size_t mb : sizes_mb)
+	{
+		// Mostly zeroes and common opcode bytes, so that the anchors of the pattern match often
+		std::vector<uint8_t> buf(mb << 20);
+		std::mt19937 rng(1);
+		for (auto& b : buf)
+		{
+			uint32_t v = rng() % 100;
+			b = v < 30 ? 0 : v < 45 ? 0x48 : v < 55 ? 0x8B : v < 60 ? 0xFF : (uint8_t)rng();
+		}
+
+		for (int k = 0; k <= (int)best; k++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			const uint8_t* match = AobScanner::Find(aob, buf.data(), buf.data() + buf.size(), (AobScanner::Kernel)k);
+			double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			printf("%5zu MB %-7s %8.1f ms %6.2f GB/s %s\n", mb, kernel_names[k], s * 1e3, buf.size() / s / 1e9, match ? "found" : "not found");
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,72 @@
+// Differential fuzzer of the AobScanner kernels against a reference matcher, on random buffers and patterns mixing
+// full masks, nibble masks and wildcards. Usage: AobScannerFuzz [iterations] [seed]
+#include "AobScanner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+#include <vector>
+
+using namespace MCF;
+
+namespace
+{
+	const uint8_t* ReferenceFind(const uint8_t* begin, const uint8_t* end, const uint8_t* bytes, const uint8_t* masks, size_t length)
+	{
+		if ((size_t)(end - begin) < length) return nullptr;
+		for (const uint8_t* p = begin; p + length <= end; p++)
+		{
+			size_t i = 0;
+			while (i < length && (p[i] & masks[i]) == (bytes[i] & masks[i])) i++;
+			if (i == length) return p;
+		}
+		return nullptr;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	long iterations = argc > 1 ? atol(argv[1]) : 200000;
+	std::mt19937_64 rng(argc > 2 ? strtoull(argv[2], nullptr, 0) : 42);
+
+	AobScanner::Kernel best = AobScanner::BestKernel();
+	printf("best kernel: %s\n", best == AobScanner::Kernel::AVX2 ? "AVX2" : best == AobScanner::Kernel::SSE42 ? "SSE4.2" : "scalar");
+
+	std::vector<uint8_t> buf(1 << 16);
+	long found = 0;
+	for (long it = 0; it < iterations; it++)
+	{
+		// Small alphabets make partial matches, and thus candidate verification, frequent
+		size_t size = rng() % (it % 10 == 0 ? 4096 : 300);
+		for (size_t i = 0; i < size; i++) buf[i] = rng() % 4 == 0 ? (uint8_t)rng() : (uint8_t)(rng() % 4);
+
+		size_t length = 1 + rng() % 70;
+		std::vector<uint8_t> bytes(length), masks(length);
+		size_t src = size > length ? rng() % (size - length + 1) : 0;
+		for (size_t i = 0; i < length; i++)
+		{
+			int r = rng() % 6;
+			masks[i] = r < 3 ? 0xFF : r == 3 ? 0xF0 : r == 4 ? 0x0F : 0;
+			bytes[i] = (size >= length && (it % 2 || rng() % 3)) ? buf[src + i] : (uint8_t)rng();
+		}
+		CompiledAob aob(bytes.data(), masks.data(), length);
+
+		const uint8_t* begin = buf.data() + (size ? rng() % (size / 4 + 1) : 0);
+		const uint8_t* end = buf.data() + size;
+		const uint8_t* expected = ReferenceFind(begin, end, bytes.data(), masks.data(), length);
+
+		for (int k = 0; k <= (int)best; k++)
+		{
+			const uint8_t* got = AobScanner::Find(aob, begin, end, (AobScanner::Kernel)k);
+			if (got != expected)
+			{
+				printf("mismatch at iteration %ld: kernel %d, pattern length %zu, buffer size %zu\n", it, k, length, size);
+				return 1;
+			}
+		}
+		found += expected != nullptr;
+	}
+
+	printf("%ld iterations, %ld patterns found\n", iterations, found);
+	return 0;
+}
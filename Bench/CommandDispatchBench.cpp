@@ -0,0 +1,139 @@
+// Benchmark of command dispatch: tokenizing and looking up command strings one at a time, compared to a 
+// straightforward implementation allocating strings, and running the same commands from a parsed CommandScript.
+#include "CommandTokenizer.h"
+#include "CommandTrie.h"
+#include "CommandScript.h"
+#include "ThreadPool.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+using namespace MCF;
+
+namespace
+{
+	class CountCommand : public CommandBase
+	{
+	public:
+		std::string name;
+		uint64_t calls = 0;
+		uint64_t arg_bytes = 0;
+
+		CountCommand(std::string name) : name(std::move(name)) { }
+
+		virtual void Run(const char* args[], size_t count) override
+		{
+			calls++;
+			for (size_t i = 0; i < count; i++) arg_bytes += strlen(args[i]);
+		}
+		virtual const char* Name() const override { return name.c_str(); }
+		virtual const char* HelpMessage() const override { return ""; }
+	};
+
+	double Seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int main()
+{
+	constexpr size_t NumCommands = 1000;
+	constexpr size_t NumCalls = 1'000'000;
+
+	std::vector<std::unique_ptr<CountCommand>> commands;
+	CommandTrie<CountCommand> trie;
+	std::unordered_map<std::string, CountCommand*> map;
+	for (size_t i = 0; i < NumCommands; i++)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%s_%zu", i % 3 == 0 ? "aob" : i % 3 == 1 ? "log" : "mod", i);
+		commands.push_back(std::make_unique<CountCommand>(name));
+		trie.Insert(name, commands.back().get());
+		map[name] = commands.back().get();
+	}
+
+	std::vector<std::string> lines;
+	for (size_t i = 0; i < 64; i++)
+	{
+		const std::string& name = commands[(i * 389) % NumCommands]->name;
+		switch (i % 4)
+		{
+		case 0: lines.push_back(name); break;
+		case 1: lines.push_back(name + " 0x1400 12 true"); break;
+		case 2: lines.push_back(name + " \"quoted argument\" 'x y'"); break;
+		case 3: lines.push_back("  " + name + "   a b c d e f  "); break;
+		}
+	}
+
+	// Tokenizer and trie, as in CommandManImp::Execute
+	auto start = std::chrono::steady_clock::now();
+	CommandTokenizer tok;
+	for (size_t i = 0; i < NumCalls; i++)
+	{
+		if (!tok.Tokenize(lines[i % lines.size()])) return 1;
+		CountCommand* cmd = trie.Find(tok.Tokens()[0]);
+		if (cmd == nullptr) return 1;
+		cmd->Run(tok.Tokens() + 1, tok.Count() - 1);
+	}
+	double trie_s = Seconds(start);
+	uint64_t trie_bytes = 0;
+	for (auto& cmd : commands) trie_bytes += cmd->arg_bytes, cmd->arg_bytes = 0;
+
+	// Reference implementation splitting into strings (without quote support) and looking up a hash map
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < NumCalls; i++)
+	{
+		std::istringstream stream(lines[i % lines.size()]);
+		std::vector<std::string> tokens;
+		for (std::string token; stream >> token; ) tokens.push_back(token);
+
+		auto it = map.find(tokens[0]);
+		if (it == map.end()) return 1;
+		std::vector<const char*> args;
+		for (size_t t = 1; t < tokens.size(); t++) args.push_back(tokens[t].c_str());
+		it->second->Run(args.data(), args.size());
+	}
+	double naive_s = Seconds(start);
+
+	// The same commands run by a script, tokenized once when parsed
+	std::string text = "repeat " + std::to_string(NumCalls / lines.size()) + " i\n";
+	for (const auto& line : lines) text += line + "\n";
+	text += "end\n";
+
+	CommandScript script;
+	std::string error;
+	auto resolve = [&](const char* name) -> CommandBase* { return trie.Find(name); };
+	if (!script.Parse(text, resolve, error))
+	{
+		printf("parse error: %s\n", error.c_str());
+		return 1;
+	}
+
+	for (auto& cmd : commands) cmd->arg_bytes = 0;
+	ThreadPool pool(1);
+	start = std::chrono::steady_clock::now();
+	script.Run(pool, nullptr);
+	double script_s = Seconds(start);
+	uint64_t script_bytes = 0;
+	for (auto& cmd : commands) script_bytes += cmd->arg_bytes;
+
+	if (script_bytes != trie_bytes)
+	{
+		printf("argument mismatch between direct and scripted dispatch: %llu != %llu\n",
+			(unsigned long long)trie_bytes, (unsigned long long)script_bytes);
+		return 1;
+	}
+
+	printf("%zu commands registered, %zu calls\n", NumCommands, NumCalls);
+	printf("tokenizer + trie:         %6.1f ns/command\n", trie_s * 1e9 / NumCalls);
+	printf("istringstream + hash map: %6.1f ns/command\n", naive_s * 1e9 / NumCalls);
+	printf("parsed script:            %6.1f ns/command\n", script_s * 1e9 / NumCalls);
+	return 0;
+}
@@ -0,0 +1,60 @@
+// Test of the ELF symbol reading: the functions of the test binary and of libc are found at their address, with their
+// size.
+// Usage: ElfSymbolsTest
+#include "ElfSymbols.h"
+#include "ModuleEnumerator.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <vector>
+
+using namespace MCF;
+
+extern "C" __attribute__((noinline)) int ElfSymbolsTestFunction(int x)
+{
+	return x * 7 + 1;
+}
+
+namespace
+{
+	// Find the symbol of a function among those of the module containing it
+	bool CheckFunction(const std::vector<ModuleEnumerator::ModuleEntry>& entries, const char* what, uintptr_t address)
+	{
+		for (const auto& entry : entries)
+		{
+			if (address < entry.info.base || address - entry.info.base >= entry.info.size) continue;
+
+			std::vector<ElfSymbols::Symbol> symbols = ElfSymbols::Functions(entry.info.base);
+			for (const auto& symbol : symbols)
+			{
+				if (symbol.begin != address) continue;
+				if (symbol.size == 0 || symbol.size > 1 << 16)
+				{
+					printf("%s: unexpected size %zu\n", what, symbol.size);
+					return false;
+				}
+				printf("%s found among %zu symbols of %s, %zu bytes\n", what, symbols.size(), entry.info.name, symbol.size);
+				return true;
+			}
+			printf("%s at %p not found among %zu symbols of %s\n", what, (void*)address, symbols.size(), entry.info.name);
+			return false;
+		}
+		printf("%s at %p is in no module\n", what, (void*)address);
+		return false;
+	}
+}
+
+int main()
+{
+	std::vector<ModuleEnumerator::ModuleEntry> entries = ModuleEnumerator::Enumerate();
+	if (!CheckFunction(entries, "ElfSymbolsTestFunction", (uintptr_t)&ElfSymbolsTestFunction)
+		|| !CheckFunction(entries, "printf", (uintptr_t)dlsym(RTLD_DEFAULT, "printf"))) return 1;
+
+	if (!ElfSymbols::Functions(1).empty())
+	{
+		printf("symbols found for an unknown module\n");
+		return 1;
+	}
+	printf("symbols match\n");
+	return ElfSymbolsTestFunction(0) == 1 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// Smoke test of the module enumeration: the main module comes first and contains the code and data of the test, libc
+// is found, the flags of the segments match their name and the modules do not overlap.
+// Usage: ModuleEnumTest
+#include "ModuleEnumerator.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+using namespace MCF;
+using ModuleEntry = ModuleEnumerator::ModuleEntry;
+using SectionInfo = ModuleTypes::SectionInfo;
+using enum ModuleTypes::SectionFlags;
+
+namespace
+{
+	int test_data = 1;
+
+	__attribute__((noinline)) int TestFunction(int x) { return x * 3 + test_data; }
+
+	const ModuleEntry* ModuleOf(const std::vector<ModuleEntry>& entries, uintptr_t address)
+	{
+		for (const auto& entry : entries)
+			if (address >= entry.info.base && address - entry.info.base < entry.info.size) return &entry;
+		return nullptr;
+	}
+
+	const SectionInfo* SectionOf(const ModuleEntry& entry, uintptr_t address)
+	{
+		for (const auto& section : entry.sections)
+			if (address >= section.begin && address - section.begin < section.size) return &section;
+		return nullptr;
+	}
+
+	bool CheckAddress(const std::vector<ModuleEntry>& entries, const char* what, uintptr_t address, uint32_t flags)
+	{
+		const ModuleEntry* entry = ModuleOf(entries, address);
+		const SectionInfo* section = entry ? SectionOf(*entry, address) : nullptr;
+		if (!section || (section->flags & flags) != flags)
+		{
+			printf("%s at %p is not in a section with flags %u\n", what, (void*)address, flags);
+			return false;
+		}
+		printf("%s is in %s, section %s\n", what, entry->info.name, section->name);
+		return true;
+	}
+}
+
+int main()
+{
+	std::vector<ModuleEntry> entries = ModuleEnumerator::Enumerate();
+	if (entries.empty())
+	{
+		printf("no module enumerated\n");
+		return 1;
+	}
+	printf("%zu modules, main module %s\n", entries.size(), entries[0].info.name);
+
+	if (ModuleOf(entries, (uintptr_t)&TestFunction) != &entries[0] || ModuleOf(entries, (uintptr_t)&test_data) != &entries[0])
+	{
+		printf("the test is not in the first module\n");
+		return 1;
+	}
+	if (!CheckAddress(entries, "TestFunction", (uintptr_t)&TestFunction, SectionRead | SectionExecute)
+		|| !CheckAddress(entries, "test_data", (uintptr_t)&test_data, SectionRead | SectionWrite)) return 1;
+
+	const ModuleEntry* libc = ModuleOf(entries, (uintptr_t)dlsym(RTLD_DEFAULT, "printf"));
+	if (!libc || strncmp(libc->info.name, "libc", 4) != 0)
+	{
+		printf("printf is not in libc\n");
+		return 1;
+	}
+
+	std::vector<std::pair<uintptr_t, uintptr_t>> ranges;
+	for (const auto& entry : entries)
+	{
+		if (entry.info.num_sections != entry.sections.size())
+		{
+			printf("%s: %u sections, %zu read\n", entry.info.name, entry.info.num_sections, entry.sections.size());
+			return 1;
+		}
+		for (const auto& section : entry.sections)
+		{
+			bool r = section.flags & SectionRead, w = section.flags & SectionWrite, x = section.flags & SectionExecute;
+			if (section.module_base != entry.info.base || section.begin < entry.info.base
+				|| section.begin + section.size > entry.info.base + entry.info.size
+				|| section.name[0] != (r ? 'r' : '-') || section.name[1] != (w ? 'w' : '-') || section.name[2] != (x ? 'x' : '-'))
+			{
+				printf("%s: section %s at %p does not match its module\n", entry.info.name, section.name, (void*)section.begin);
+				return 1;
+			}
+		}
+		ranges.push_back({ entry.info.base, entry.info.base + entry.info.size });
+	}
+	std::sort(ranges.begin(), ranges.end());
+	for (size_t i = 1; i < ranges.size(); i++)
+	{
+		if (ranges[i].first < ranges[i - 1].second)
+		{
+			printf("modules overlap at %p\n", (void*)ranges[i].first);
+			return 1;
+		}
+	}
+	printf("modules match\n");
+	return TestFunction(0) == 1 ? 0 : 1;
+}
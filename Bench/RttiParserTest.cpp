@@ -0,0 +1,100 @@
+// Test of the RTTI parser on the test binary: the vtables of its polymorphic classes are found at the address stored in
+// their objects, with the offset of their subobject, and their class name is read back from the vtable.
+// Usage: RttiParserTest
+#include "RttiParser.h"
+#include "ModuleEnumerator.h"
+
+#include <stdio.h>
+#include <vector>
+
+using namespace MCF;
+
+namespace RttiTest
+{
+	struct Base
+	{
+		virtual ~Base() = default;
+		virtual int Value() const { return 1; }
+	};
+
+	struct Derived : Base
+	{
+		int Value() const override { return 2; }
+		virtual int Extra() const { return 3; }
+	};
+
+	struct Other
+	{
+		virtual ~Other() = default;
+		virtual int OtherValue() const { return 4; }
+		long padding = 0;
+	};
+
+	struct Multi : Derived, Other
+	{
+		int Value() const override { return 5; }
+		int OtherValue() const override { return 6; }
+	};
+}
+
+namespace
+{
+	using SectionInfo = ModuleTypes::SectionInfo;
+
+	// Check that the vtable stored at the start of an object, or of one of its subobjects, was found
+	bool CheckVTable(const std::vector<RttiParser::VTable>& vtables, const std::vector<SectionInfo>& sections,
+		const char* name, const void* subobject, int32_t offset, uint32_t min_methods)
+	{
+		uintptr_t address = (uintptr_t)*(void* const*)subobject;
+		for (const auto& vtable : vtables)
+		{
+			if (vtable.address != address) continue;
+
+			std::string mangled;
+			if (RttiParser::Demangle(vtable.mangled) != name || vtable.offset != offset || vtable.num_methods < min_methods
+				|| !RttiParser::MangledName(address, sections, mangled) || mangled != vtable.mangled)
+			{
+				printf("%s: vtable at %p is %s, offset %d, %u methods\n", name, (void*)address, vtable.mangled.c_str(),
+					vtable.offset, vtable.num_methods);
+				return false;
+			}
+			printf("%s: vtable at %p, offset %d, %u methods\n", name, (void*)address, vtable.offset, vtable.num_methods);
+			return true;
+		}
+		printf("%s: vtable at %p not found\n", name, (void*)address);
+		return false;
+	}
+}
+
+int main()
+{
+	std::vector<ModuleEnumerator::ModuleEntry> entries = ModuleEnumerator::Enumerate();
+	if (entries.empty()) return 1;
+	const std::vector<SectionInfo>& sections = entries[0].sections;
+
+	ThreadPool pool;
+	std::vector<RttiParser::VTable> vtables = RttiParser::Parse(sections, pool, [&](uintptr_t address) {
+		for (const auto& section : sections)
+			if ((section.flags & ModuleTypes::SectionExecute) && address - section.begin < section.size) return true;
+		return false;
+	});
+	printf("%zu vtables in %s\n", vtables.size(), entries[0].info.name);
+
+	RttiTest::Base base;
+	RttiTest::Derived derived;
+	RttiTest::Multi multi;
+	const RttiTest::Other* other = &multi;
+	if (!CheckVTable(vtables, sections, "RttiTest::Base", &base, 0, 3)
+		|| !CheckVTable(vtables, sections, "RttiTest::Derived", &derived, 0, 4)
+		|| !CheckVTable(vtables, sections, "RttiTest::Multi", &multi, 0, 4)
+		|| !CheckVTable(vtables, sections, "RttiTest::Multi", other, (int32_t)((uintptr_t)other - (uintptr_t)&multi), 3))
+		return 1;
+
+	if (RttiParser::Demangle("N8RttiTest7DerivedE") != "RttiTest::Derived")
+	{
+		printf("demangling failed\n");
+		return 1;
+	}
+	printf("vtables match\n");
+	return base.Value() + derived.Value() + other->OtherValue() == 9 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// Test of the value scanner: the ValueCompare kernels against the scalar comparison, then first and next scans of a
+// synthetic heap, mutated between scans, against a reference which compares every candidate.
+// Usage: ValueScanTest [heap MB] [seed]
+#include "ValueScan.h"
+#include "ValueCompare.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace MCF;
+using ValueType = ValueScanTypes::ValueType;
+using ScanCompare = ValueScanTypes::ScanCompare;
+using ScanValue = ValueScanTypes::ScanValue;
+
+namespace
+{
+	constexpr ScanCompare next_compares[] = { ScanCompare::Exact, ScanCompare::Range, ScanCompare::Changed,
+		ScanCompare::Unchanged, ScanCompare::Increased, ScanCompare::Decreased };
+
+	bool IsFloat(ValueType type) { return type == ValueType::F32 || type == ValueType::F64; }
+
+	// Store a small value, so that comparisons match often
+	void StoreSmall(ValueType type, uint8_t* p, int v)
+	{
+		switch (type)
+		{
+		case ValueType::I8: { int8_t x = (int8_t)v; memcpy(p, &x, 1); break; }
+		case ValueType::I16: { int16_t x = (int16_t)v; memcpy(p, &x, 2); break; }
+		case ValueType::I32: { int32_t x = v; memcpy(p, &x, 4); break; }
+		case ValueType::I64: { int64_t x = v; memcpy(p, &x, 8); break; }
+		case ValueType::F32: { float x = v == 3 ? NAN : (float)v; memcpy(p, &x, 4); break; }
+		default: { double x = v == 3 ? NAN : (double)v; memcpy(p, &x, 8); break; }
+		}
+	}
+
+	void Operands(ValueType type, std::mt19937_64& rng, ScanValue& a, ScanValue& b)
+	{
+		int lo = (int)(rng() % 5) - 2, hi = lo + (int)(rng() % 3);
+		a = IsFloat(type) ? ScanValue::Float(lo) : ScanValue::Int(lo);
+		b = IsFloat(type) ? ScanValue::Float(hi) : ScanValue::Int(hi);
+	}
+
+	bool TestKernels(std::mt19937_64& rng)
+	{
+		for (int t = 0; t < 6; t++)
+		{
+			for (int c = 0; c < 7; c++)
+			{
+				for (size_t count : { 1, 63, 64, 200, 1000 })
+				{
+					ValueType type = (ValueType)t;
+					size_t size = ValueCompare::SizeOf(type);
+					std::vector<uint8_t> values(count * size), previous(count * size);
+					for (size_t i = 0; i < count; i++)
+					{
+						StoreSmall(type, &values[i * size], (int)(rng() % 6) - 2);
+						if (rng() % 2) memcpy(&previous[i * size], &values[i * size], size);
+						else StoreSmall(type, &previous[i * size], (int)(rng() % 6) - 2);
+					}
+					ScanValue a, b;
+					Operands(type, rng, a, b);
+
+					std::vector<uint64_t> expected((count + 63) / 64), got((count + 63) / 64);
+					size_t expected_count = 0;
+					for (size_t i = 0; i < count; i++)
+					{
+						if (ValueCompare::Compare(type, (ScanCompare)c, &values[i * size], &previous[i * size], a, b))
+						{
+							expected[i / 64] |= 1ull << (i % 64);
+							expected_count++;
+						}
+					}
+
+					for (int k = 0; k <= (int)AobScanner::BestKernel(); k++)
+					{
+						std::fill(got.begin(), got.end(), 0);
+						size_t got_count = ValueCompare::CompareArray(type, (ScanCompare)c, values.data(), previous.data(), count, size,
+							a, b, got.data(), (AobScanner::Kernel)k);
+						if (got_count != expected_count || got != expected)
+						{
+							printf("kernel mismatch: kernel %d, type %d, compare %d, count %zu\n", k, t, c, count);
+							return false;
+						}
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	bool TestHeap(std::vector<uint8_t>& heap, ValueType type, size_t alignment, std::mt19937_64& rng, ThreadPool& pool)
+	{
+		size_t size = ValueCompare::SizeOf(type);
+		for (size_t i = 0; i + size <= heap.size(); i += size) StoreSmall(type, &heap[i], (int)(rng() % 6) - 2);
+
+		// A few regions, one of which is smaller than a value
+		std::vector<MemoryRegions::Region> regions;
+		uintptr_t base = (uintptr_t)heap.data();
+		size_t third = heap.size() / 3;
+		regions.push_back({ base + 1, third - 1 });
+		regions.push_back({ base + third + 7, size - 1 });
+		regions.push_back({ base + 2 * third, heap.size() - 2 * third });
+
+		// Reference candidates, and their value at the last scan
+		std::vector<uintptr_t> expected;
+		std::vector<uint8_t> previous;
+		auto Collect = [&](ScanCompare compare, const ScanValue& a, const ScanValue& b, bool first) {
+			std::vector<uintptr_t> kept;
+			std::vector<uint8_t> values;
+			auto Check = [&](uintptr_t address, const uint8_t* prev) {
+				if (ValueCompare::Compare(type, compare, (const uint8_t*)address, prev, a, b))
+				{
+					kept.push_back(address);
+					values.insert(values.end(), (const uint8_t*)address, (const uint8_t*)address + size);
+				}
+			};
+			if (first)
+			{
+				for (const auto& region : regions)
+				{
+					uintptr_t begin = (region.begin + alignment - 1) & ~(uintptr_t)(alignment - 1);
+					for (uintptr_t p = begin; p + size <= region.begin + region.size; p += alignment) Check(p, nullptr);
+				}
+			}
+			else for (size_t i = 0; i < expected.size(); i++) Check(expected[i], &previous[i * size]);
+			expected = std::move(kept);
+			previous = std::move(values);
+		};
+
+		ValueScan scan(type, alignment);
+		std::vector<uintptr_t> got;
+		for (int round = 0; round < 8; round++)
+		{
+			ScanValue a, b;
+			Operands(type, rng, a, b);
+			ScanCompare compare = round == 0 ? (rng() % 2 ? ScanCompare::Unknown : ScanCompare::Range)
+				: next_compares[rng() % std::size(next_compares)];
+
+			auto start = std::chrono::steady_clock::now();
+			if (round == 0) scan.First(regions, compare, a, b, pool);
+			else scan.Next(compare, a, b, pool);
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			Collect(compare, a, b, round == 0);
+
+			got.assign(scan.count + 1, 0);
+			got.resize(scan.Results(got.data(), got.size(), 0));
+			if (scan.count != expected.size() || got != expected)
+			{
+				printf("scan mismatch: type %d, alignment %zu, round %d, compare %d: %zu candidates, expected %zu\n",
+					(int)type, alignment, round, (int)compare, scan.count, expected.size());
+				return false;
+			}
+			printf("type %d, alignment %zu, compare %d: %zu candidates in %.1f ms\n", (int)type, alignment, (int)compare, scan.count, ms);
+
+			// Change a shrinking fraction of the values, so that later scans see both dense and sparse blocks
+			size_t changes = heap.size() / size >> (round + 2);
+			for (size_t i = 0; i < changes; i++)
+			{
+				size_t at = rng() % (heap.size() / size) * size;
+				StoreSmall(type, &heap[at], (int)(rng() % 6) - 2);
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t heap_mb = argc > 1 ? strtoull(argv[1], nullptr, 10) : 16;
+	std::mt19937_64 rng(argc > 2 ? strtoull(argv[2], nullptr, 0) : 42);
+
+	if (!TestKernels(rng)) return 1;
+	printf("kernels match\n");
+
+	ThreadPool pool;
+	std::vector<uint8_t> heap(heap_mb << 20);
+	for (int t = 0; t < 6; t++)
+	{
+		ValueType type = (ValueType)t;
+		if (!TestHeap(heap, type, ValueCompare::SizeOf(type), rng, pool) || !TestHeap(heap, type, 1, rng, pool)) return 1;
+	}
+	printf("scans match\n");
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include "AnsiLogWriter.h"
+#include <string.h>
+
+namespace MCF
+{
+	AnsiLogWriter::AnsiLogWriter(Sink sink, size_t flush_threshold, std::chrono::milliseconds flush_interval, size_t max_pending) :
+		sink(sink), flush_threshold(flush_threshold), max_pending(max_pending), flush_interval(flush_interval)
+	{
+		// Console attributes store blue in bit 0 and red in bit 2, while ANSI colors are the other way around
+		auto ansi = [](int c) { return ((c & 1) << 2) | (c & 2) | ((c & 4) >> 2); };
+		for (int attr = 0; attr < 256; attr++)
+		{
+			int fg = attr & 0xF, bg = attr >> 4;
+			sgr[attr] = "\x1b[0;" + std::to_string((fg & 8 ? 90 : 30) + ansi(fg)) + ";"
+				+ std::to_string((bg & 8 ? 100 : 40) + ansi(bg)) + "m";
+		}
+
+		front.reserve(flush_threshold * 2);
+		back.reserve(flush_threshold * 2);
+		flush_thread = std::thread(&AnsiLogWriter::FlushLoop, this);
+	}
+
+	AnsiLogWriter::~AnsiLogWriter()
+	{
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			stop = true;
+		}
+		cv.notify_one();
+		flush_thread.join();
+		Flush();
+	}
+
+	void AnsiLogWriter::UpdateTimePrefix(time_t now)
+	{
+		struct tm tm;
+#ifdef _WIN32
+		localtime_s(&tm, &now);
+#else
+		localtime_r(&now, &tm);
+#endif
+		time_prefix_len = strftime(time_prefix, sizeof(time_prefix), "[%H:%M:%S] ", &tm);
+		cached_second = now;
+	}
+
+	void AnsiLogWriter::Write(const char* sev, const char* source, const char* msg, uint16_t color)
+	{
+		time_t now = time(nullptr);
+		const std::string& line_sgr = sgr[color & 0xFF];
+		const std::string& sev_sgr = sgr[color >> 8];
+
+		bool wake;
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			if (front.size() >= max_pending)
+			{
+				dropped++;
+				unreported++;
+				return;
+			}
+			if (now != cached_second) UpdateTimePrefix(now);
+			ReportDropped();
+
+			front.append(line_sgr);
+			front.append(time_prefix, time_prefix_len);
+			front.push_back('[');
+			front.append(sev_sgr);
+			front.append(sev);
+			front.append(line_sgr);
+			front.append("] [");
+			front.append(source);
+			front.append("] ");
+			front.append(msg);
+			front.append("\x1b[0m\n");
+
+			wake = front.size() >= flush_threshold;
+		}
+		if (wake) cv.notify_one();
+	}
+
+	void AnsiLogWriter::ReportDropped()
+	{
+		if (unreported == 0) return;
+
+		front.append(time_prefix, time_prefix_len);
+		front.append(std::to_string(unreported));
+		front.append(" lines dropped\n");
+		unreported = 0;
+	}
+
+	void AnsiLogWriter::Flush()
+	{
+		std::lock_guard<decltype(write_mutex)> write_lock(write_mutex);
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			ReportDropped();
+			back.swap(front);
+		}
+		if (!back.empty()) sink(back.data(), back.size());
+		back.clear();
+	}
+
+	uint64_t AnsiLogWriter::Dropped()
+	{
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		return dropped;
+	}
+
+	void AnsiLogWriter::FlushLoop()
+	{
+		std::unique_lock<decltype(mutex)> lock(mutex);
+		while (!stop)
+		{
+			cv.wait_for(lock, flush_interval, [this] { return stop || front.size() >= flush_threshold; });
+			if (front.empty()) continue;
+
+			lock.unlock();
+			Flush();
+			lock.lock();
+		}
+	}
+}
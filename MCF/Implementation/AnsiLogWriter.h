@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace MCF
+{
+	/// <summary>
+	/// Platform-neutral log line renderer and batcher. Lines are rendered with ANSI/VT color sequences into a
+	/// reusable buffer by the logging thread, and a background thread hands whole batches to the output sink,
+	/// either every flush_interval or as soon as flush_threshold bytes are pending.
+	/// </summary>
+	class AnsiLogWriter
+	{
+	public:
+		typedef std::function<void(const char* data, size_t size)> Sink;
+
+	private:
+		Sink sink;
+		size_t flush_threshold;
+		size_t max_pending;
+		std::chrono::milliseconds flush_interval;
+
+		std::string front; // Buffer being rendered into
+		std::string back; // Buffer being written by the flush thread
+		uint64_t dropped = 0;
+		uint64_t unreported = 0; // Dropped lines not yet reported in the output
+
+		time_t cached_second = -1;
+		char time_prefix[16]{ };
+		size_t time_prefix_len = 0;
+
+		std::string sgr[256]; // SGR escape sequence of each console color attribute
+
+		bool stop = false;
+		std::mutex mutex;
+		std::mutex write_mutex;
+		std::condition_variable cv;
+		std::thread flush_thread;
+
+		void FlushLoop();
+		void UpdateTimePrefix(time_t now);
+		// Append the line giving the number of unreported dropped lines, if any. The mutex must be held
+		void ReportDropped();
+
+	public:
+		/// <summary>
+		/// Construct the writer and start its flush thread.
+		/// If more than max_pending bytes are waiting to be written, new lines are dropped and counted, and their
+		/// number is written as a line of its own once the sink catches up.
+		/// </summary>
+		AnsiLogWriter(Sink sink, size_t flush_threshold = 1 << 16,
+			std::chrono::milliseconds flush_interval = std::chrono::milliseconds(16), size_t max_pending = 1 << 24);
+
+		AnsiLogWriter(AnsiLogWriter&) = delete;
+		~AnsiLogWriter();
+
+		/// <summary>
+		/// Render a line in the format "[TIME] [SEV] [SOURCE] MESSAGE". The color format follows that of the
+		/// Windows COLOR command: the high byte is the color of the severity and the low byte the color of the line.
+		/// </summary>
+		void Write(const char* sev, const char* source, const char* msg, uint16_t color);
+
+		/// <summary>
+		/// Synchronously write all pending lines to the sink.
+		/// </summary>
+		void Flush();
+
+		/// <summary>
+		/// Number of lines dropped because the sink could not keep up.
+		/// </summary>
+		uint64_t Dropped();
+	};
+}
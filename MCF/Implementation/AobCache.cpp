@@ -0,0 +1,97 @@
+#include "AobCache.h"
+#include <fstream>
+#include <filesystem>
+#include <string>
+
+namespace MCF
+{
+	uint64_t AobCache::Hash(const void* data, size_t size, uint64_t hash)
+	{
+		auto p = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= p[i];
+			hash *= 0x100000001b3;
+		}
+		return hash;
+	}
+
+	uint64_t AobCache::Key(const CompiledAob& aob, uint64_t regions_key)
+	{
+		uint64_t hash = Hash(&regions_key, sizeof(regions_key));
+		hash = Hash(&aob.length, sizeof(aob.length), hash);
+		hash = Hash(aob.bytes.data(), aob.length, hash);
+		return Hash(aob.masks.data(), aob.length, hash);
+	}
+
+	bool AobCache::Load(const char* path)
+	{
+		entries.clear();
+		dirty = false;
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+
+		uint32_t header[3];
+		if (!file.read((char*)header, sizeof(header)) || header[0] != Magic || header[1] != Version) return false;
+
+		for (uint32_t i = 0; i < header[2]; i++)
+		{
+			uint64_t key;
+			Location location;
+			if (!file.read((char*)&key, sizeof(key)) || !file.read((char*)&location, sizeof(location)))
+			{
+				entries.clear();
+				return false;
+			}
+			entries[key] = location;
+		}
+		return true;
+	}
+
+	bool AobCache::Save(const char* path)
+	{
+		if (!dirty) return true;
+
+		std::string tmp_path = std::string(path) + ".tmp";
+		{
+			std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+			uint32_t header[3] = { Magic, Version, (uint32_t)entries.size() };
+			file.write((const char*)header, sizeof(header));
+			for (const auto& [key, location] : entries)
+			{
+				file.write((const char*)&key, sizeof(key));
+				file.write((const char*)&location, sizeof(location));
+			}
+			if (!file.flush()) return false;
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tmp_path, path, ec);
+		if (ec) return false;
+
+		dirty = false;
+		return true;
+	}
+
+	bool AobCache::Lookup(uint64_t key, Location& out) const
+	{
+		auto it = entries.find(key);
+		if (it == entries.end()) return false;
+		out = it->second;
+		return true;
+	}
+
+	void AobCache::Store(uint64_t key, Location location)
+	{
+		auto it = entries.find(key);
+		if (it != entries.end() && it->second.region == location.region && it->second.offset == location.offset) return;
+		entries[key] = location;
+		dirty = true;
+	}
+
+	void AobCache::Erase(uint64_t key)
+	{
+		if (entries.erase(key)) dirty = true;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "AobScanner.h"
+#include <stdint.h>
+#include <unordered_map>
+
+namespace MCF
+{
+	/// <summary>
+	/// On-disk map from AOB scan keys to the location of their first match. A key identifies both the pattern and
+	/// the exact set of sections it was searched in (module name, PE timestamp and image size, section name and
+	/// bounds), so an entry is only ever looked up against the same binary. Locations are stored as a region index
+	/// and offset, which are stable across launches regardless of where modules are loaded.
+	/// </summary>
+	class AobCache
+	{
+	public:
+		struct Location
+		{
+			uint32_t region;
+			uint32_t offset;
+		};
+
+	private:
+		static constexpr uint32_t Magic = 0x4146434D; // "MCFA"
+		static constexpr uint32_t Version = 1;
+
+		std::unordered_map<uint64_t, Location> entries;
+		bool dirty = false;
+
+	public:
+		static constexpr uint64_t HashBasis = 0xcbf29ce484222325;
+
+		/// <summary>
+		/// FNV-1a hash of a buffer, continuing from the given hash.
+		/// </summary>
+		static uint64_t Hash(const void* data, size_t size, uint64_t hash = HashBasis);
+
+		/// <summary>
+		/// Key of a pattern searched in the regions identified by regions_key.
+		/// </summary>
+		static uint64_t Key(const CompiledAob& aob, uint64_t regions_key);
+
+		/// <summary>
+		/// Replace the contents of the cache by those of a file.
+		/// </summary>
+		/// <returns>False if the file does not exist or is not a valid cache, in which case the cache is cleared.</returns>
+		bool Load(const char* path);
+
+		/// <summary>
+		/// Write the cache to a file if it was modified since it was loaded or last saved. The file is replaced
+		/// atomically, so a crash while saving never leaves a truncated cache behind.
+		/// </summary>
+		bool Save(const char* path);
+
+		bool Lookup(uint64_t key, Location& out) const;
+		void Store(uint64_t key, Location location);
+		void Erase(uint64_t key);
+	};
+}
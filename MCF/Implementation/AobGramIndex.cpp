@@ -0,0 +1,137 @@
+#include "AobGramIndex.h"
+#include <string.h>
+#include <algorithm>
+
+namespace MCF
+{
+	namespace
+	{
+		bool IsKnownGram(const CompiledAob& aob, size_t offset)
+		{
+			for (size_t i = 0; i < AobGramIndex::GramSize; i++)
+				if (aob.masks[offset + i] != 0xFF) return false;
+			return true;
+		}
+	}
+
+	uint32_t AobGramIndex::BucketBits(size_t size, uint32_t stride)
+	{
+		// About 8 positions per bucket, which keeps the bucket table small next to the postings
+		size_t positions = size / stride + 1;
+		uint32_t bits = 8;
+		while (bits < 24 && ((size_t)1 << bits) * 8 < positions) bits++;
+		return bits;
+	}
+
+	size_t AobGramIndex::MemoryFor(size_t size, uint32_t stride)
+	{
+		size_t positions = size >= GramSize ? (size - GramSize) / stride + 1 : 0;
+		return sizeof(uint32_t) * (positions + ((size_t)1 << BucketBits(size, stride)) + 1);
+	}
+
+	uint32_t AobGramIndex::StrideFor(size_t size, size_t max_bytes)
+	{
+		for (uint32_t stride = 1; stride <= MaxStride; stride++)
+			if (MemoryFor(size, stride) <= max_bytes) return stride;
+		return 0;
+	}
+
+	uint32_t AobGramIndex::Bucket(const uint8_t* gram) const
+	{
+		uint32_t v;
+		memcpy(&v, gram, sizeof(v));
+		return (v * 2654435761u) >> (32 - bucket_bits);
+	}
+
+	AobGramIndex::AobGramIndex(const uint8_t* begin, size_t size, uint32_t stride) :
+		begin(begin), size(size), stride(stride), bucket_bits(BucketBits(size, stride))
+	{
+		// Counting sort by bucket. Positions are visited in increasing order, so each posting list is sorted.
+		bucket_start.assign(((size_t)1 << bucket_bits) + 1, 0);
+		if (size < GramSize) return;
+
+		size_t last = size - GramSize;
+		for (size_t p = 0; p <= last; p += stride) bucket_start[Bucket(begin + p) + 1]++;
+		for (size_t b = 1; b < bucket_start.size(); b++) bucket_start[b] += bucket_start[b - 1];
+
+		postings.resize(bucket_start.back());
+		std::vector<uint32_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+		for (size_t p = 0; p <= last; p += stride) postings[fill[Bucket(begin + p)]++] = (uint32_t)p;
+	}
+
+	bool AobGramIndex::CanQuery(const CompiledAob& aob) const
+	{
+		if (aob.length < GramSize) return false;
+
+		uint32_t covered = 0;
+		std::vector<bool> residues(stride);
+		for (size_t j = 0; j + GramSize <= aob.length && covered < stride; j++)
+		{
+			if (residues[j % stride] || !IsKnownGram(aob, j)) continue;
+			residues[j % stride] = true;
+			covered++;
+		}
+		return covered == stride;
+	}
+
+	const uint8_t* AobGramIndex::FindFirst(const CompiledAob& aob) const
+	{
+		std::vector<uint32_t> candidates;
+		for (uint32_t residue = 0; residue < stride; residue++)
+		{
+			// Pick the two known 4-grams of this residue with the shortest posting lists
+			size_t best[2] = { SIZE_MAX, SIZE_MAX };
+			uint32_t best_len[2] = { UINT32_MAX, UINT32_MAX };
+			for (size_t j = residue; j + GramSize <= aob.length; j += stride)
+			{
+				if (!IsKnownGram(aob, j)) continue;
+				uint32_t b = Bucket(aob.bytes.data() + j);
+				uint32_t len = bucket_start[b + 1] - bucket_start[b];
+				if (len < best_len[0])
+				{
+					best[1] = best[0]; best_len[1] = best_len[0];
+					best[0] = j; best_len[0] = len;
+				}
+				else if (len < best_len[1])
+				{
+					best[1] = j; best_len[1] = len;
+				}
+			}
+			if (best[0] == SIZE_MAX) continue;
+
+			auto list = [&](size_t j) {
+				uint32_t b = Bucket(aob.bytes.data() + j);
+				return std::make_pair(postings.data() + bucket_start[b], postings.data() + bucket_start[b + 1]);
+			};
+
+			// Both lists are sorted by position, so the match starts they imply can be intersected by merging
+			auto [a, a_end] = list(best[0]);
+			if (best[1] == SIZE_MAX)
+			{
+				for (; a != a_end; a++)
+					if (*a >= best[0]) candidates.push_back(*a - (uint32_t)best[0]);
+				continue;
+			}
+			auto [b, b_end] = list(best[1]);
+			while (a != a_end && b != b_end)
+			{
+				int64_t sa = (int64_t)*a - (int64_t)best[0], sb = (int64_t)*b - (int64_t)best[1];
+				if (sa < sb) a++;
+				else if (sb < sa) b++;
+				else
+				{
+					if (sa >= 0) candidates.push_back((uint32_t)sa);
+					a++;
+					b++;
+				}
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+		for (uint32_t start : candidates)
+		{
+			if (start + aob.length <= size && aob.Matches(begin + start)) return begin + start;
+		}
+		return nullptr;
+	}
+}
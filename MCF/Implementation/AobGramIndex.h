@@ -0,0 +1,65 @@
+#pragma once
+#include "AobScanner.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Sampled 4-gram index of a section, answering AOB queries without scanning it. Every stride-th position is
+	/// indexed, in a posting list per hash bucket of its 4-gram, sorted by position. A pattern can be queried if for
+	/// every residue modulo the stride, it has a fully known 4-gram at an offset with that residue: one of them is
+	/// then indexed for any match. Candidates are the intersection of the two rarest posting lists of each residue,
+	/// and are verified against the section bytes.
+	/// </summary>
+	class AobGramIndex
+	{
+	private:
+		const uint8_t* begin;
+		size_t size;
+		uint32_t stride;
+		uint32_t bucket_bits;
+		std::vector<uint32_t> bucket_start; // Offset of the posting list of each bucket, plus the total at the end
+		std::vector<uint32_t> postings; // Positions of the sampled 4-grams, relative to begin
+
+		uint32_t Bucket(const uint8_t* gram) const;
+
+		static uint32_t BucketBits(size_t size, uint32_t stride);
+
+	public:
+		static constexpr size_t GramSize = 4;
+
+		// Strides above this leave too few queryable patterns to be worth indexing
+		static constexpr uint32_t MaxStride = 16;
+
+		/// <summary>
+		/// Number of bytes used by the index of a section of the given size.
+		/// </summary>
+		static size_t MemoryFor(size_t size, uint32_t stride);
+
+		/// <summary>
+		/// Smallest stride whose index fits in max_bytes, or 0 if MaxStride does not fit.
+		/// </summary>
+		static uint32_t StrideFor(size_t size, size_t max_bytes);
+
+		/// <summary>
+		/// Build the index of a section. Sections larger than 4 GiB are not supported.
+		/// </summary>
+		AobGramIndex(const uint8_t* begin, size_t size, uint32_t stride);
+
+		const uint8_t* Begin() const { return begin; }
+		size_t Size() const { return size; }
+		size_t MemoryUsage() const { return MemoryFor(size, stride); }
+
+		/// <summary>
+		/// Check if a pattern has enough fully known bytes to be queried.
+		/// </summary>
+		bool CanQuery(const CompiledAob& aob) const;
+
+		/// <summary>
+		/// Find the first match of a pattern for which CanQuery is true, or NULL if there are none.
+		/// </summary>
+		const uint8_t* FindFirst(const CompiledAob& aob) const;
+	};
+}
@@ -0,0 +1,217 @@
+#include "AobMultiScanner.h"
+#include <deque>
+#include <algorithm>
+
+namespace MCF
+{
+	AobMultiScanner::AobMultiScanner(const CompiledAob* const* aobs, size_t count) : patterns(aobs, aobs + count)
+	{
+		static constexpr uint32_t None = UINT32_MAX;
+		std::vector<std::vector<Output>> own_outputs(1);
+		delta.assign(256, None);
+
+		for (uint32_t pat = 0; pat < count; pat++)
+		{
+			const CompiledAob& aob = *aobs[pat];
+
+			// Pick the window of fully masked bytes with the highest total rarity
+			size_t best_start = 0, best_len = 0;
+			int best_score = -1;
+			for (size_t i = 0; i < aob.length; i++)
+			{
+				int score = 0;
+				size_t len = 0;
+				while (len < MaxFragment && i + len < aob.length && aob.masks[i + len] == 0xFF)
+				{
+					score += 256 - AobScanner::ByteFrequency(aob.bytes[i + len]);
+					len++;
+				}
+				if (len > 0 && score > best_score)
+				{
+					best_score = score;
+					best_start = i;
+					best_len = len;
+				}
+			}
+			if (best_len == 0)
+			{
+				unanchored.push_back(pat);
+				continue;
+			}
+
+			uint32_t state = 0;
+			for (size_t i = best_start; i < best_start + best_len; i++)
+			{
+				uint32_t& next = delta[state * 256 + aob.bytes[i]];
+				if (next == None)
+				{
+					next = (uint32_t)own_outputs.size();
+					own_outputs.emplace_back();
+					delta.resize(delta.size() + 256, None);
+				}
+				state = delta[state * 256 + aob.bytes[i]];
+			}
+			own_outputs[state].push_back(Output{ .pattern = pat, .start_offset = (uint32_t)(best_start + best_len) });
+		}
+
+		// Breadth-first construction of failure links, turning the trie into a DFA
+		size_t num_states = own_outputs.size();
+		std::vector<uint32_t> fail(num_states, 0);
+		std::vector<std::vector<Output>> all_outputs(num_states);
+		std::deque<uint32_t> queue;
+		std::vector<uint32_t> order{ 0 };
+
+		for (int c = 0; c < 256; c++)
+		{
+			uint32_t& next = delta[c];
+			if (next == None) next = 0;
+			else queue.push_back(next);
+		}
+		while (!queue.empty())
+		{
+			uint32_t state = queue.front();
+			queue.pop_front();
+			order.push_back(state);
+
+			all_outputs[state] = own_outputs[state];
+			const auto& inherited = all_outputs[fail[state]];
+			all_outputs[state].insert(all_outputs[state].end(), inherited.begin(), inherited.end());
+
+			for (int c = 0; c < 256; c++)
+			{
+				uint32_t& next = delta[state * 256 + c];
+				uint32_t fallback = delta[fail[state] * 256 + c] & ~HasOutput;
+				if (next == None) next = fallback;
+				else
+				{
+					fail[next] = fallback;
+					queue.push_back(next);
+				}
+			}
+		}
+
+		// States are renumbered in breadth-first order, keeping the frequently visited shallow states together.
+		// Transitions store the offset of the next state's row rather than its index.
+		std::vector<uint32_t> rank(num_states);
+		for (uint32_t i = 0; i < num_states; i++) rank[order[i]] = i;
+
+		std::vector<uint32_t> trie_delta;
+		trie_delta.swap(delta);
+		delta.resize(trie_delta.size());
+		out_begin.resize(num_states + 1);
+		for (uint32_t i = 0; i < num_states; i++)
+		{
+			uint32_t state = order[i];
+			for (int c = 0; c < 256; c++)
+			{
+				uint32_t next = trie_delta[state * 256 + c];
+				delta[i * 256 + c] = rank[next] * 256 | (all_outputs[next].empty() ? 0 : HasOutput);
+			}
+
+			out_begin[i] = (uint32_t)outputs.size();
+			outputs.insert(outputs.end(), all_outputs[state].begin(), all_outputs[state].end());
+		}
+		out_begin[num_states] = (uint32_t)outputs.size();
+	}
+
+	inline size_t AobMultiScanner::Verify(uint32_t state, const uint8_t* p, const uint8_t* begin, const uint8_t* end,
+		const uint8_t* const* from, const uint8_t** results) const
+	{
+		size_t found = 0;
+		state = (state & ~HasOutput) / 256;
+		for (uint32_t o = out_begin[state]; o < out_begin[state + 1]; o++)
+		{
+			const Output& out = outputs[o];
+			if (results[out.pattern] != nullptr) continue;
+
+			const CompiledAob& aob = *patterns[out.pattern];
+			const uint8_t* start = p + 1 - out.start_offset;
+			if (start < begin || (from && start < from[out.pattern])) continue;
+
+			size_t avail = end - start;
+			if (avail >= aob.bytes.size() ? aob.MatchesPadded(start) : avail >= aob.length && aob.Matches(start))
+			{
+				results[out.pattern] = start;
+				found++;
+			}
+		}
+		return found;
+	}
+
+	size_t AobMultiScanner::FindFirst(const uint8_t* begin, const uint8_t* end, const uint8_t** results) const
+	{
+		return FindNext(begin, end, nullptr, results);
+	}
+
+	size_t AobMultiScanner::FindNext(const uint8_t* begin, const uint8_t* end, const uint8_t* const* from, const uint8_t** results) const
+	{
+		size_t num_patterns = patterns.size();
+		size_t missing_before = std::count(results, results + num_patterns, nullptr);
+
+		for (uint32_t pat : unanchored)
+		{
+			if (results[pat] != nullptr) continue;
+			const uint8_t* start = from ? (std::max)(begin, from[pat]) : begin;
+			results[pat] = start < end ? AobScanner::Find(*patterns[pat], start, end) : nullptr;
+		}
+
+		// The range is split in lanes advanced in lockstep, so that the latency of their transition lookups 
+		// overlaps. Since fragments are at most MaxFragment bytes long, each lane starts that many bytes early
+		// to reach the correct state. Fragment hits of a pattern come in increasing order within a lane, so the
+		// first one verified in the first lane which has one is the first occurence. The scan stops early once
+		// the first lane found every pattern.
+		size_t missing = std::count(results, results + num_patterns, nullptr);
+		size_t size = end - begin;
+		size_t lanes = size >= 4096 ? Lanes : 1;
+		size_t lane_size = size / lanes;
+
+		std::vector<const uint8_t*> lane_results((lanes - 1) * num_patterns);
+		const uint8_t** lane_res[Lanes];
+		const uint8_t* pos[Lanes];
+		const uint8_t* lane_end[Lanes];
+		uint32_t state[Lanes]{ };
+		for (size_t l = 0; l < lanes; l++)
+		{
+			lane_res[l] = l == 0 ? results : lane_results.data() + (l - 1) * num_patterns;
+			if (l > 0) std::copy(results, results + num_patterns, lane_res[l]);
+			pos[l] = begin + l * lane_size - (l == 0 ? 0 : MaxFragment - 1);
+			lane_end[l] = l == lanes - 1 ? end : begin + (l + 1) * lane_size;
+		}
+
+		if (lanes == Lanes && missing != 0)
+		{
+			size_t common = lane_end[0] - pos[0];
+			for (size_t i = 0; i < common && missing != 0; i++)
+			{
+				state[0] = delta[(state[0] & ~HasOutput) + *pos[0]];
+				if (state[0] & HasOutput) missing -= Verify(state[0], pos[0], begin, end, from, results);
+				pos[0]++;
+
+				for (size_t l = 1; l < Lanes; l++)
+				{
+					state[l] = delta[(state[l] & ~HasOutput) + *pos[l]];
+					if (state[l] & HasOutput) Verify(state[l], pos[l], begin, end, from, lane_res[l]);
+					pos[l]++;
+				}
+			}
+		}
+		for (size_t l = 0; l < lanes && missing != 0; l++)
+		{
+			for (; pos[l] < lane_end[l] && missing != 0; pos[l]++)
+			{
+				state[l] = delta[(state[l] & ~HasOutput) + *pos[l]];
+				if (!(state[l] & HasOutput)) continue;
+				size_t found = Verify(state[l], pos[l], begin, end, from, lane_res[l]);
+				if (l == 0) missing -= found;
+			}
+		}
+
+		if (missing != 0)
+		{
+			for (size_t pat = 0; pat < num_patterns; pat++)
+				for (size_t l = 1; l < lanes && results[pat] == nullptr; l++) results[pat] = lane_res[l][pat];
+		}
+
+		return missing_before - std::count(results, results + num_patterns, nullptr);
+	}
+}
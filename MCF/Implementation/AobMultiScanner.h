@@ -0,0 +1,62 @@
+#pragma once
+#include "AobScanner.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Finds many patterns in a single pass. Each pattern contributes its most selective run of up to 8 fully
+	/// masked bytes (its fragment) to an Aho-Corasick automaton, compiled to a dense DFA. Every fragment hit is 
+	/// verified against the whole pattern. Patterns without fully masked bytes are searched separately.
+	/// </summary>
+	class AobMultiScanner
+	{
+	private:
+		static constexpr uint32_t MaxFragment = 8;
+		static constexpr size_t Lanes = 4;
+		static constexpr uint32_t HasOutput = 0x80000000; // Set in transitions to states where fragments end
+
+		struct Output
+		{
+			uint32_t pattern;
+			uint32_t start_offset; // Distance from the pattern start to the end of the fragment
+		};
+
+		std::vector<const CompiledAob*> patterns;
+		std::vector<uint32_t> unanchored; // Patterns without a fragment
+
+		std::vector<uint32_t> delta; // 256 transitions per state
+		std::vector<uint32_t> out_begin; // Range of each state's outputs, including those of its suffixes
+		std::vector<Output> outputs;
+
+		// Verify the fragment hits ending at p, returning the number of patterns found
+		size_t Verify(uint32_t state, const uint8_t* p, const uint8_t* begin, const uint8_t* end, const uint8_t* const* from,
+			const uint8_t** results) const;
+
+	public:
+		AobMultiScanner() { }
+
+		/// <summary>
+		/// Compile the automaton for the given patterns, which must outlive the scanner.
+		/// </summary>
+		AobMultiScanner(const CompiledAob* const* aobs, size_t count);
+
+		size_t NumStates() const { return delta.size() / 256; }
+
+		/// <summary>
+		/// Find the first occurence of every pattern whose entry in results is null, in [begin, end). 
+		/// Results of patterns which are not found are left untouched.
+		/// </summary>
+		/// <returns>The number of patterns found.</returns>
+		size_t FindFirst(const uint8_t* begin, const uint8_t* end, const uint8_t** results) const;
+
+		/// <summary>
+		/// Like FindFirst, but the occurence of each pattern must also start at or after its entry in from. Used to
+		/// find the next occurence of many patterns in one pass, from their previous occurence + 1.
+		/// </summary>
+		/// <returns>The number of patterns found.</returns>
+		size_t FindNext(const uint8_t* begin, const uint8_t* end, const uint8_t* const* from, const uint8_t** results) const;
+	};
+}
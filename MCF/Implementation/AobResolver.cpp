@@ -0,0 +1,83 @@
+#include "AobResolver.h"
+#include "MemoryRegions.h"
+#include <Zydis/Zydis.h>
+#include <algorithm>
+
+namespace MCF
+{
+	namespace AobResolver
+	{
+		namespace
+		{
+			// Decode the instruction at address and compute the target of its first operand accepted by pred.
+			// Addresses come from matches and previous steps and may point anywhere, so the code is copied with
+			// SafeRead rather than decoded in place
+			template<typename TPred>
+			bool OperandTarget(uintptr_t address, uintptr_t& target, TPred pred)
+			{
+				// An instruction at the end of a region is read up to the page boundary
+				uint8_t code[ZYDIS_MAX_INSTRUCTION_LENGTH];
+				size_t length = sizeof(code);
+				if (!MemoryRegions::SafeRead(address, code, length))
+				{
+					length = (std::min)(length, 0x1000 - (address & 0xFFF));
+					if (!MemoryRegions::SafeRead(address, code, length)) return false;
+				}
+
+				ZydisDecoder decoder;
+				ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_ADDRESS_WIDTH_64);
+
+				ZydisDecodedInstruction instr;
+				if (!ZYAN_SUCCESS(ZydisDecoderDecodeBuffer(&decoder, code, length, &instr)))
+					return false;
+
+				for (ZyanU8 i = 0; i < instr.operand_count; i++)
+				{
+					const ZydisDecodedOperand& op = instr.operands[i];
+					if (!pred(op)) continue;
+
+					ZyanU64 result;
+					if (!ZYAN_SUCCESS(ZydisCalcAbsoluteAddress(&instr, &op, address, &result))) return false;
+					target = (uintptr_t)result;
+					return true;
+				}
+				return false;
+			}
+		}
+
+		size_t Apply(uintptr_t& address, const AobResolveStep* steps, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const AobResolveStep& step = steps[i];
+				uintptr_t next = 0;
+				bool ok = true;
+				switch (step.op)
+				{
+				case AobResolveOp::Offset:
+					next = address + step.offset;
+					break;
+				case AobResolveOp::RipOperand:
+					ok = OperandTarget(address + step.offset, next, [](const ZydisDecodedOperand& op) {
+						return op.type == ZYDIS_OPERAND_TYPE_MEMORY && op.mem.base == ZYDIS_REGISTER_RIP;
+					});
+					break;
+				case AobResolveOp::FollowBranch:
+					ok = OperandTarget(address + step.offset, next, [](const ZydisDecodedOperand& op) {
+						return op.type == ZYDIS_OPERAND_TYPE_IMMEDIATE && op.imm.is_relative;
+					});
+					break;
+				case AobResolveOp::Deref:
+					ok = MemoryRegions::SafeRead(address, &next, sizeof(next)) && next != 0;
+					next += step.offset;
+					break;
+				default:
+					ok = false;
+				}
+				if (!ok) return i;
+				address = next;
+			}
+			return count;
+		}
+	}
+}
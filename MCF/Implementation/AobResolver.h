@@ -0,0 +1,19 @@
+#pragma once
+#include "Include/AobScanMan.h"
+
+namespace MCF
+{
+	/// <summary>
+	/// Applies the resolve steps of an AOB to its match, decoding instructions with Zydis.
+	/// </summary>
+	namespace AobResolver
+	{
+		/// <summary>
+		/// Apply the steps in order to address. Memory is read with MemoryRegions::SafeRead, so a step reading an
+		/// unmapped address fails instead of faulting.
+		/// </summary>
+		/// <returns>The number of steps applied. Less than count if a step failed, in which case address is left
+		/// to the result of the last successful step.</returns>
+		size_t Apply(uintptr_t& address, const AobResolveStep* steps, size_t count);
+	}
+}
@@ -0,0 +1,767 @@
+#include "AobScanManImp.h"
+#include "AobResolver.h"
+#include "AobSigGen.h"
+#include "ModuleRef.h"
+#include <string.h>
+#include <stdlib.h>
+#include <map>
+#include <algorithm>
+#include <format>
+
+namespace MCF
+{
+	AobScanManImp::AobScanManImp()
+	{
+		C<CommandMan>()->Register(&sig_cmd);
+		late_thread = std::thread(&AobScanManImp::LateScanLoop, this);
+	}
+
+	AobScanManImp::~AobScanManImp()
+	{
+		C<CommandMan>()->Unregister(&sig_cmd);
+		{
+			std::lock_guard<decltype(late_mutex)> lock(late_mutex);
+			late_stop = true;
+		}
+		late_cv.notify_all();
+		late_thread.join();
+		SetQueryIndexBudget(0);
+	}
+
+	CompiledAob AobScanManImp::Compile(const AobChar* aob, size_t length)
+	{
+		std::vector<uint8_t> bytes(length), masks(length);
+		for (size_t i = 0; i < length; i++)
+		{
+			bytes[i] = aob[i].byte;
+			masks[i] = aob[i].mask;
+		}
+		return CompiledAob(bytes.data(), masks.data(), length);
+	}
+
+	AobHandle AobScanManImp::RegisterAob(const AobChar* aob, size_t length, const void* obj, uintptr_t* out_result,
+		ModuleFilter module_filter, SectionFilter section_filter, const AobResolveStep* steps, size_t num_steps)
+	{
+		auto entry = std::make_shared<AobEntry>(AobEntry{
+			.aob = Compile(aob, length),
+			.obj = obj,
+			.out_result = out_result,
+			.module_filter = module_filter,
+			.section_filter = section_filter,
+			.steps = std::vector<AobResolveStep>(steps, steps + num_steps)
+		});
+
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		entry->handle = next_handle++;
+		aobs[entry->handle] = entry;
+		ObjState& state = objs[obj];
+		state.count++;
+		state.unscanned++;
+		return entry->handle;
+	}
+
+	void AobScanManImp::UnregisterAob(AobHandle handle)
+	{
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		auto it = aobs.find(handle);
+		if (it == aobs.end()) return;
+		ForgetEntry(*it->second);
+		aobs.erase(it);
+	}
+
+	void AobScanManImp::UnregisterAobsForObj(const void* obj)
+	{
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		if (!objs.erase(obj)) return;
+		std::erase_if(aobs, [obj](const auto& kv) { return kv.second->obj == obj; });
+	}
+
+	void AobScanManImp::ForgetEntry(const AobEntry& entry)
+	{
+		auto it = objs.find(entry.obj);
+		if (it == objs.end()) return;
+		ObjState& state = it->second;
+		if (!entry.scanned) state.unscanned--;
+		else if (entry.result == 0) state.failed--;
+		if (--state.count == 0) objs.erase(it);
+	}
+
+	void AobScanManImp::SetResult(AobEntry& entry, uintptr_t result)
+	{
+		// Entries unregistered while they were being scanned are no longer counted
+		if (aobs.count(entry.handle))
+		{
+			ObjState& state = objs[entry.obj];
+			if (!entry.scanned) state.unscanned--;
+			else if (entry.result == 0) state.failed--;
+			if (result == 0) state.failed++;
+		}
+		entry.scanned = true;
+		entry.result = result;
+	}
+
+	uintptr_t AobScanManImp::QueryAobResult(AobHandle handle)
+	{
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		auto it = aobs.find(handle);
+		return it == aobs.end() ? 0 : it->second->result;
+	}
+
+	std::vector<AobScanManImp::ScanRegion> AobScanManImp::FindRegions(ModuleFilter module_filter, SectionFilter section_filter)
+	{
+		ModuleIndex* index = C<ModuleIndex>();
+		std::vector<ModuleIndex::ModuleInfo> modules;
+		if (module_filter == nullptr)
+		{
+			modules.resize(1);
+			if (!index->FindModuleByName(nullptr, &modules[0])) modules.clear();
+		}
+		else
+		{
+			modules.resize(index->GetModules(nullptr, 0));
+			modules.resize((std::min)(modules.size(), index->GetModules(modules.data(), modules.size())));
+		}
+
+		std::vector<ScanRegion> regions;
+		for (const auto& mod_info : modules)
+		{
+			if (module_filter == nullptr || module_filter((HMODULE)mod_info.base, mod_info.name))
+				AppendRegions(mod_info, section_filter, regions);
+		}
+		return regions;
+	}
+
+	void AobScanManImp::AppendRegions(const ModuleIndex::ModuleInfo& mod_info, SectionFilter section_filter, std::vector<ScanRegion>& regions)
+	{
+		auto module = (HMODULE)mod_info.base;
+		const char* name = mod_info.name;
+
+		std::vector<ModuleIndex::SectionInfo> sections(mod_info.num_sections);
+		sections.resize((std::min)(sections.size(), C<ModuleIndex>()->GetSections(mod_info.base, sections.data(), sections.size())));
+		for (const auto& sec_info : sections)
+		{
+			auto section = (IMAGE_SECTION_HEADER*)sec_info.header;
+			bool selected = section_filter ? section_filter(module, name, section) :
+				strncmp((const char*)section->Name, ".text", sizeof(section->Name)) == 0;
+			if (!selected) continue;
+
+			// Identifies the section across launches, as long as the binary is not modified
+			uint32_t image_size = (uint32_t)mod_info.size;
+			uint64_t identity = AobCache::Hash(name, strlen(name));
+			identity = AobCache::Hash(&mod_info.timestamp, sizeof(mod_info.timestamp), identity);
+			identity = AobCache::Hash(&image_size, sizeof(image_size), identity);
+			identity = AobCache::Hash(section->Name, sizeof(section->Name), identity);
+			identity = AobCache::Hash(&section->VirtualAddress, sizeof(DWORD), identity);
+			identity = AobCache::Hash(&section->Misc.VirtualSize, sizeof(DWORD), identity);
+
+			auto begin = (const uint8_t*)sec_info.begin;
+			regions.push_back(ScanRegion{
+				.module = module,
+				.begin = begin,
+				.end = begin + sec_info.size,
+				.identity = identity
+			});
+		}
+	}
+
+	std::string AobScanManImp::DefaultCachePath()
+	{
+		char exe_path[MAX_PATH], temp_path[MAX_PATH];
+		DWORD len = GetModuleFileNameA(NULL, exe_path, sizeof(exe_path));
+		if (len == 0 || len == sizeof(exe_path)) strcpy_s(exe_path, sizeof(exe_path), "unknown");
+		if (GetTempPathA(sizeof(temp_path), temp_path) == 0) temp_path[0] = 0;
+
+		const char* exe_name = strrchr(exe_path, '\\');
+		return std::string(temp_path) + "MCF_AobCache_" + (exe_name ? exe_name + 1 : exe_path) + ".bin";
+	}
+
+	void AobScanManImp::SetCachePath(const char* path)
+	{
+		std::lock_guard<decltype(scan_mutex)> scan_lock(scan_mutex);
+		cache_enabled = path != nullptr;
+		cache_path = path ? path : "";
+		cache_loaded = false;
+	}
+
+	void AobScanManImp::SetScanThreadCount(size_t count)
+	{
+		std::lock_guard<decltype(scan_mutex)> scan_lock(scan_mutex);
+		pool = std::make_unique<ThreadPool>(count);
+	}
+
+	void AobScanManImp::ScanGroup(const std::vector<ScanRegion>& regions, const std::vector<std::shared_ptr<AobEntry>>& entries,
+		const uint8_t** results, const std::function<void(size_t, const uint8_t*)>& on_found)
+	{
+		size_t count = entries.size();
+		size_t max_length = 1;
+		for (const auto& entry : entries)
+			max_length = (std::max)(max_length, entry->aob.length);
+		size_t overlap = max_length - 1;
+
+		// Chunks overlap by the length of the longest pattern minus one, so that every match starting in a chunk
+		// is found by it. Matches starting past the end of a chunk are left to the next one.
+		struct Chunk
+		{
+			const uint8_t* begin;
+			const uint8_t* end;
+			const uint8_t* scan_end;
+		};
+		std::vector<Chunk> chunks;
+		for (const auto& region : regions)
+		{
+			for (const uint8_t* p = region.begin; p < region.end; p += (std::min)(ChunkSize, (size_t)(region.end - p)))
+			{
+				size_t left = region.end - p;
+				chunks.push_back(Chunk{
+					.begin = p,
+					.end = p + (std::min)(ChunkSize, left),
+					.scan_end = p + (std::min)(ChunkSize + overlap, left)
+				});
+			}
+		}
+
+		// A single pass of the multi-pattern automaton is slower than a vector scan for a single pattern,
+		// but its cost barely depends on the number of patterns
+		std::unique_ptr<AobMultiScanner> multi;
+		if (count >= MultiScanThreshold)
+		{
+			std::vector<const CompiledAob*> aobs_to_find;
+			for (const auto& entry : entries) aobs_to_find.push_back(&entry->aob);
+			multi = std::make_unique<AobMultiScanner>(aobs_to_find.data(), aobs_to_find.size());
+		}
+
+		// Results are merged by keeping the match of the first chunk, as a sequential scan would.
+		// Chunks after the first one with a match skip the pattern.
+		std::vector<std::atomic<uint32_t>> first_chunk(count);
+		for (auto& c : first_chunk) c = UINT32_MAX;
+		AobScanner::Kernel kernel = AobScanner::BestKernel();
+
+		// A match is final once all chunks up to the one it was found in are done. The watermark is the
+		// number of leading chunks which are done.
+		std::mutex result_mutex;
+		std::vector<bool> chunk_done(chunks.size()), reported(count);
+		size_t watermark = 0;
+
+		auto scan_chunk = [&](size_t c) {
+			const Chunk& chunk = chunks[c];
+			std::vector<const uint8_t*> found(count, nullptr);
+			std::vector<bool> skip(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				skip[i] = first_chunk[i].load(std::memory_order_relaxed) < c;
+				if (skip[i]) found[i] = chunk.begin; // Marks the pattern as done for FindFirst
+			}
+
+			if (multi) multi->FindFirst(chunk.begin, chunk.scan_end, found.data());
+			else
+			{
+				for (size_t i = 0; i < count; i++)
+					if (!skip[i]) found[i] = AobScanner::Find(entries[i]->aob, chunk.begin, chunk.scan_end, kernel);
+			}
+
+			std::vector<size_t> final_matches;
+			{
+				std::lock_guard<decltype(result_mutex)> lock(result_mutex);
+				for (size_t i = 0; i < count; i++)
+				{
+					if (skip[i] || found[i] == nullptr || found[i] >= chunk.end || c >= first_chunk[i]) continue;
+					first_chunk[i] = (uint32_t)c;
+					results[i] = found[i];
+				}
+
+				chunk_done[c] = true;
+				size_t old_watermark = watermark;
+				while (watermark < chunks.size() && chunk_done[watermark]) watermark++;
+				if (watermark == old_watermark) return;
+
+				for (size_t i = 0; i < count; i++)
+				{
+					if (reported[i] || first_chunk[i] >= watermark) continue;
+					reported[i] = true;
+					final_matches.push_back(i);
+				}
+			}
+			for (size_t i : final_matches) on_found(i, results[i]);
+		};
+
+		pool->ParallelFor(chunks.size(), scan_chunk);
+	}
+
+	bool AobScanManImp::IsObjComplete(const void* obj, bool& success)
+	{
+		auto it = objs.find(obj);
+		success = it == objs.end() || it->second.failed == 0;
+		return it == objs.end() || it->second.unscanned == 0;
+	}
+
+	void AobScanManImp::NotifyObjComplete(const void* obj, bool success, const std::vector<HCallResult>& call_results)
+	{
+		if (!success) C<Logger>()->Warn(this, "Some AOBs of object {} were not found", obj);
+
+		AobScanCompleteEvent ev{ .obj = obj, .success = success };
+		for (HCallResult handle : call_results) C<EventMan>()->RaiseCallResult(handle, &ev);
+		C<EventMan>()->RaiseEvent(ev);
+	}
+
+	uintptr_t AobScanManImp::ApplySteps(const AobEntry& entry, const uint8_t* match)
+	{
+		uintptr_t address = (uintptr_t)match;
+		if (match == nullptr || entry.steps.empty()) return address;
+
+		size_t applied = AobResolver::Apply(address, entry.steps.data(), entry.steps.size());
+		if (applied == entry.steps.size()) return address;
+
+		C<Logger>()->Warn(this, "Resolve step {} of AOB {} failed at address {}", applied, entry.handle, (const void*)address);
+		return 0;
+	}
+
+	void AobScanManImp::ResolveEntry(AobEntry& entry, const uint8_t* match)
+	{
+		uintptr_t result = ApplySteps(entry, match);
+		bool success;
+		std::vector<HCallResult> call_results;
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			SetResult(entry, result);
+			if (!aobs.count(entry.handle)) return;
+			if (entry.result != 0 && entry.out_result != nullptr) *entry.out_result = entry.result;
+
+			// AOBs registered for the object since the scan started leave it incomplete until the next scan
+			if (!IsObjComplete(entry.obj, success)) return;
+
+			auto [begin, end] = waiters.equal_range(entry.obj);
+			for (auto it = begin; it != end; it++) call_results.push_back(it->second);
+			waiters.erase(begin, end);
+		}
+		NotifyObjComplete(entry.obj, success, call_results);
+	}
+
+	HCallResult AobScanManImp::AwaitObj(const void* obj, CallResultBase* call_result)
+	{
+		// Bound before taking the lock, since call result callbacks are run while EventMan holds its own
+		HCallResult handle = C<EventMan>()->BindCallResult(call_result);
+		if (handle == 0) return 0;
+
+		bool success;
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			if (!IsObjComplete(obj, success))
+			{
+				waiters.emplace(obj, handle);
+				return handle;
+			}
+		}
+		AobScanCompleteEvent ev{ .obj = obj, .success = success };
+		C<EventMan>()->RaiseCallResult(handle, &ev);
+		return handle;
+	}
+
+	void AobScanManImp::OnModuleLoaded(ModuleIndex::ModuleLoadedEvent* evt)
+	{
+		const ModuleIndex::ModuleInfo& mod_info = evt->module;
+
+		{
+			std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+			if (index_budget != 0)
+			{
+				index_queue.push_back(mod_info.base);
+				index_cv.notify_one();
+			}
+		}
+
+		std::lock_guard<decltype(late_mutex)> lock(late_mutex);
+		late_queue.push_back(mod_info);
+		late_cv.notify_one();
+	}
+
+	void AobScanManImp::LateScanLoop()
+	{
+		std::unique_lock<decltype(late_mutex)> lock(late_mutex);
+		while (true)
+		{
+			late_cv.wait(lock, [this] { return late_stop || !late_queue.empty(); });
+			if (late_stop) return;
+
+			ModuleIndex::ModuleInfo mod_info = late_queue.front();
+			late_queue.pop_front();
+			lock.unlock();
+			ScanLateModule(mod_info);
+			lock.lock();
+		}
+	}
+
+	void AobScanManImp::ScanLateModule(const ModuleIndex::ModuleInfo& mod_info)
+	{
+		std::lock_guard<decltype(scan_mutex)> scan_lock(scan_mutex);
+
+		// Skip modules which were unloaded since they were queued
+		ModuleIndex::ModuleInfo current;
+		if (!C<ModuleIndex>()->FindModule(mod_info.base, &current) || current.base != mod_info.base
+			|| current.timestamp != mod_info.timestamp) return;
+
+		// Only AOBs which were not found and may be in other modules than the main one are searched for
+		std::map<SectionFilter, std::vector<std::shared_ptr<AobEntry>>> late;
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			for (const auto& [handle, entry] : aobs)
+			{
+				if (entry->scanned && entry->result == 0 && entry->module_filter != nullptr)
+					late[entry->section_filter].push_back(entry);
+			}
+		}
+		if (late.empty()) return;
+
+		for (auto& [section_filter, entries] : late)
+		{
+			std::erase_if(entries, [&mod_info](const auto& entry) {
+				return !entry->module_filter((HMODULE)mod_info.base, mod_info.name);
+			});
+			if (entries.empty()) continue;
+
+			std::vector<ScanRegion> regions;
+			AppendRegions(mod_info, section_filter, regions);
+
+			std::vector<const uint8_t*> results(entries.size(), nullptr);
+			ScanGroup(regions, entries, results.data(), [](size_t, const uint8_t*) { });
+
+			for (size_t i = 0; i < entries.size(); i++)
+			{
+				AobEntry& entry = *entries[i];
+				uintptr_t result = ApplySteps(entry, results[i]);
+				if (result == 0) continue;
+
+				bool success;
+				{
+					std::lock_guard<decltype(mutex)> lock(mutex);
+					if (entry.result != 0) continue;
+					SetResult(entry, result);
+					if (entry.out_result != nullptr && aobs.count(entry.handle)) *entry.out_result = entry.result;
+					if (!IsObjComplete(entry.obj, success) || !success) continue;
+				}
+				C<Logger>()->Info(this, "AOBs of object {} were found in late module {}", entry.obj, mod_info.name);
+				NotifyObjComplete(entry.obj, true, { });
+			}
+		}
+	}
+
+	void AobScanManImp::OnModuleUnloaded(ModuleIndex::ModuleUnloadedEvent* evt)
+	{
+		uintptr_t base = evt->module.base;
+		{
+			// This runs under EventMan's lock, so the indexer is not waited for: it keeps the module loaded while
+			// reading it, and discards its index once cancelled
+			std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+			std::erase(index_queue, base);
+			if (indexing_module == base) indexing_cancelled = true;
+
+			std::unique_lock<decltype(gram_mutex)> gram_lock(gram_mutex);
+			std::erase_if(gram_indices, [&](const auto& kv) {
+				if ((uintptr_t)kv.first - base >= evt->module.size) return false;
+				index_used -= kv.second->MemoryUsage();
+				return true;
+			});
+		}
+
+		// Results in the module are cleared, so that they are searched for again if it is loaded back
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		for (const auto& [handle, entry] : aobs)
+		{
+			if (entry->result - evt->module.base >= evt->module.size) continue;
+			SetResult(*entry, 0);
+			if (entry->out_result != nullptr) *entry->out_result = 0;
+		}
+	}
+
+	void AobScanManImp::SetQueryIndexBudget(size_t max_bytes)
+	{
+		std::lock_guard<decltype(scan_mutex)> scan_lock(scan_mutex);
+		{
+			std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+			index_stop = true;
+		}
+		index_cv.notify_all();
+		if (index_thread.joinable()) index_thread.join();
+		{
+			std::unique_lock<decltype(gram_mutex)> gram_lock(gram_mutex);
+			gram_indices.clear();
+		}
+
+		std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+		index_queue.clear();
+		index_used = 0;
+		index_budget = max_bytes;
+		index_stop = false;
+		if (max_bytes == 0) return;
+
+		// The main module is indexed first, as most queries target it
+		ModuleIndex* index = C<ModuleIndex>();
+		std::vector<ModuleIndex::ModuleInfo> modules(index->GetModules(nullptr, 0));
+		modules.resize((std::min)(modules.size(), index->GetModules(modules.data(), modules.size())));
+		ModuleIndex::ModuleInfo main_module;
+		if (index->FindModuleByName(nullptr, &main_module)) index_queue.push_back(main_module.base);
+		for (const auto& module : modules)
+			if (module.base != main_module.base) index_queue.push_back(module.base);
+
+		index_thread = std::thread(&AobScanManImp::IndexLoop, this);
+	}
+
+	void AobScanManImp::IndexLoop()
+	{
+		std::unique_lock<decltype(index_mutex)> lock(index_mutex);
+		while (true)
+		{
+			index_cv.wait(lock, [this] { return index_stop || !index_queue.empty(); });
+			if (index_stop) return;
+
+			indexing_module = index_queue.front();
+			indexing_cancelled = false;
+			index_queue.pop_front();
+			lock.unlock();
+			IndexModule(indexing_module);
+			lock.lock();
+
+			indexing_module = 0;
+		}
+	}
+
+	void AobScanManImp::IndexModule(uintptr_t base)
+	{
+		// Unload events may come after the module is unmapped, so it is kept loaded while it is read
+		ModuleRef ref(base);
+		ModuleIndex::ModuleInfo mod_info;
+		if (!ref || !C<ModuleIndex>()->FindModule(base, &mod_info) || mod_info.base != base) return;
+
+		std::vector<ModuleIndex::SectionInfo> sections(mod_info.num_sections);
+		sections.resize((std::min)(sections.size(), C<ModuleIndex>()->GetSections(base, sections.data(), sections.size())));
+		for (const auto& section : sections)
+		{
+			if (!(section.flags & ModuleIndex::SectionExecute) || section.size > UINT32_MAX) continue;
+
+			// Sections are indexed as densely as the remaining budget allows
+			uint32_t stride;
+			{
+				std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+				if (index_stop) return;
+				stride = AobGramIndex::StrideFor(section.size, index_budget - index_used);
+				if (stride == 0) continue;
+				index_used += AobGramIndex::MemoryFor(section.size, stride);
+			}
+
+			auto gram_index = std::make_shared<AobGramIndex>((const uint8_t*)section.begin, section.size, stride);
+
+			std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+			if (index_stop || indexing_cancelled)
+			{
+				index_used -= gram_index->MemoryUsage();
+				return;
+			}
+			std::unique_lock<decltype(gram_mutex)> gram_lock(gram_mutex);
+			gram_indices[(const uint8_t*)section.begin] = gram_index;
+		}
+		C<Logger>()->Debug(this, "Indexed module {} for AOB queries", mod_info.name);
+	}
+
+	uintptr_t AobScanManImp::QueryPattern(const AobChar* aob, size_t length, ModuleFilter module_filter, SectionFilter section_filter)
+	{
+		CompiledAob compiled = Compile(aob, length);
+		for (const auto& region : FindRegions(module_filter, section_filter))
+		{
+			std::shared_ptr<AobGramIndex> gram_index;
+			{
+				std::shared_lock<decltype(gram_mutex)> gram_lock(gram_mutex);
+				auto it = gram_indices.find(region.begin);
+				if (it != gram_indices.end() && it->second->Size() == (size_t)(region.end - region.begin))
+					gram_index = it->second;
+			}
+
+			const uint8_t* match = gram_index && gram_index->CanQuery(compiled) ?
+				gram_index->FindFirst(compiled) : AobScanner::Find(compiled, region.begin, region.end);
+			if (match) return (uintptr_t)match;
+		}
+		return 0;
+	}
+
+	void AobScanManImp::ScanPending()
+	{
+		std::lock_guard<decltype(scan_mutex)> scan_lock(scan_mutex);
+
+		// Pending AOBs are grouped by filters, so that each distinct set of sections is only enumerated once
+		std::map<std::pair<ModuleFilter, SectionFilter>, std::vector<std::shared_ptr<AobEntry>>> pending;
+		std::unordered_map<const void*, size_t> remaining; // Number of pending AOBs of each object
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			for (const auto& [handle, entry] : aobs)
+			{
+				if (entry->scanned) continue;
+				pending[{ entry->module_filter, entry->section_filter }].push_back(entry);
+				remaining[entry->obj]++;
+			}
+		}
+		if (pending.empty()) return;
+
+		// Patterns of objects with few AOBs are searched for first, so that they complete as early as possible
+		for (auto& [filters, entries] : pending)
+		{
+			std::stable_sort(entries.begin(), entries.end(), [&remaining](const auto& a, const auto& b) {
+				size_t ra = remaining[a->obj], rb = remaining[b->obj];
+				return ra != rb ? ra < rb : std::less<const void*>()(a->obj, b->obj);
+			});
+		}
+
+		if (!cache_loaded && cache_enabled)
+		{
+			if (cache_path.empty()) cache_path = DefaultCachePath();
+			cache.Load(cache_path.c_str());
+			cache_loaded = true;
+		}
+
+		// Cache hits are resolved for all groups before scanning, so that objects whose AOBs are all cached
+		// complete immediately
+		struct GroupScan
+		{
+			std::vector<ScanRegion> regions;
+			uint64_t regions_key;
+			std::vector<std::shared_ptr<AobEntry>> misses;
+		};
+		std::vector<GroupScan> scans;
+		size_t cache_hits = 0, scanned = 0;
+		for (const auto& [filters, entries] : pending)
+		{
+			GroupScan& scan = scans.emplace_back();
+			scan.regions = FindRegions(filters.first, filters.second);
+			scan.regions_key = AobCache::HashBasis;
+			for (const auto& region : scan.regions)
+				scan.regions_key = AobCache::Hash(&region.identity, sizeof(region.identity), scan.regions_key);
+
+			// Cached locations are trusted if the bytes there still match, since the sections are the same
+			for (const auto& entry : entries)
+			{
+				const CompiledAob& aob = entry->aob;
+				const std::vector<ScanRegion>& regions = scan.regions;
+				AobCache::Location loc;
+				if (cache_enabled && cache.Lookup(AobCache::Key(aob, scan.regions_key), loc) && loc.region < regions.size()
+					&& loc.offset + aob.length <= (size_t)(regions[loc.region].end - regions[loc.region].begin)
+					&& aob.Matches(regions[loc.region].begin + loc.offset))
+				{
+					ResolveEntry(*entry, regions[loc.region].begin + loc.offset);
+					cache_hits++;
+				}
+				else scan.misses.push_back(entry);
+			}
+		}
+
+		for (const GroupScan& scan : scans)
+		{
+			if (scan.misses.empty()) continue;
+
+			const auto& misses = scan.misses;
+			std::vector<const uint8_t*> results(misses.size(), nullptr);
+			ScanGroup(scan.regions, misses, results.data(), [&](size_t i, const uint8_t* result) {
+				ResolveEntry(*misses[i], result);
+			});
+			scanned += misses.size();
+
+			for (size_t i = 0; i < misses.size(); i++)
+			{
+				if (results[i] == nullptr) ResolveEntry(*misses[i], nullptr);
+				if (!cache_enabled) continue;
+
+				uint64_t key = AobCache::Key(misses[i]->aob, scan.regions_key);
+				if (results[i] == nullptr)
+				{
+					cache.Erase(key);
+					continue;
+				}
+				for (uint32_t r = 0; r < scan.regions.size(); r++)
+				{
+					if (results[i] < scan.regions[r].begin || results[i] >= scan.regions[r].end) continue;
+					cache.Store(key, AobCache::Location{ .region = r, .offset = (uint32_t)(results[i] - scan.regions[r].begin) });
+					break;
+				}
+			}
+		}
+
+		if (cache_enabled && !cache.Save(cache_path.c_str()))
+			C<Logger>()->Warn(this, "Could not write the AOB cache to \"{}\"", cache_path);
+		C<Logger>()->Debug(this, "{} AOBs resolved from the cache, {} scanned", cache_hits, scanned);
+	}
+
+	size_t AobScanManImp::GenerateSignature(uintptr_t address, AobChar* out, size_t max_length)
+	{
+		ModuleIndex::SectionInfo section;
+		ModuleIndex::ModuleInfo mod_info;
+		if (!C<ModuleIndex>()->FindSection(address, &section) || !C<ModuleIndex>()->FindModule(address, &mod_info))
+			return 0;
+
+		const uint8_t* begin = (const uint8_t*)section.begin;
+		const uint8_t* end = begin + section.size;
+		const uint8_t* target = (const uint8_t*)address;
+		size_t length = (std::min)(max_length, (size_t)(end - target));
+
+		// Instructions are taken from CodeAnalysis, which caches the decoded functions. Code outside of the
+		// discovered functions (or not starting on an instruction boundary) is decoded from there on
+		std::vector<AobChar> aob(length);
+		for (size_t i = 0; i < length; i++) aob[i] = AobChar(target[i], 0xFF);
+		auto wildcard = [&](size_t offset, size_t size) {
+			for (size_t i = offset; i < offset + size && i < length; i++) aob[i] = AobChar(0, 0);
+		};
+
+		size_t pos = 0;
+		for (CodeAnalysis::Instruction instr; pos < length; pos += instr.length)
+		{
+			uintptr_t start;
+			if (!C<CodeAnalysis>()->FindInstruction(address + pos, &start, &instr) || start != address + pos) break;
+
+			if (instr.disp_size >= 4) wildcard(pos + instr.disp_offset, instr.disp_size);
+			if (instr.imm_size == 0) continue;
+
+			// Relative immediates are only those of direct branches
+			uint64_t imm = 0;
+			memcpy(&imm, target + pos + instr.imm_offset, (std::min)((size_t)instr.imm_size, sizeof(imm)));
+			bool relative = instr.flags & (CodeAnalysis::InstrCall | CodeAnalysis::InstrJump | CodeAnalysis::InstrCondJump);
+			bool pointer = instr.imm_size >= 4 && imm >= mod_info.base && imm < mod_info.base + mod_info.size;
+			if (relative || pointer) wildcard(pos + instr.imm_offset, instr.imm_size);
+		}
+		if (pos < length)
+			AobSigGen::MaskInstructions(target + pos, length - pos, mod_info.base, mod_info.base + mod_info.size, aob.data() + pos);
+		length = AobSigGen::ShortestUnique(aob.data(), length, target, begin, end);
+		std::copy_n(aob.begin(), length, out);
+		return length;
+	}
+
+	void AobScanManImp::SigCommand::Run(const char* args[], size_t count)
+	{
+		auto cmd_man = man->C<CommandMan>();
+		if (count < 1 || count > 2)
+		{
+			cmd_man->Print(HelpMessage());
+			return;
+		}
+
+		// Either an absolute address, or an offset from the base of a module
+		uintptr_t address;
+		const char* plus = strrchr(args[0], '+');
+		if (plus != nullptr)
+		{
+			ModuleIndex::ModuleInfo mod_info;
+			std::string mod_name(args[0], plus);
+			if (!man->C<ModuleIndex>()->FindModuleByName(mod_name.c_str(), &mod_info))
+			{
+				cmd_man->Print(std::format("Module \"{}\" not found", mod_name).c_str());
+				return;
+			}
+			address = mod_info.base + (uintptr_t)strtoull(plus + 1, nullptr, 16);
+		}
+		else address = (uintptr_t)strtoull(args[0], nullptr, 16);
+
+		size_t max_length = (std::min)(count > 1 ? (size_t)strtoull(args[1], nullptr, 10) : 64, MaxSignatureLength);
+		std::vector<AobChar> aob(max_length);
+		size_t length = man->GenerateSignature(address, aob.data(), max_length);
+		if (length == 0)
+		{
+			cmd_man->Print(std::format("No unique AOB of up to {} bytes at {:#x}", max_length, address).c_str());
+			return;
+		}
+		cmd_man->Print(FormatAobString(aob.data(), length).c_str());
+	}
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include "Include/AobScanMan.h"
+#include "Include/Logger.h"
+#include "Include/ModuleIndex.h"
+#include "Include/CodeAnalysis.h"
+#include "Include/CommandMan.h"
+#include "Include/Export.h"
+#include "AobScanner.h"
+#include "AobMultiScanner.h"
+#include "ThreadPool.h"
+#include "AobCache.h"
+#include "AobGramIndex.h"
+
+#include <unordered_map>
+#include <string>
+#include <functional>
+#include <map>
+#include <deque>
+#include <thread>
+#include <shared_mutex>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace MCF
+{
+	class AobScanManImp final : public SharedInterfaceImp<AobScanMan, AobScanManImp, DepList<EventMan, Logger, ModuleIndex, CommandMan, CodeAnalysis>>
+	{
+	private:
+		struct AobEntry
+		{
+			AobHandle handle;
+			CompiledAob aob;
+			const void* obj;
+			uintptr_t* out_result;
+			ModuleFilter module_filter;
+			SectionFilter section_filter;
+			std::vector<AobResolveStep> steps;
+			uintptr_t result = 0; // Address after applying the resolve steps
+			bool scanned = false;
+		};
+
+		/// <summary>
+		/// Executable memory of a section to scan.
+		/// </summary>
+		struct ScanRegion
+		{
+			HMODULE module;
+			const uint8_t* begin;
+			const uint8_t* end;
+			uint64_t identity; // Hash of the module and section headers, see AobCache
+		};
+
+		// Minimum number of AOBs sharing filters for which the multi-pattern scanner is used
+		static constexpr size_t MultiScanThreshold = 16;
+
+		// Size of the pieces of sections scanned in parallel
+		static constexpr size_t ChunkSize = 1 << 20;
+
+		/// <summary>
+		/// Number of registered AOBs of an object which were not scanned yet, and of those which were not found.
+		/// </summary>
+		struct ObjState
+		{
+			size_t count = 0;
+			size_t unscanned = 0;
+			size_t failed = 0;
+		};
+
+		std::unordered_map<AobHandle, std::shared_ptr<AobEntry>> aobs;
+		std::unordered_map<const void*, ObjState> objs; // Kept in sync with aobs, so that completion is checked in constant time
+		AobHandle next_handle = 1;
+		std::mutex mutex;
+		std::mutex scan_mutex;
+		std::unordered_multimap<const void*, HCallResult> waiters; // Call results bound by AwaitObj
+		std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>();
+
+		AobCache cache;
+		std::string cache_path;
+		bool cache_enabled = true;
+		bool cache_loaded = false;
+
+		// Cache file in the temp directory, named after the executable
+		static std::string DefaultCachePath();
+
+		// Optional 4-gram index of the executable sections of each module, used by QueryPattern
+		std::map<const uint8_t*, std::shared_ptr<AobGramIndex>> gram_indices; // By section begin
+		std::shared_mutex gram_mutex;
+
+		// State of the background thread building the indices
+		std::deque<uintptr_t> index_queue; // Base of the modules to index
+		uintptr_t indexing_module = 0;
+		bool indexing_cancelled = false; // Set when indexing_module is unloaded, so that its index is discarded
+		size_t index_budget = 0;
+		size_t index_used = 0;
+		bool index_stop = false;
+		std::mutex index_mutex;
+		std::condition_variable index_cv;
+		std::thread index_thread;
+
+		void IndexLoop();
+		void IndexModule(uintptr_t base);
+
+		// Modules loaded since the scan, searched by late_thread for the AOBs which were not found. They are not
+		// scanned by the load event, which runs under EventMan's callback lock
+		std::deque<ModuleIndex::ModuleInfo> late_queue;
+		bool late_stop = false;
+		std::mutex late_mutex;
+		std::condition_variable late_cv;
+		std::thread late_thread;
+
+		void LateScanLoop();
+		void ScanLateModule(const ModuleIndex::ModuleInfo& mod_info);
+
+		static CompiledAob Compile(const AobChar* aob, size_t length);
+
+		// Find the sections selected by a pair of filters
+		std::vector<ScanRegion> FindRegions(ModuleFilter module_filter, SectionFilter section_filter);
+
+		// Append the sections of a module selected by a section filter
+		void AppendRegions(const ModuleIndex::ModuleInfo& mod_info, SectionFilter section_filter, std::vector<ScanRegion>& regions);
+
+		// Find the first match of each AOB in a list of regions, writing it to results. on_found is called from
+		// the scan threads as soon as the match of an AOB is known to be the first one
+		void ScanGroup(const std::vector<ScanRegion>& regions, const std::vector<std::shared_ptr<AobEntry>>& entries,
+			const uint8_t** results, const std::function<void(size_t, const uint8_t*)>& on_found);
+
+		// Apply the resolve steps of an AOB to its match. Returns 0 if not found or if a step failed
+		uintptr_t ApplySteps(const AobEntry& entry, const uint8_t* match);
+
+		// Set the result of a scanned AOB, and notify its object if it was the last one remaining
+		void ResolveEntry(AobEntry& entry, const uint8_t* match);
+
+		// Mark an AOB as scanned with a result and update the state of its object. Must hold mutex
+		void SetResult(AobEntry& entry, uintptr_t result);
+
+		// Remove a registered AOB from the state of its object. Must hold mutex
+		void ForgetEntry(const AobEntry& entry);
+
+		// Check if all AOBs of an object were scanned, and if they were all found. Must hold mutex
+		bool IsObjComplete(const void* obj, bool& success);
+
+		void NotifyObjComplete(const void* obj, bool success, const std::vector<HCallResult>& call_results);
+
+		// AOBs which were not found are searched for in modules loaded after the scan, see late_thread
+		void OnModuleLoaded(ModuleIndex::ModuleLoadedEvent* evt);
+		void OnModuleUnloaded(ModuleIndex::ModuleUnloadedEvent* evt);
+
+		EventCallback<ModuleIndex::ModuleLoadedEvent> module_loaded_cb = [this](ModuleIndex::ModuleLoadedEvent* evt) {
+			OnModuleLoaded(evt);
+		};
+		EventCallback<ModuleIndex::ModuleUnloadedEvent> module_unloaded_cb = [this](ModuleIndex::ModuleUnloadedEvent* evt) {
+			OnModuleUnloaded(evt);
+		};
+
+		class SigCommand : public CommandBase
+		{
+			AobScanManImp* man;
+
+			// Largest max_length accepted, which bounds the buffer allocated for the AOB
+			static constexpr size_t MaxSignatureLength = 4096;
+
+		public:
+			SigCommand(AobScanManImp* man) : man(man) { }
+
+			virtual void Run(const char* args[], size_t count) override;
+			virtual const char* Name() const override { return "aob_sig"; }
+			virtual const char* HelpMessage() const override
+			{
+				return "aob_sig <address|module+offset> [max_length]: Generate the shortest unique AOB for an address, of up to 4096 bytes";
+			}
+		} sig_cmd{ this };
+
+	public:
+		AobScanManImp();
+		~AobScanManImp();
+
+		virtual bool IsUnloadable() const override { return true; }
+
+		virtual AobHandle RegisterAob(const AobChar* aob, size_t length, const void* obj, uintptr_t* out_result, 
+			ModuleFilter module_filter, SectionFilter section_filter, const AobResolveStep* steps, size_t num_steps) override;
+
+		virtual void UnregisterAob(AobHandle handle) override;
+
+		virtual void UnregisterAobsForObj(const void* obj) override;
+
+		virtual uintptr_t QueryAobResult(AobHandle handle) override;
+
+		virtual void ScanPending() override;
+
+		virtual HCallResult AwaitObj(const void* obj, CallResultBase* call_result) override;
+
+		virtual void SetScanThreadCount(size_t count) override;
+
+		virtual void SetCachePath(const char* path) override;
+
+		virtual void SetQueryIndexBudget(size_t max_bytes) override;
+
+		virtual uintptr_t QueryPattern(const AobChar* aob, size_t length, ModuleFilter module_filter, SectionFilter section_filter) override;
+
+		virtual size_t GenerateSignature(uintptr_t address, AobChar* out, size_t max_length) override;
+	};
+
+	MCF_COMPONENT_EXPORT(AobScanManImp);
+}
@@ -0,0 +1,249 @@
+#include "AobScanner.h"
+#include <string.h>
+#include <algorithm>
+#include <bit>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MCF_AOB_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MCF_TARGET(isa)
+#else
+#include <cpuid.h>
+#define MCF_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace MCF
+{
+	static const uint8_t byte_frequency[256] = {
+		255, 182, 140, 132, 145, 146, 113, 117, 167, 114, 108, 100, 122, 114,  98, 208,
+		160, 110,  94,  92, 113, 113,  94,  94, 142,  82,  79,  80,  93,  88, 107, 158,
+		141,  87,  83,  84, 196, 108,  72,  74, 134, 119,  74,  96,  89,  87, 107,  89,
+		119, 161,  69,  87,  92, 112,  68,  69, 116, 132,  74,  91, 103, 130,  69,  80,
+		143, 176,  92, 118, 172, 144,  97, 105, 234, 164,  84,  83, 183, 129,  77,  78,
+		125,  76,  76, 119, 133, 125,  98,  94, 101,  69,  74, 119, 122, 126,  93,  89,
+		107,  63,  64, 105, 101,  70, 150,  63,  94,  64,  72,  76,  99,  80,  90,  87,
+		102,  72,  85,  93, 157, 139,  81,  82, 108,  74,  73,  94, 124,  91,  90,  95,
+		139, 112,  80, 179, 173, 185,  79,  92, 113, 214,  71, 202,  86, 172,  80,  79,
+		119,  60,  62,  72,  96,  94,  65,  67,  86,  64,  57,  59,  81,  61,  59,  62,
+		 87,  61,  59,  64,  69,  66,  66,  57,  88,  65,  61,  78,  74,  59,  58,  70,
+		 85,  60,  58,  68,  80,  66, 119,  83, 110,  95, 114,  79,  86,  78, 123, 111,
+		175, 128, 117, 137, 123, 115, 123, 144, 105, 112,  88,  72, 200,  78,  80,  74,
+		113,  84, 121,  82,  74,  81,  83,  78, 101,  79,  85, 100,  71,  77,  97, 132,
+		124,  99,  97,  74,  93,  81,  98, 110, 191, 167, 104, 131, 115, 113, 113, 133,
+		115,  93, 110, 114,  89,  97, 139, 118, 129, 105, 125, 117, 113, 125, 138, 221,
+	};
+
+	CompiledAob::CompiledAob(const uint8_t* bytes, const uint8_t* masks, size_t length) : length(length)
+	{
+		size_t padded = (length + 31) & ~(size_t)31;
+		this->bytes.assign(padded, 0);
+		this->masks.assign(padded, 0);
+
+		// Fully masked rare bytes make the best anchors, followed by partially masked ones
+		auto score = [&](size_t i) {
+			return std::popcount(masks[i]) * 256 + (masks[i] == 0xFF ? 255 - byte_frequency[bytes[i]] : 0);
+		};
+
+		int best[2] = { -1, -1 };
+		for (size_t i = 0; i < length; i++)
+		{
+			this->masks[i] = masks[i];
+			this->bytes[i] = bytes[i] & masks[i];
+			if (masks[i] == 0) continue;
+
+			all_wildcard = false;
+			int s = score(i);
+			if (s > best[0])
+			{
+				best[1] = best[0];
+				anchors[1] = anchors[0];
+				best[0] = s;
+				anchors[0] = (uint32_t)i;
+			}
+			else if (s > best[1])
+			{
+				best[1] = s;
+				anchors[1] = (uint32_t)i;
+			}
+		}
+		if (best[1] < 0) anchors[1] = anchors[0];
+	}
+
+	namespace AobScanner
+	{
+		uint8_t ByteFrequency(uint8_t byte)
+		{
+			return byte_frequency[byte];
+		}
+
+		static Kernel DetectKernel()
+		{
+#ifdef MCF_AOB_X86
+			int regs[4];
+#ifdef _MSC_VER
+			__cpuid(regs, 0);
+			int max_leaf = regs[0];
+			__cpuid(regs, 1);
+#else
+			unsigned max_leaf = __get_cpuid_max(0, nullptr);
+			__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+			bool sse42 = regs[2] & (1 << 20);
+			bool osxsave = regs[2] & (1 << 27);
+			bool avx = regs[2] & (1 << 28);
+
+			bool avx2 = false;
+			if (max_leaf >= 7 && osxsave && avx)
+			{
+#ifdef _MSC_VER
+				__cpuidex(regs, 7, 0);
+				uint64_t xcr0 = _xgetbv(0);
+#else
+				__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+				uint32_t xcr0_lo, xcr0_hi;
+				__asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+				uint64_t xcr0 = ((uint64_t)xcr0_hi << 32) | xcr0_lo;
+#endif
+				// The OS must save the YMM registers
+				avx2 = (regs[1] & (1 << 5)) && (xcr0 & 6) == 6;
+			}
+
+			if (avx2) return Kernel::AVX2;
+			if (sse42) return Kernel::SSE42;
+#endif
+			return Kernel::Scalar;
+		}
+
+		Kernel BestKernel()
+		{
+			static const Kernel kernel = DetectKernel();
+			return kernel;
+		}
+
+		static const uint8_t* FindScalar(const CompiledAob& aob, const uint8_t* begin, const uint8_t* end)
+		{
+			const uint8_t* last = end - aob.length;
+			uint32_t anchor = aob.anchors[0];
+
+			if (aob.masks[anchor] != 0xFF)
+			{
+				for (const uint8_t* p = begin; p <= last; p++)
+					if (aob.Matches(p)) return p;
+				return nullptr;
+			}
+
+			// Let memchr find the anchor byte
+			const uint8_t* p = begin + anchor;
+			while (p <= last + anchor)
+			{
+				p = (const uint8_t*)memchr(p, aob.bytes[anchor], (last + anchor) - p + 1);
+				if (p == nullptr) return nullptr;
+				if (aob.Matches(p - anchor)) return p - anchor;
+				p++;
+			}
+			return nullptr;
+		}
+
+#ifdef MCF_AOB_X86
+		MCF_TARGET("sse4.2")
+		static inline bool VerifySSE(const CompiledAob& aob, const uint8_t* p)
+		{
+			size_t padded = aob.bytes.size();
+			for (size_t i = 0; i < padded; i += 16)
+			{
+				__m128i data = _mm_loadu_si128((const __m128i*)(p + i));
+				__m128i diff = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)(aob.bytes.data() + i)));
+				if (!_mm_testz_si128(diff, _mm_loadu_si128((const __m128i*)(aob.masks.data() + i)))) return false;
+			}
+			return true;
+		}
+
+		MCF_TARGET("sse4.2")
+		static const uint8_t* FindSSE42(const CompiledAob& aob, const uint8_t* begin, const uint8_t* end)
+		{
+			uint32_t a0 = aob.anchors[0], a1 = aob.anchors[1];
+			__m128i b0 = _mm_set1_epi8((char)aob.bytes[a0]), m0 = _mm_set1_epi8((char)aob.masks[a0]);
+			__m128i b1 = _mm_set1_epi8((char)aob.bytes[a1]), m1 = _mm_set1_epi8((char)aob.masks[a1]);
+
+			// Positions whose 16 candidates can all be verified without reading past the end
+			size_t size = end - begin, reach = aob.bytes.size() + 15;
+			const uint8_t* p = begin;
+			if (size >= reach)
+			{
+				for (const uint8_t* vec_end = end - reach; p <= vec_end; p += 16)
+				{
+					__m128i eq0 = _mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i*)(p + a0)), m0), b0);
+					__m128i eq1 = _mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i*)(p + a1)), m1), b1);
+					uint32_t bits = (uint32_t)_mm_movemask_epi8(_mm_and_si128(eq0, eq1));
+					while (bits != 0)
+					{
+						const uint8_t* cand = p + std::countr_zero(bits);
+						if (VerifySSE(aob, cand)) return cand;
+						bits &= bits - 1;
+					}
+				}
+			}
+			return FindScalar(aob, p, end);
+		}
+
+		MCF_TARGET("avx2")
+		static inline bool VerifyAVX2(const CompiledAob& aob, const uint8_t* p)
+		{
+			size_t padded = aob.bytes.size();
+			for (size_t i = 0; i < padded; i += 32)
+			{
+				__m256i data = _mm256_loadu_si256((const __m256i*)(p + i));
+				__m256i diff = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i*)(aob.bytes.data() + i)));
+				if (!_mm256_testz_si256(diff, _mm256_loadu_si256((const __m256i*)(aob.masks.data() + i)))) return false;
+			}
+			return true;
+		}
+
+		MCF_TARGET("avx2")
+		static const uint8_t* FindAVX2(const CompiledAob& aob, const uint8_t* begin, const uint8_t* end)
+		{
+			uint32_t a0 = aob.anchors[0], a1 = aob.anchors[1];
+			__m256i b0 = _mm256_set1_epi8((char)aob.bytes[a0]), m0 = _mm256_set1_epi8((char)aob.masks[a0]);
+			__m256i b1 = _mm256_set1_epi8((char)aob.bytes[a1]), m1 = _mm256_set1_epi8((char)aob.masks[a1]);
+
+			// Positions whose 32 candidates can all be verified without reading past the end
+			size_t size = end - begin, reach = aob.bytes.size() + 31;
+			const uint8_t* p = begin;
+			if (size >= reach)
+			{
+				for (const uint8_t* vec_end = end - reach; p <= vec_end; p += 32)
+				{
+					__m256i eq0 = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_loadu_si256((const __m256i*)(p + a0)), m0), b0);
+					__m256i eq1 = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_loadu_si256((const __m256i*)(p + a1)), m1), b1);
+					uint32_t bits = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(eq0, eq1));
+					while (bits != 0)
+					{
+						const uint8_t* cand = p + std::countr_zero(bits);
+						if (VerifyAVX2(aob, cand)) return cand;
+						bits &= bits - 1;
+					}
+				}
+			}
+			return FindScalar(aob, p, end);
+		}
+#endif
+
+		const uint8_t* Find(const CompiledAob& aob, const uint8_t* begin, const uint8_t* end, Kernel kernel)
+		{
+			if (aob.length == 0 || (size_t)(end - begin) < aob.length) return nullptr;
+			if (aob.all_wildcard) return begin;
+
+			switch (kernel)
+			{
+#ifdef MCF_AOB_X86
+			case Kernel::AVX2: return FindAVX2(aob, begin, end);
+			case Kernel::SSE42: return FindSSE42(aob, begin, end);
+#endif
+			default: return FindScalar(aob, begin, end);
+			}
+		}
+	}
+}
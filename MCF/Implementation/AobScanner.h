@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Masked byte pattern prepared for scanning. Bytes and masks are padded with wildcards to a multiple of
+	/// 32 bytes so that vector kernels can verify candidates without handling a partial block.
+	/// </summary>
+	struct CompiledAob
+	{
+		std::vector<uint8_t> bytes; // Pattern bytes, pre-masked
+		std::vector<uint8_t> masks;
+		size_t length = 0;
+
+		// Offsets of the two most selective bytes, compared first at every position. 
+		// Equal if the pattern has a single non-wildcard byte.
+		uint32_t anchors[2]{ };
+		bool all_wildcard = true;
+
+		CompiledAob() { }
+		CompiledAob(const uint8_t* bytes, const uint8_t* masks, size_t length);
+
+		inline bool Matches(const uint8_t* p) const
+		{
+			for (size_t i = 0; i < length; i++)
+				if ((p[i] & masks[i]) != bytes[i]) return false;
+			return true;
+		}
+
+		/// <summary>
+		/// Like Matches, but compares 8 bytes at a time. p must be readable up to the padded length of the pattern.
+		/// </summary>
+		inline bool MatchesPadded(const uint8_t* p) const
+		{
+			for (size_t i = 0; i < bytes.size(); i += 8)
+			{
+				uint64_t data, b, m;
+				memcpy(&data, p + i, 8);
+				memcpy(&b, bytes.data() + i, 8);
+				memcpy(&m, masks.data() + i, 8);
+				if ((data & m) != b) return false;
+			}
+			return true;
+		}
+	};
+
+	/// <summary>
+	/// Platform-neutral masked byte scanner, with AVX2 and SSE4.2 kernels selected at runtime by CPUID and a 
+	/// scalar fallback. Candidates are found by comparing the two anchor bytes of the pattern over whole vectors, 
+	/// and then verified with vector compares.
+	/// </summary>
+	namespace AobScanner
+	{
+		enum class Kernel { Scalar, SSE42, AVX2 };
+
+		/// <summary>
+		/// The fastest kernel supported by the CPU and OS.
+		/// </summary>
+		Kernel BestKernel();
+
+		/// <summary>
+		/// Approximate frequency of a byte in x86 machine code, from 0 (rare) to 255 (most common). 
+		/// Used to choose the anchors of a pattern.
+		/// </summary>
+		uint8_t ByteFrequency(uint8_t byte);
+
+		/// <summary>
+		/// Find the first occurence of a pattern in [begin, end).
+		/// </summary>
+		/// <returns>A pointer to the match, or null if not found.</returns>
+		const uint8_t* Find(const CompiledAob& aob, const uint8_t* begin, const uint8_t* end, Kernel kernel = BestKernel());
+	}
+}
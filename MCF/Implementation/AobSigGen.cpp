@@ -0,0 +1,72 @@
+#include "AobSigGen.h"
+#include "AobMultiScanner.h"
+#include <Zydis/Zydis.h>
+#include <vector>
+#include <algorithm>
+
+namespace MCF
+{
+	namespace AobSigGen
+	{
+		void MaskInstructions(const uint8_t* code, size_t length, uintptr_t image_begin, uintptr_t image_end, AobChar* out)
+		{
+			for (size_t i = 0; i < length; i++) out[i] = AobChar(code[i], 0xFF);
+
+			ZydisDecoder decoder;
+			ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_ADDRESS_WIDTH_64);
+
+			auto wildcard = [&](size_t offset, size_t size) {
+				for (size_t i = offset; i < offset + size && i < length; i++) out[i] = AobChar(0, 0);
+			};
+
+			ZydisDecodedInstruction instr;
+			for (size_t pos = 0; pos < length; pos += instr.length)
+			{
+				size_t available = (std::min)(length - pos, (size_t)ZYDIS_MAX_INSTRUCTION_LENGTH);
+				if (!ZYAN_SUCCESS(ZydisDecoderDecodeBuffer(&decoder, code + pos, available, &instr)))
+					break;
+
+				if (instr.raw.disp.size >= 32) wildcard(pos + instr.raw.disp.offset, instr.raw.disp.size / 8);
+				for (const auto& imm : instr.raw.imm)
+				{
+					if (imm.size == 0) continue;
+					bool address = imm.size >= 32 && imm.value.u >= image_begin && imm.value.u < image_end;
+					if (imm.is_relative || address) wildcard(pos + imm.offset, imm.size / 8);
+				}
+			}
+		}
+
+		size_t ShortestUnique(const AobChar* aob, size_t length, const uint8_t* target, const uint8_t* begin, const uint8_t* end)
+		{
+			// Ending on a wildcard matches the same positions as the shorter prefix, so only those ending on a known 
+			// byte are candidates
+			std::vector<CompiledAob> candidates;
+			std::vector<uint8_t> bytes(length), masks(length);
+			for (size_t i = 0; i < length; i++)
+			{
+				bytes[i] = aob[i].byte;
+				masks[i] = aob[i].mask;
+				if (masks[i] != 0) candidates.emplace_back(bytes.data(), masks.data(), i + 1);
+			}
+			if (candidates.empty()) return 0;
+
+			std::vector<const CompiledAob*> ptrs;
+			for (const auto& c : candidates) ptrs.push_back(&c);
+			AobMultiScanner scanner(ptrs.data(), ptrs.size());
+
+			// Candidates first found at the target are unique if they are not found after it
+			std::vector<const uint8_t*> first(ptrs.size(), nullptr);
+			scanner.FindFirst(begin, end, first.data());
+
+			std::vector<const uint8_t*> next(ptrs.size(), nullptr);
+			for (size_t i = 0; i < ptrs.size(); i++)
+				if (first[i] != target) next[i] = target; // Already ambiguous, skipped by the second pass
+
+			if (target + 1 < end) scanner.FindFirst(target + 1, end, next.data());
+
+			for (size_t i = 0; i < ptrs.size(); i++)
+				if (next[i] == nullptr) return candidates[i].length;
+			return 0;
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Include/AobPattern.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace MCF
+{
+	/// <summary>
+	/// Generates AOBs matching a single address, decoding instructions with Zydis.
+	/// </summary>
+	namespace AobSigGen
+	{
+		/// <summary>
+		/// Convert the instructions in [code, code + length) to an AOB, wildcarding the bytes which change with
+		/// relocations and patches: relative branch targets, 32-bit displacements (including RIP-relative ones) and
+		/// immediates pointing into [image_begin, image_end). Bytes which cannot be decoded, including an instruction
+		/// cut by the end, are kept as is.
+		/// </summary>
+		void MaskInstructions(const uint8_t* code, size_t length, uintptr_t image_begin, uintptr_t image_end, AobChar* out);
+
+		/// <summary>
+		/// Find the shortest prefix of an AOB matching at target which has no other match in [begin, end). 
+		/// All candidate prefixes are searched in two passes of the multi-pattern scanner.
+		/// </summary>
+		/// <returns>The length of the prefix, or 0 if even the whole AOB is ambiguous.</returns>
+		size_t ShortestUnique(const AobChar* aob, size_t length, const uint8_t* target, const uint8_t* begin, const uint8_t* end);
+	}
+}
@@ -0,0 +1,71 @@
+#include "CandidateBlock.h"
+#include <string.h>
+
+namespace MCF
+{
+	void CandidateBlock::Assign(const uint64_t* bits, size_t count)
+	{
+		size_t words = ((size_t)slots + 63) / 64;
+		this->count = (uint32_t)count;
+		set.clear();
+
+		if (count == slots)
+		{
+			encoding = Encoding::All;
+			set.shrink_to_fit();
+			return;
+		}
+
+		// Deltas take at least a byte each, so only encode them if they might be smaller than the bitmap
+		size_t bitmap_size = words * 8;
+		if (count < bitmap_size)
+		{
+			encoding = Encoding::Deltas;
+			uint32_t prev = 0;
+			for (size_t w = 0; w < words && set.size() < bitmap_size; w++)
+			{
+				for (uint64_t word = bits[w]; word != 0; word &= word - 1)
+				{
+					uint32_t slot = (uint32_t)(w * 64 + std::countr_zero(word));
+					for (uint32_t delta = slot - prev; ; delta >>= 7)
+					{
+						if (delta < 0x80)
+						{
+							set.push_back((uint8_t)delta);
+							break;
+						}
+						set.push_back((uint8_t)(delta | 0x80));
+					}
+					prev = slot;
+				}
+			}
+			if (set.size() < bitmap_size)
+			{
+				set.shrink_to_fit();
+				return;
+			}
+		}
+
+		encoding = Encoding::Bitmap;
+		set.resize(bitmap_size);
+		memcpy(set.data(), bits, bitmap_size);
+		set.shrink_to_fit();
+	}
+
+	void CandidateBlock::Bounds(uint32_t& first, uint32_t& last) const
+	{
+		if (encoding == Encoding::All)
+		{
+			first = 0;
+			last = slots - 1;
+			return;
+		}
+
+		bool any = false;
+		ForEach([&](uint32_t slot) {
+			if (!any) first = slot;
+			any = true;
+			last = slot;
+		});
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+#include <bit>
+
+namespace MCF
+{
+	/// <summary>
+	/// Candidates of a value scan in a piece of memory, as the indices of the slots (aligned positions) they are at.
+	/// Dense candidates are stored as a bitmap and sparse ones as the LEB128-encoded deltas between consecutive
+	/// indices, whichever is smaller, so that a scan of a large heap keeps a fraction of its size once narrowed down.
+	/// </summary>
+	struct CandidateBlock
+	{
+		enum class Encoding : uint8_t { All, Bitmap, Deltas };
+
+		uintptr_t begin; // Address of slot 0
+		uint32_t slots; // Number of slots, whether they are candidates or not
+		uint32_t count = 0;
+		Encoding encoding = Encoding::All;
+		std::vector<uint8_t> set; // Bitmap or deltas, empty if all slots are candidates
+		std::vector<uint8_t> values; // Value of each candidate at the last scan, in order
+
+		/// <summary>
+		/// Replace the candidates by the set bits of a bitmap of (slots + 63) / 64 words, with count set bits.
+		/// </summary>
+		void Assign(const uint64_t* bits, size_t count);
+
+		/// <summary>
+		/// Call fn(slot) for each candidate, in increasing order.
+		/// </summary>
+		template<typename Fn>
+		void ForEach(Fn&& fn) const
+		{
+			switch (encoding)
+			{
+			case Encoding::All:
+				for (uint32_t i = 0; i < slots; i++) fn(i);
+				break;
+			case Encoding::Bitmap:
+				for (size_t w = 0; w < set.size() / 8; w++)
+				{
+					uint64_t word;
+					memcpy(&word, set.data() + w * 8, 8);
+					for (; word != 0; word &= word - 1) fn((uint32_t)(w * 64 + std::countr_zero(word)));
+				}
+				break;
+			case Encoding::Deltas:
+			{
+				uint32_t slot = 0;
+				for (size_t p = 0; p < set.size(); )
+				{
+					uint32_t delta = 0;
+					for (int shift = 0; ; shift += 7)
+					{
+						uint8_t b = set[p++];
+						delta |= (uint32_t)(b & 0x7F) << shift;
+						if (!(b & 0x80)) break;
+					}
+					slot += delta;
+					fn(slot);
+				}
+				break;
+			}
+			}
+		}
+
+		/// <summary>
+		/// Index of the first and last candidates. The block must not be empty.
+		/// </summary>
+		void Bounds(uint32_t& first, uint32_t& last) const;
+	};
+}
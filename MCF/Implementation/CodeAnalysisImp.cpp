@@ -0,0 +1,172 @@
+#include "CodeAnalysisImp.h"
+#include "ModuleRef.h"
+#include <Zydis/Zydis.h>
+#include <algorithm>
+
+namespace MCF
+{
+	std::shared_ptr<CodeAnalysisImp::ModuleCode> CodeAnalysisImp::GetModule(uintptr_t address)
+	{
+		// Read before looking up the module, so that an unload after the lookup is noticed before inserting
+		uint64_t generation = C<ModuleIndex>()->Generation();
+		ModuleIndex::ModuleInfo mod_info;
+		if (!C<ModuleIndex>()->FindModule(address, &mod_info)) return nullptr;
+		{
+			std::shared_lock<decltype(mutex)> lock(mutex);
+			auto it = modules.find(mod_info.base);
+			if (it != modules.end()) return it->second;
+		}
+
+		// Another thread may have analyzed the module while we waited
+		std::lock_guard<decltype(analyze_mutex)> analyze_lock(analyze_mutex);
+		{
+			std::shared_lock<decltype(mutex)> lock(mutex);
+			auto it = modules.find(mod_info.base);
+			if (it != modules.end()) return it->second;
+		}
+
+		// Unload events may come after the module is unmapped, so it is kept loaded while it is analyzed
+		ModuleRef ref(mod_info.base);
+		if (!ref) return nullptr;
+
+		std::vector<ModuleIndex::SectionInfo> sections(mod_info.num_sections);
+		sections.resize((std::min)(sections.size(), C<ModuleIndex>()->GetSections(mod_info.base, sections.data(), sections.size())));
+
+		auto code = std::make_shared<ModuleCode>();
+		code->functions = FunctionDiscovery::Discover(mod_info, sections, *pool);
+		C<Logger>()->Debug(this, "Found {} functions in module {}", code->functions.size(), mod_info.name);
+
+		// The unload event erases the module under the lock, so it either comes after the insertion or changed
+		// the generation before it. Other modules may have been loaded meanwhile, hence the lookup
+		std::unique_lock<decltype(mutex)> lock(mutex);
+		ModuleIndex::ModuleInfo current;
+		if (C<ModuleIndex>()->Generation() != generation && (!C<ModuleIndex>()->FindModule(mod_info.base, &current)
+			|| current.base != mod_info.base || current.timestamp != mod_info.timestamp)) return nullptr;
+		modules[mod_info.base] = code;
+		return code;
+	}
+
+	const FunctionDiscovery::Function* CodeAnalysisImp::Lookup(const ModuleCode& code, uintptr_t address, bool resolve_owner)
+	{
+		auto by_begin = [](uintptr_t a, const FunctionDiscovery::Function& fn) { return a < fn.begin; };
+		auto it = std::upper_bound(code.functions.begin(), code.functions.end(), address, by_begin);
+		if (it == code.functions.begin() || address >= (--it)->end) return nullptr;
+		if (!resolve_owner || it->owner == it->begin) return &*it;
+
+		auto owner = std::upper_bound(code.functions.begin(), code.functions.end(), it->owner, by_begin);
+		if (owner == code.functions.begin() || (--owner)->begin != it->owner) return &*it;
+		return &*owner;
+	}
+
+	CodeAnalysisImp::InstructionTable CodeAnalysisImp::Decode(uintptr_t begin, uintptr_t end)
+	{
+		ZydisDecoder decoder;
+		ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_ADDRESS_WIDTH_64);
+
+		InstructionTable table;
+		ZydisDecodedInstruction instr;
+		for (uintptr_t p = begin; p < end; p += table.back().length)
+		{
+			Instruction entry{ .target = 0, .offset = (uint32_t)(p - begin), .length = 1, .flags = 0 };
+			size_t available = (std::min)((size_t)(end - p), (size_t)ZYDIS_MAX_INSTRUCTION_LENGTH);
+			if (!ZYAN_SUCCESS(ZydisDecoderDecodeBuffer(&decoder, (const void*)p, available, &instr)))
+			{
+				entry.flags = InstrInvalid;
+				table.push_back(entry);
+				continue;
+			}
+
+			entry.length = instr.length;
+			entry.disp_offset = instr.raw.disp.offset;
+			entry.disp_size = instr.raw.disp.size / 8;
+			entry.imm_offset = instr.raw.imm[0].offset;
+			entry.imm_size = instr.raw.imm[0].size / 8;
+			switch (instr.meta.category)
+			{
+			case ZYDIS_CATEGORY_CALL: entry.flags |= InstrCall; break;
+			case ZYDIS_CATEGORY_UNCOND_BR: entry.flags |= InstrJump; break;
+			case ZYDIS_CATEGORY_COND_BR: entry.flags |= InstrCondJump; break;
+			case ZYDIS_CATEGORY_RET: entry.flags |= InstrReturn; break;
+			default: break;
+			}
+
+			for (ZyanU8 i = 0; i < instr.operand_count; i++)
+			{
+				const ZydisDecodedOperand& op = instr.operands[i];
+				bool relative = (op.type == ZYDIS_OPERAND_TYPE_IMMEDIATE && op.imm.is_relative) ||
+					(op.type == ZYDIS_OPERAND_TYPE_MEMORY && op.mem.base == ZYDIS_REGISTER_RIP);
+				ZyanU64 target;
+				if (!relative || !ZYAN_SUCCESS(ZydisCalcAbsoluteAddress(&instr, &op, p, &target))) continue;
+
+				entry.flags |= InstrRelative;
+				entry.target = (uintptr_t)target;
+				break;
+			}
+			table.push_back(entry);
+		}
+		return table;
+	}
+
+	std::shared_ptr<const CodeAnalysisImp::InstructionTable> CodeAnalysisImp::GetTable(ModuleCode& code, const FunctionDiscovery::Function& fn)
+	{
+		{
+			std::shared_lock<decltype(code.mutex)> lock(code.mutex);
+			auto it = code.decoded.find(fn.begin);
+			if (it != code.decoded.end()) return it->second;
+		}
+
+		// Decoded outside of the lock; if another thread decoded the function meanwhile, its table is kept
+		auto table = std::make_shared<const InstructionTable>(Decode(fn.begin, fn.end));
+		std::unique_lock<decltype(code.mutex)> lock(code.mutex);
+		return code.decoded.emplace(fn.begin, table).first->second;
+	}
+
+	bool CodeAnalysisImp::FindFunction(uintptr_t address, FunctionInfo* out)
+	{
+		auto code = GetModule(address);
+		const FunctionDiscovery::Function* fn = code ? Lookup(*code, address, true) : nullptr;
+		if (fn == nullptr) return false;
+
+		*out = FunctionInfo{ .begin = fn->begin, .end = fn->end, .sources = fn->sources };
+		return true;
+	}
+
+	size_t CodeAnalysisImp::GetInstructions(uintptr_t address, Instruction* out, size_t max)
+	{
+		auto code = GetModule(address);
+		const FunctionDiscovery::Function* fn = code ? Lookup(*code, address, true) : nullptr;
+		if (fn == nullptr) return 0;
+
+		auto table = GetTable(*code, *fn);
+		std::copy_n(table->begin(), (std::min)(max, table->size()), out);
+		return table->size();
+	}
+
+	bool CodeAnalysisImp::FindInstruction(uintptr_t address, uintptr_t* start, Instruction* out)
+	{
+		// Fragments are decoded separately, as they are not contiguous with their owner
+		auto code = GetModule(address);
+		const FunctionDiscovery::Function* fn = code ? Lookup(*code, address, false) : nullptr;
+		if (fn == nullptr) return false;
+
+		auto table = GetTable(*code, *fn);
+		uint32_t offset = (uint32_t)(address - fn->begin);
+		auto it = std::upper_bound(table->begin(), table->end(), offset, [](uint32_t o, const Instruction& instr) {
+			return o < instr.offset;
+		});
+		if (it == table->begin() || offset >= (--it)->offset + it->length) return false;
+
+		if (start) *start = fn->begin + it->offset;
+		if (out) *out = *it;
+		return true;
+	}
+
+	size_t CodeAnalysisImp::AnalyzeModule(const char* module_name)
+	{
+		ModuleIndex::ModuleInfo mod_info;
+		if (!C<ModuleIndex>()->FindModuleByName(module_name, &mod_info)) return 0;
+
+		auto code = GetModule(mod_info.base);
+		return code ? code->functions.size() : 0;
+	}
+}
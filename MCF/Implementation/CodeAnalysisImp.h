@@ -0,0 +1,67 @@
+#pragma once
+#include "Include/CodeAnalysis.h"
+#include "Include/ModuleIndex.h"
+#include "Include/Logger.h"
+#include "Include/Export.h"
+#include "ThreadPool.h"
+#include "FunctionDiscovery.h"
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+namespace MCF
+{
+	class CodeAnalysisImp final : public SharedInterfaceImp<CodeAnalysis, CodeAnalysisImp, DepList<EventMan, Logger, ModuleIndex>>
+	{
+	private:
+		using InstructionTable = std::vector<Instruction>;
+
+		/// <summary>
+		/// Functions of an analyzed module, and the instructions of those which were decoded.
+		/// </summary>
+		struct ModuleCode
+		{
+			std::vector<FunctionDiscovery::Function> functions; // Sorted by begin
+			std::unordered_map<uintptr_t, std::shared_ptr<const InstructionTable>> decoded; // By function start
+			std::shared_mutex mutex; // Guards decoded
+		};
+
+		std::map<uintptr_t, std::shared_ptr<ModuleCode>> modules; // By base address
+		std::shared_mutex mutex;
+		std::mutex analyze_mutex; // Held while discovering the functions of a module
+		std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>();
+
+		// Get the analysis of the module containing an address, discovering its functions if needed
+		std::shared_ptr<ModuleCode> GetModule(uintptr_t address);
+
+		// Find the function or fragment containing an address, optionally resolving fragments to their owner
+		static const FunctionDiscovery::Function* Lookup(const ModuleCode& code, uintptr_t address, bool resolve_owner);
+
+		// Get the instructions of a function, decoding them if needed
+		std::shared_ptr<const InstructionTable> GetTable(ModuleCode& code, const FunctionDiscovery::Function& fn);
+
+		static InstructionTable Decode(uintptr_t begin, uintptr_t end);
+
+		EventCallback<ModuleIndex::ModuleUnloadedEvent> module_unloaded_cb = [this](ModuleIndex::ModuleUnloadedEvent* evt) {
+			std::unique_lock<decltype(mutex)> lock(mutex);
+			modules.erase(evt->module.base);
+		};
+
+	public:
+		virtual bool IsUnloadable() const override { return true; }
+
+		virtual bool FindFunction(uintptr_t address, FunctionInfo* out) override;
+
+		virtual size_t GetInstructions(uintptr_t address, Instruction* out, size_t max) override;
+
+		virtual bool FindInstruction(uintptr_t address, uintptr_t* start, Instruction* out) override;
+
+		virtual size_t AnalyzeModule(const char* module_name) override;
+	};
+
+	MCF_COMPONENT_EXPORT(CodeAnalysisImp);
+}
@@ -0,0 +1,375 @@
+#include "CommandManImp.h"
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+namespace
+{
+	/// <summary>
+	/// Per-thread tokenizer, pooled by nesting depth since commands may run other commands.
+	/// </summary>
+	class ScratchTokenizer
+	{
+		static constexpr int PoolSize = 4;
+		static thread_local MCF::CommandTokenizer pool[PoolSize];
+		static thread_local int depth;
+
+		std::unique_ptr<MCF::CommandTokenizer> local;
+		MCF::CommandTokenizer* tok;
+
+	public:
+		ScratchTokenizer()
+		{
+			if (depth < PoolSize) tok = &pool[depth];
+			else
+			{
+				local = std::make_unique<MCF::CommandTokenizer>();
+				tok = local.get();
+			}
+			depth++;
+		}
+		~ScratchTokenizer() { depth--; }
+
+		MCF::CommandTokenizer* operator->() { return tok; }
+	};
+	thread_local MCF::CommandTokenizer ScratchTokenizer::pool[ScratchTokenizer::PoolSize];
+	thread_local int ScratchTokenizer::depth = 0;
+}
+
+namespace MCF
+{
+	thread_local CommandManImp::Invocation* CommandManImp::current_invocation = nullptr;
+	thread_local std::vector<CommandManImp::Entry*> CommandManImp::thread_held_entries;
+	thread_local std::vector<CommandManImp::Entry*>* CommandManImp::held_entries = nullptr;
+
+	CommandManImp::CommandManImp()
+	{
+		Register(&help_cmd);
+		Register(&script_cmd);
+		timeout_thread = std::thread(&CommandManImp::TimeoutThread, this);
+	}
+
+	CommandManImp::~CommandManImp()
+	{
+		// Queued commands are completed as cancelled by the pool and below, and running ones are asked to stop
+		std::deque<std::shared_ptr<Invocation>> unpumped;
+		{
+			std::lock_guard<decltype(async_mutex)> lock(async_mutex);
+			for (auto& [handle, inv] : invocations) inv->cancelled = true;
+			for (auto& [pump, queue] : pump_queues)
+				unpumped.insert(unpumped.end(), queue.begin(), queue.end());
+			pump_queues.clear();
+			timeout_stop = true;
+		}
+		timeout_cv.notify_all();
+		timeout_thread.join();
+		for (auto& inv : unpumped) Finish(inv);
+
+		Unregister(&help_cmd);
+		Unregister(&script_cmd);
+	}
+
+	bool CommandManImp::Register(CommandBase* cmd)
+	{
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		if (entries.count(cmd)) return false;
+
+		auto entry = std::make_unique<Entry>(Entry{ .cmd = cmd });
+		if (!trie.Insert(cmd->Name(), entry.get())) return false;
+		entries[cmd] = std::move(entry);
+		return true;
+	}
+
+	bool CommandManImp::Unregister(CommandBase* cmd)
+	{
+		std::unique_lock<decltype(mutex)> lock(mutex);
+		auto it = entries.find(cmd);
+		if (it == entries.end()) return false;
+
+		Entry* entry = it->second.get();
+		trie.Remove(cmd->Name());
+		entry->unregistering = true;
+
+		// Invocations held by this thread (the command unregistering itself, or a script which pinned it) cannot end
+		// while it waits, so only wait for the others
+		std::vector<Entry*>& held = HeldEntries();
+		uint32_t own = (uint32_t)std::count(held.begin(), held.end(), entry);
+		cv.wait(lock, [entry, own] { return entry->active == own; });
+
+		if (own != 0)
+		{
+			entry->orphaned = true;
+			entries[cmd].release();
+		}
+		entries.erase(cmd);
+		return true;
+	}
+
+	void CommandManImp::Acquire(Entry* entry)
+	{
+		entry->active++;
+		HeldEntries().push_back(entry);
+	}
+
+	void CommandManImp::Release(Entry* entry)
+	{
+		std::vector<Entry*>& held = HeldEntries();
+		held.erase(std::find(held.rbegin(), held.rend(), entry).base() - 1);
+
+		if (--entry->active == 0 && entry->orphaned) delete entry;
+		else if (entry->unregistering) cv.notify_all();
+	}
+
+	bool CommandManImp::RunCommand(const char* command_string)
+	{
+		return Execute(command_string);
+	}
+
+	bool CommandManImp::Execute(const char* command_string)
+	{
+		ScratchTokenizer tok;
+		if (!tok->Tokenize(command_string))
+		{
+			C<Logger>()->Error(this, "Unterminated quote in command \"{}\"", command_string);
+			return false;
+		}
+		if (tok->Count() == 0) return false;
+
+		const char** tokens = tok->Tokens();
+		Entry* entry;
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			entry = trie.Find(tokens[0]);
+			if (entry == nullptr)
+			{
+				C<Logger>()->Error(this, "Unknown command \"{}\"", tokens[0]);
+				return false;
+			}
+			Acquire(entry);
+		}
+
+		entry->cmd->Run(tokens + 1, tok->Count() - 1);
+
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			Release(entry);
+		}
+		return true;
+	}
+
+	size_t CommandManImp::Complete(const char* prefix, const char** out_names, size_t max)
+	{
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		size_t n = 0;
+		if (max == 0) return 0;
+
+		trie.ForEachWithPrefix(prefix, [&](const std::string& name, Entry* entry) {
+			out_names[n++] = entry->cmd->Name();
+			return n < max;
+		});
+		return n;
+	}
+
+	HCallResult CommandManImp::RunCommandAsync(const char* command_string, CallResultBase* call_result, uint32_t executor, uint32_t timeout_ms)
+	{
+		auto inv = std::make_shared<Invocation>();
+		inv->handle = C<EventMan>()->BindCallResult(call_result ? call_result : &null_cr);
+		inv->command = command_string;
+		inv->has_deadline = timeout_ms != 0;
+		inv->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+		{
+			std::lock_guard<decltype(async_mutex)> lock(async_mutex);
+			invocations[inv->handle] = inv;
+			if (executor != WorkerPool) pump_queues[executor].push_back(inv);
+			if (inv->has_deadline)
+			{
+				deadlines.emplace(inv->deadline, inv);
+				timeout_cv.notify_all();
+			}
+		}
+		if (executor == WorkerPool) pool.Submit([this, inv] { Finish(inv); });
+		return inv->handle;
+	}
+
+	void CommandManImp::Finish(const std::shared_ptr<Invocation>& inv)
+	{
+		CommandResult result{ .handle = inv->handle, .status = CommandStatus::Cancelled, .elapsed_us = 0 };
+
+		if (!inv->IsCancelled())
+		{
+			Invocation* prev = current_invocation;
+			current_invocation = inv.get();
+			auto start = std::chrono::steady_clock::now();
+			inv->start_us = std::chrono::duration_cast<std::chrono::microseconds>(start.time_since_epoch()).count();
+
+			bool ok = Execute(inv->command.c_str());
+
+			result.elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+			current_invocation = prev;
+
+			if (!ok) result.status = CommandStatus::Failed;
+			else if (inv->cancelled) result.status = CommandStatus::Cancelled;
+			else if (inv->IsCancelled()) result.status = CommandStatus::TimedOut;
+			else result.status = CommandStatus::Completed;
+		}
+		else if (!inv->cancelled) result.status = CommandStatus::TimedOut;
+
+		Deliver(inv, result);
+	}
+
+	void CommandManImp::Deliver(const std::shared_ptr<Invocation>& inv, CommandResult& result)
+	{
+		if (inv->delivered.exchange(true)) return;
+		{
+			std::lock_guard<decltype(async_mutex)> lock(async_mutex);
+			invocations.erase(inv->handle);
+		}
+		C<EventMan>()->RaiseCallResult(inv->handle, &result);
+	}
+
+	void CommandManImp::TimeoutThread()
+	{
+		std::unique_lock<decltype(async_mutex)> lock(async_mutex);
+		while (!timeout_stop)
+		{
+			if (deadlines.empty())
+			{
+				timeout_cv.wait(lock);
+				continue;
+			}
+
+			auto it = deadlines.begin();
+			if (std::chrono::steady_clock::now() < it->first)
+			{
+				timeout_cv.wait_until(lock, it->first);
+				continue;
+			}
+
+			std::shared_ptr<Invocation> inv = it->second.lock();
+			deadlines.erase(it);
+			if (inv == nullptr || inv->delivered) continue;
+
+			// The command is still queued or running. It stops at its next IsCancelled poll, or is skipped.
+			inv->cancelled = true;
+			lock.unlock();
+
+			CommandResult result{ .handle = inv->handle, .status = CommandStatus::TimedOut, .elapsed_us = 0 };
+			int64_t start_us = inv->start_us;
+			if (start_us >= 0)
+			{
+				auto now = std::chrono::steady_clock::now().time_since_epoch();
+				result.elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(now).count() - start_us;
+			}
+			Deliver(inv, result);
+			lock.lock();
+		}
+	}
+
+	bool CommandManImp::CancelCommand(HCallResult handle)
+	{
+		std::lock_guard<decltype(async_mutex)> lock(async_mutex);
+		auto it = invocations.find(handle);
+		if (it == invocations.end()) return false;
+		it->second->cancelled = true;
+		return true;
+	}
+
+	size_t CommandManImp::PumpCommands(uint32_t pump)
+	{
+		std::deque<std::shared_ptr<Invocation>> queue;
+		{
+			std::lock_guard<decltype(async_mutex)> lock(async_mutex);
+			auto it = pump_queues.find(pump);
+			if (it == pump_queues.end()) return 0;
+			queue.swap(it->second);
+		}
+		for (auto& inv : queue) Finish(inv);
+		return queue.size();
+	}
+
+	bool CommandManImp::RunScript(const char* path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			C<Logger>()->Error(this, "Could not open script \"{}\"", path);
+			return false;
+		}
+		std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		// Commands used by the script are pinned until it ends, so that they can be called without lookup
+		std::vector<Entry*> pinned;
+		auto resolve = [&](const char* name) -> CommandBase* {
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			Entry* entry = trie.Find(name);
+			if (entry == nullptr) return nullptr;
+			Acquire(entry);
+			pinned.push_back(entry);
+			return entry->cmd;
+		};
+
+		CommandScript script;
+		std::string error;
+		bool ok = script.Parse(text, resolve, error);
+		if (!ok) C<Logger>()->Error(this, "Error in script \"{}\": {}", path, error);
+		else
+		{
+			// Parallel commands run on pool threads as part of this invocation, printing to it and seeing its cancellation
+			Invocation* inv = current_invocation;
+			std::vector<Entry*>* held = &HeldEntries();
+			auto scope = [inv, held](const std::function<void()>& task) {
+				Invocation* prev_inv = current_invocation;
+				std::vector<Entry*>* prev_held = held_entries;
+				current_invocation = inv;
+				held_entries = held;
+				task();
+				current_invocation = prev_inv;
+				held_entries = prev_held;
+			};
+			ok = script.Run(pool, [this] { return IsCancelled(); }, scope);
+			if (!ok) Print("Script cancelled");
+
+			std::string report;
+			script.Report(report);
+			Print(report.c_str());
+		}
+
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		for (Entry* entry : pinned) Release(entry);
+		return ok;
+	}
+
+	void CommandManImp::Print(const char* text)
+	{
+		if (current_invocation == nullptr)
+			C<Logger>()->Info(this, "{}", text);
+		else
+			C<EventMan>()->RaiseEvent(CommandOutputEvent{ .handle = current_invocation->handle, .text = text });
+	}
+
+	bool CommandManImp::IsCancelled()
+	{
+		return current_invocation != nullptr && current_invocation->IsCancelled();
+	}
+
+	void CommandManImp::HelpCommand::Run(const char* args[], size_t count)
+	{
+		std::string help = "Available commands:";
+		{
+			std::lock_guard<decltype(man->mutex)> lock(man->mutex);
+			man->trie.ForEachWithPrefix(count > 0 ? args[0] : "", [&](const std::string& name, Entry* entry) {
+				help.append("\n  ");
+				help.append(entry->cmd->HelpMessage());
+				return true;
+			});
+		}
+		man->Print(help.c_str());
+	}
+
+	void CommandManImp::ScriptCommand::Run(const char* args[], size_t count)
+	{
+		if (count != 1) man->Print(HelpMessage());
+		else man->RunScript(args[0]);
+	}
+}
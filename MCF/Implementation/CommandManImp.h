@@ -0,0 +1,168 @@
+#pragma once
+#include "Include/CommandMan.h"
+#include "Include/Logger.h"
+#include "Include/Export.h"
+#include "CommandTokenizer.h"
+#include "CommandTrie.h"
+#include "ThreadPool.h"
+#include "CommandScript.h"
+
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <thread>
+#include <string>
+#include <vector>
+
+namespace MCF
+{
+	class CommandManImp final : public SharedInterfaceImp<CommandMan, CommandManImp, DepList<EventMan, Logger>>
+	{
+	private:
+		/// <summary>
+		/// A registered command. The number of running invocations is tracked so that Unregister can wait on them
+		/// without holding the lock while commands run. An entry unregistered from one of its own invocations is
+		/// orphaned, and deleted when its last invocation ends.
+		/// </summary>
+		struct Entry
+		{
+			CommandBase* cmd;
+			uint32_t active = 0;
+			bool unregistering = false;
+			bool orphaned = false;
+		};
+
+		CommandTrie<Entry> trie;
+		std::unordered_map<CommandBase*, std::unique_ptr<Entry>> entries;
+		std::mutex mutex;
+		std::condition_variable cv;
+
+		// Entries running or pinned by a script on this thread, guarded by mutex. Pool threads running the parallel
+		// commands of a script share the list of the thread running the script through held_entries.
+		static thread_local std::vector<Entry*> thread_held_entries;
+		static thread_local std::vector<Entry*>* held_entries;
+
+		static std::vector<Entry*>& HeldEntries() { return held_entries ? *held_entries : thread_held_entries; }
+
+		// Start and end an invocation of a command on this thread. mutex must be held.
+		void Acquire(Entry* entry);
+		void Release(Entry* entry);
+
+		/// <summary>
+		/// A command queued or running through RunCommandAsync.
+		/// </summary>
+		struct Invocation
+		{
+			HCallResult handle;
+			std::string command;
+			std::atomic<bool> cancelled = false;
+			std::atomic<bool> delivered = false; // The call result was raised
+			std::chrono::steady_clock::time_point deadline;
+			bool has_deadline;
+			std::atomic<int64_t> start_us = -1; // Start time since the epoch of steady_clock, -1 if not started
+
+			bool IsCancelled() const
+			{
+				return cancelled.load(std::memory_order_relaxed) || (has_deadline && std::chrono::steady_clock::now() >= deadline);
+			}
+		};
+
+		/// <summary>
+		/// Bound when RunCommandAsync is not given a call result, so that every command gets a handle.
+		/// </summary>
+		class NullCallResult : public CallResultBase
+		{
+			virtual void Run(void* result) override { }
+		} null_cr;
+
+		std::unordered_map<HCallResult, std::shared_ptr<Invocation>> invocations;
+		std::unordered_map<uint32_t, std::deque<std::shared_ptr<Invocation>>> pump_queues;
+		std::mutex async_mutex;
+
+		// Invocations with a timeout, whose call result is raised with TimedOut at the deadline if still running
+		std::multimap<std::chrono::steady_clock::time_point, std::weak_ptr<Invocation>> deadlines;
+		std::condition_variable timeout_cv;
+		bool timeout_stop = false;
+		std::thread timeout_thread;
+
+		void TimeoutThread();
+
+		// Asynchronous command running on this thread, if any
+		static thread_local Invocation* current_invocation;
+
+		// Tokenize and run a command on the calling thread
+		bool Execute(const char* command_string);
+
+		void Finish(const std::shared_ptr<Invocation>& inv);
+
+		// Raise the call result of an invocation, unless it was already raised
+		void Deliver(const std::shared_ptr<Invocation>& inv, CommandResult& result);
+
+		class HelpCommand : public CommandBase
+		{
+			CommandManImp* man;
+
+		public:
+			HelpCommand(CommandManImp* man) : man(man) { }
+
+			virtual void Run(const char* args[], size_t count) override;
+			virtual const char* Name() const override { return "help"; }
+			virtual const char* HelpMessage() const override
+			{
+				return "help [prefix]: List the registered commands, optionally only those starting with prefix";
+			}
+		} help_cmd{ this };
+
+		class ScriptCommand : public CommandBase
+		{
+			CommandManImp* man;
+
+		public:
+			ScriptCommand(CommandManImp* man) : man(man) { }
+
+			virtual void Run(const char* args[], size_t count) override;
+			virtual const char* Name() const override { return "script"; }
+			virtual const char* HelpMessage() const override
+			{
+				return "script <path>: Run a command script and report the timing of each command";
+			}
+		} script_cmd{ this };
+
+		// Declared last so that it is destroyed first, completing its queued commands while the rest is alive
+		ThreadPool pool{ 4 };
+
+	public:
+		CommandManImp();
+		~CommandManImp();
+
+		virtual bool IsUnloadable() const override { return true; }
+
+		virtual bool Register(CommandBase* cmd) override;
+
+		virtual bool Unregister(CommandBase* cmd) override;
+
+		virtual bool RunCommand(const char* command_string) override;
+
+		virtual size_t Complete(const char* prefix, const char** out_names, size_t max) override;
+
+		virtual HCallResult RunCommandAsync(const char* command_string, CallResultBase* call_result,
+			uint32_t executor, uint32_t timeout_ms) override;
+
+		virtual bool CancelCommand(HCallResult handle) override;
+
+		virtual size_t PumpCommands(uint32_t pump) override;
+
+		virtual bool RunScript(const char* path) override;
+
+		virtual void Print(const char* text) override;
+
+		virtual bool IsCancelled() override;
+	};
+
+	MCF_COMPONENT_EXPORT(CommandManImp);
+}
@@ -0,0 +1,332 @@
+#include "CommandScript.h"
+#include "CommandTokenizer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <chrono>
+#include <algorithm>
+#include <format>
+
+namespace MCF
+{
+	static constexpr uint32_t NoVar = UINT32_MAX;
+
+	uint32_t CommandScript::VarIndex(std::string_view name, bool create)
+	{
+		for (uint32_t i = 0; i < var_names.size(); i++)
+			if (var_names[i] == name) return i;
+
+		if (!create) return NoVar;
+		var_names.emplace_back(name);
+		vars.emplace_back();
+		return (uint32_t)var_names.size() - 1;
+	}
+
+	bool CommandScript::ParseToken(const char* token, std::vector<Part>& parts, std::string& error)
+	{
+		auto is_name_char = [](char c) { return isalnum((unsigned char)c) || c == '_'; };
+		std::string literal;
+
+		for (const char* p = token; *p != 0; p++)
+		{
+			if (*p != '$' || (p[1] != '{' && !is_name_char(p[1])))
+			{
+				if (*p == '$' && p[1] == '$') p++;
+				literal.push_back(*p);
+				continue;
+			}
+
+			const char* name_begin, * name_end;
+			if (p[1] == '{')
+			{
+				name_begin = p + 2;
+				name_end = strchr(name_begin, '}');
+				if (name_end == nullptr)
+				{
+					error = "unterminated variable reference";
+					return false;
+				}
+				p = name_end;
+			}
+			else
+			{
+				name_begin = name_end = p + 1;
+				while (is_name_char(*name_end)) name_end++;
+				p = name_end - 1;
+			}
+
+			std::string_view name(name_begin, name_end - name_begin);
+			uint32_t var = VarIndex(name, false);
+			if (var == NoVar)
+			{
+				error = std::format("undefined variable \"{}\"", name);
+				return false;
+			}
+
+			if (!literal.empty()) parts.push_back(Part{ .text = std::move(literal), .var = NoVar });
+			literal.clear();
+			parts.push_back(Part{ .var = var });
+		}
+
+		if (!literal.empty() || parts.empty()) parts.push_back(Part{ .text = std::move(literal), .var = NoVar });
+		return true;
+	}
+
+	void CommandScript::Expand(const std::vector<Part>& parts, std::string& out) const
+	{
+		out.clear();
+		for (const auto& part : parts)
+			out.append(part.var == NoVar ? part.text : vars[part.var]);
+	}
+
+	bool CommandScript::Parse(std::string_view text, const Resolver& resolve, std::string& error)
+	{
+		CommandTokenizer tok;
+		std::vector<uint32_t> loops;
+		std::string token_error;
+
+		uint32_t line_num = 0;
+		while (!text.empty())
+		{
+			line_num++;
+			size_t eol = text.find('\n');
+			std::string_view line = text.substr(0, eol);
+			text = eol == std::string_view::npos ? std::string_view() : text.substr(eol + 1);
+
+			size_t first = line.find_first_not_of(" \t\r");
+			if (first == std::string_view::npos || line[first] == '#') continue;
+			line = line.substr(first);
+
+			Step step{ .line = line_num, .source = std::string(line) };
+			if (line[0] == '&')
+			{
+				step.parallel = true;
+				line = line.substr(1);
+			}
+
+			if (!tok.Tokenize(line))
+			{
+				error = std::format("line {}: unterminated quote", line_num);
+				return false;
+			}
+			if (tok.Count() == 0)
+			{
+				error = std::format("line {}: expected a command", line_num);
+				return false;
+			}
+
+			std::string_view name = tok.Tokens()[0];
+			size_t num_args = tok.Count() - 1;
+			if (name == "set" || name == "repeat" || name == "end")
+			{
+				if (step.parallel)
+				{
+					error = std::format("line {}: {} cannot run in parallel", line_num, name);
+					return false;
+				}
+				if ((name == "set" && num_args != 2) || (name == "repeat" && num_args != 1 && num_args != 2) || (name == "end" && num_args != 0))
+				{
+					error = std::format("line {}: wrong number of arguments to {}", line_num, name);
+					return false;
+				}
+			}
+
+			uint32_t first_arg = 1;
+			if (name == "set")
+			{
+				step.op = Op::Set;
+				first_arg = 2;
+			}
+			else if (name == "repeat")
+			{
+				step.op = Op::Repeat;
+				loops.push_back((uint32_t)steps.size());
+			}
+			else if (name == "end")
+			{
+				if (loops.empty())
+				{
+					error = std::format("line {}: end without repeat", line_num);
+					return false;
+				}
+				step.op = Op::End;
+				step.jump = loops.back();
+				steps[loops.back()].jump = (uint32_t)steps.size();
+				loops.pop_back();
+			}
+			else
+			{
+				step.op = Op::Command;
+				step.cmd = resolve(tok.Tokens()[0]);
+				if (step.cmd == nullptr)
+				{
+					error = std::format("line {}: unknown command \"{}\"", line_num, name);
+					return false;
+				}
+			}
+
+			for (size_t i = first_arg; i < (step.op == Op::Repeat ? 2 : tok.Count()); i++)
+			{
+				auto& parts = step.args.emplace_back();
+				if (!ParseToken(tok.Tokens()[i], parts, token_error))
+				{
+					error = std::format("line {}: {}", line_num, token_error);
+					return false;
+				}
+				for (const auto& part : parts) step.has_vars |= part.var != NoVar;
+			}
+
+			// Variables are created after parsing the value, so they must be set before being referenced
+			if (step.op == Op::Set) step.var = VarIndex(tok.Tokens()[1], true);
+			if (step.op == Op::Repeat && num_args == 2) step.var = VarIndex(tok.Tokens()[2], true);
+
+			steps.push_back(std::move(step));
+		}
+
+		if (!loops.empty())
+		{
+			error = std::format("line {}: repeat without end", steps[loops.back()].line);
+			return false;
+		}
+
+		// Steps no longer move, so argument strings can be pointed to
+		for (uint32_t i = 0; i < steps.size(); i++)
+		{
+			Step& step = steps[i];
+			if (step.op != Op::Command) continue;
+
+			if (!step.has_vars)
+				for (const auto& parts : step.args) step.static_argv.push_back(parts[0].text.c_str());
+
+			if (step.parallel && (i == 0 || !steps[i - 1].parallel))
+			{
+				uint32_t end = i;
+				while (end < steps.size() && steps[end].op == Op::Command && steps[end].parallel) end++;
+				step.group_end = end;
+			}
+		}
+		return true;
+	}
+
+	void CommandScript::RunStep(Step& step, std::vector<std::string>& arg_buf, std::vector<const char*>& argv_buf)
+	{
+		const char** argv = step.static_argv.data();
+		size_t argc = step.args.size();
+		if (step.has_vars)
+		{
+			arg_buf.resize(argc);
+			argv_buf.resize(argc);
+			for (size_t i = 0; i < argc; i++)
+			{
+				Expand(step.args[i], arg_buf[i]);
+				argv_buf[i] = arg_buf[i].c_str();
+			}
+			argv = argv_buf.data();
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		step.cmd->Run(argv, argc);
+		uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+		step.timing.runs++;
+		step.timing.total_ns += ns;
+		step.timing.min_ns = (std::min)(step.timing.min_ns, ns);
+		step.timing.max_ns = (std::max)(step.timing.max_ns, ns);
+	}
+
+	void CommandScript::RunGroup(ThreadPool& pool, uint32_t begin, uint32_t end, const TaskScope& scope)
+	{
+		pool.ParallelFor(end - begin, [this, begin, &scope](size_t k) {
+			std::vector<std::string> args;
+			std::vector<const char*> argv;
+			if (scope) scope([&] { RunStep(steps[begin + k], args, argv); });
+			else RunStep(steps[begin + k], args, argv);
+		});
+	}
+
+	bool CommandScript::Run(ThreadPool& pool, const std::function<bool()>& cancelled, const TaskScope& scope)
+	{
+		struct Loop
+		{
+			uint64_t count;
+			uint64_t index;
+		};
+		std::vector<Loop> loops;
+		std::vector<std::string> arg_buf;
+		std::vector<const char*> argv_buf;
+
+		for (uint32_t i = 0; i < steps.size();)
+		{
+			if (cancelled && cancelled()) return false;
+
+			Step& step = steps[i];
+			switch (step.op)
+			{
+			case Op::Set:
+				Expand(step.args[0], vars[step.var]);
+				i++;
+				break;
+
+			case Op::Repeat:
+			{
+				Expand(step.args[0], arg_buf.emplace_back());
+				uint64_t count = strtoull(arg_buf.back().c_str(), nullptr, 0);
+				arg_buf.pop_back();
+				if (count == 0)
+				{
+					i = step.jump + 1;
+					break;
+				}
+				loops.push_back(Loop{ .count = count, .index = 0 });
+				if (step.var != NoVar) vars[step.var] = "0";
+				i++;
+				break;
+			}
+
+			case Op::End:
+			{
+				Loop& loop = loops.back();
+				if (++loop.index < loop.count)
+				{
+					uint32_t var = steps[step.jump].var;
+					if (var != NoVar) vars[var] = std::to_string(loop.index);
+					i = step.jump + 1;
+				}
+				else
+				{
+					loops.pop_back();
+					i++;
+				}
+				break;
+			}
+
+			case Op::Command:
+				if (step.group_end <= i + 1)
+				{
+					RunStep(step, arg_buf, argv_buf);
+					i++;
+					break;
+				}
+
+				RunGroup(pool, i, step.group_end, scope);
+				i = step.group_end;
+				break;
+			}
+		}
+		return true;
+	}
+
+	void CommandScript::Report(std::string& out) const
+	{
+		out.append("Script timing (runs, total ms, mean/min/max us):");
+		for (const auto& step : steps)
+		{
+			if (step.op != Op::Command || step.timing.runs == 0) continue;
+
+			const Timing& t = step.timing;
+			out.append(std::format("\n  line {:>4}: {:>8} {:>10.3f} {:>10.2f} {:>10.2f} {:>10.2f}  {}", step.line, t.runs,
+				t.total_ns / 1e6, t.total_ns / 1e3 / t.runs, t.min_ns / 1e3, t.max_ns / 1e3, step.source));
+		}
+	}
+}
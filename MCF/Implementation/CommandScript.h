@@ -0,0 +1,95 @@
+#pragma once
+#include "Include/CommandBase.h"
+#include "ThreadPool.h"
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+namespace MCF
+{
+	/// <summary>
+	/// A command script, parsed once and then executed with minimal per-command overhead. Command names are 
+	/// resolved and tokenized while parsing, so running a command which does not reference variables only costs
+	/// the call to CommandBase::Run. See CommandMan::RunScript for the syntax.
+	/// </summary>
+	class CommandScript
+	{
+	public:
+		typedef std::function<CommandBase* (const char* name)> Resolver;
+
+		/// <summary>
+		/// Wraps the commands of parallel groups run on pool threads, e.g. to give them the context of the thread
+		/// running the script.
+		/// </summary>
+		typedef std::function<void(const std::function<void()>& task)> TaskScope;
+
+		struct Timing
+		{
+			uint64_t runs = 0;
+			uint64_t total_ns = 0;
+			uint64_t min_ns = UINT64_MAX;
+			uint64_t max_ns = 0;
+		};
+
+	private:
+		enum class Op { Command, Set, Repeat, End };
+
+		/// <summary>
+		/// Piece of a token, either literal text or a variable reference.
+		/// </summary>
+		struct Part
+		{
+			std::string text;
+			uint32_t var; // UINT32_MAX for literal text
+		};
+
+		struct Step
+		{
+			Op op;
+			uint32_t line;
+			std::string source;
+			CommandBase* cmd = nullptr;
+			std::vector<std::vector<Part>> args; // Command arguments, or the value of a Set / count of a Repeat
+			std::vector<const char*> static_argv; // Arguments of commands which do not reference variables
+			bool has_vars = false;
+			bool parallel = false;
+			uint32_t group_end = 0; // For the first command of a parallel group, index of the step after the group
+			uint32_t var = UINT32_MAX; // Variable assigned by Set or Repeat
+			uint32_t jump = 0; // Matching End of a Repeat, or matching Repeat of an End
+			Timing timing;
+		};
+
+		std::vector<Step> steps;
+		std::vector<std::string> var_names;
+		std::vector<std::string> vars;
+
+		uint32_t VarIndex(std::string_view name, bool create);
+		bool ParseToken(const char* token, std::vector<Part>& parts, std::string& error);
+		void Expand(const std::vector<Part>& parts, std::string& out) const;
+		void RunStep(Step& step, std::vector<std::string>& arg_buf, std::vector<const char*>& argv_buf);
+		void RunGroup(ThreadPool& pool, uint32_t begin, uint32_t end, const TaskScope& scope);
+
+	public:
+		/// <summary>
+		/// Parse a script. Each command name is passed to resolve, which returns null if it is not registered.
+		/// </summary>
+		/// <returns>False if the script is malformed, in which case error contains the reason.</returns>
+		bool Parse(std::string_view text, const Resolver& resolve, std::string& error);
+
+		/// <summary>
+		/// Execute the script. Groups of commands marked as independent are distributed on the pool, while the
+		/// calling thread also participates. cancelled is polled between commands. If scope is not null, the commands
+		/// of parallel groups are run through it.
+		/// </summary>
+		/// <returns>False if the script was cancelled.</returns>
+		bool Run(ThreadPool& pool, const std::function<bool()>& cancelled, const TaskScope& scope = nullptr);
+
+		/// <summary>
+		/// Append a per-command timing report of all runs so far.
+		/// </summary>
+		void Report(std::string& out) const;
+	};
+}
@@ -0,0 +1,42 @@
+#include "CommandTokenizer.h"
+
+namespace MCF
+{
+	bool CommandTokenizer::Tokenize(std::string_view command)
+	{
+		tokens.clear();
+
+		// Output never exceeds the input plus one terminator per token
+		size_t needed = 2 * command.size() + 1;
+		if (buffer.size() < needed) buffer.resize(needed);
+
+		char* out = buffer.data();
+		const char* p = command.data();
+		const char* end = p + command.size();
+
+		while (true)
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+			if (p == end) return true;
+
+			tokens.push_back(out);
+			char quote = 0;
+			for (; p < end; p++)
+			{
+				char c = *p;
+				if (quote != 0)
+				{
+					if (c == quote) quote = 0;
+					else if (c == '\\' && quote == '"' && p + 1 < end) *out++ = *++p;
+					else *out++ = c;
+				}
+				else if (c == '"' || c == '\'') quote = c;
+				else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') break;
+				else *out++ = c;
+			}
+			*out++ = '\0';
+
+			if (quote != 0) return false;
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <string_view>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Splits command strings into null-terminated tokens stored in a reusable buffer. Once the buffers have grown
+	/// to fit the longest command seen, tokenizing does not allocate.
+	/// </summary>
+	class CommandTokenizer
+	{
+	private:
+		std::vector<char> buffer;
+		std::vector<const char*> tokens;
+
+	public:
+		/// <summary>
+		/// Tokenize a command string. Tokens are separated by whitespace, and may be quoted with single or double quotes.
+		/// Inside double quotes, a backslash escapes the next character. Invalidates previously returned tokens.
+		/// </summary>
+		/// <returns>False if a quote was not terminated.</returns>
+		bool Tokenize(std::string_view command);
+
+		const char** Tokens() { return tokens.data(); }
+
+		size_t Count() const { return tokens.size(); }
+	};
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Prefix trie mapping command names to values, giving O(length) lookup and prefix completion.
+	/// Nodes are stored in a single array with first child / next sibling links, siblings being sorted by character.
+	/// Removed names leave their nodes in place, to be reused if the name is inserted again.
+	/// </summary>
+	template<typename T>
+	class CommandTrie
+	{
+	private:
+		static constexpr uint32_t None = UINT32_MAX;
+
+		struct Node
+		{
+			uint32_t first_child = None;
+			uint32_t next_sibling = None;
+			char c = 0;
+			T* value = nullptr;
+		};
+		std::vector<Node> nodes{ 1 };
+
+		uint32_t FindChild(uint32_t node, char c) const
+		{
+			uint32_t child = nodes[node].first_child;
+			while (child != None && nodes[child].c < c) child = nodes[child].next_sibling;
+			return (child != None && nodes[child].c == c) ? child : None;
+		}
+
+		uint32_t FindNode(std::string_view key) const
+		{
+			uint32_t node = 0;
+			for (char c : key)
+			{
+				node = FindChild(node, c);
+				if (node == None) return None;
+			}
+			return node;
+		}
+
+		uint32_t GetOrAddChild(uint32_t node, char c)
+		{
+			uint32_t prev = None, child = nodes[node].first_child;
+			while (child != None && nodes[child].c < c)
+			{
+				prev = child;
+				child = nodes[child].next_sibling;
+			}
+			if (child != None && nodes[child].c == c) return child;
+
+			uint32_t added = (uint32_t)nodes.size();
+			nodes.push_back(Node{ .next_sibling = child, .c = c });
+			if (prev == None) nodes[node].first_child = added;
+			else nodes[prev].next_sibling = added;
+			return added;
+		}
+
+		template<typename TCallable>
+		bool Visit(uint32_t node, std::string& key, TCallable& cb) const
+		{
+			if (nodes[node].value != nullptr && !cb(key, nodes[node].value)) return false;
+			for (uint32_t child = nodes[node].first_child; child != None; child = nodes[child].next_sibling)
+			{
+				key.push_back(nodes[child].c);
+				bool cont = Visit(child, key, cb);
+				key.pop_back();
+				if (!cont) return false;
+			}
+			return true;
+		}
+
+	public:
+		/// <summary>
+		/// Insert a value. Returns false if the key is already present.
+		/// </summary>
+		bool Insert(std::string_view key, T* value)
+		{
+			uint32_t node = 0;
+			for (char c : key) node = GetOrAddChild(node, c);
+			if (nodes[node].value != nullptr) return false;
+			nodes[node].value = value;
+			return true;
+		}
+
+		/// <summary>
+		/// Remove a key, returning its value or null if it was not present.
+		/// </summary>
+		T* Remove(std::string_view key)
+		{
+			uint32_t node = FindNode(key);
+			if (node == None) return nullptr;
+			T* value = nodes[node].value;
+			nodes[node].value = nullptr;
+			return value;
+		}
+
+		T* Find(std::string_view key) const
+		{
+			uint32_t node = FindNode(key);
+			return node == None ? nullptr : nodes[node].value;
+		}
+
+		/// <summary>
+		/// Call cb(const std::string& key, T* value) for each key starting with prefix, in lexicographic order,
+		/// until it returns false.
+		/// </summary>
+		template<typename TCallable>
+		void ForEachWithPrefix(std::string_view prefix, TCallable cb) const
+		{
+			uint32_t node = FindNode(prefix);
+			if (node == None) return;
+			std::string key(prefix);
+			Visit(node, key, cb);
+		}
+	};
+}
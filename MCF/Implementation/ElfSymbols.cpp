@@ -0,0 +1,88 @@
+#ifndef _WIN32
+#include "ElfSymbols.h"
+#include <string.h>
+#include <link.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace MCF
+{
+	namespace ElfSymbols
+	{
+		namespace
+		{
+			struct PhdrQuery
+			{
+				uintptr_t base;
+				uintptr_t bias;
+				char path[4096];
+				bool found;
+			};
+
+			void AddSymbols(const uint8_t* file, size_t size, uintptr_t bias, std::vector<Symbol>& out)
+			{
+				auto ehdr = (const ElfW(Ehdr)*)file;
+				if (size < sizeof(ElfW(Ehdr)) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_shoff == 0
+					|| ehdr->e_shoff + (size_t)ehdr->e_shnum * sizeof(ElfW(Shdr)) > size) return;
+
+				auto shdrs = (const ElfW(Shdr)*)(file + ehdr->e_shoff);
+				for (ElfW(Half) i = 0; i < ehdr->e_shnum; i++)
+				{
+					const ElfW(Shdr)& symtab = shdrs[i];
+					if ((symtab.sh_type != SHT_SYMTAB && symtab.sh_type != SHT_DYNSYM) || symtab.sh_link >= ehdr->e_shnum) continue;
+
+					const ElfW(Shdr)& strtab = shdrs[symtab.sh_link];
+					if (symtab.sh_offset + symtab.sh_size > size || strtab.sh_offset + strtab.sh_size > size) continue;
+
+					auto syms = (const ElfW(Sym)*)(file + symtab.sh_offset);
+					for (size_t j = 0; j < symtab.sh_size / sizeof(ElfW(Sym)); j++)
+					{
+						const ElfW(Sym)& sym = syms[j];
+						if (ELF64_ST_TYPE(sym.st_info) != STT_FUNC || sym.st_shndx == SHN_UNDEF || sym.st_value == 0) continue;
+						out.push_back(Symbol{ .begin = bias + sym.st_value, .size = sym.st_size });
+					}
+				}
+			}
+		}
+
+		std::vector<Symbol> Functions(uintptr_t base)
+		{
+			// The load bias and path of the module, which are not part of the index
+			PhdrQuery query{ .base = base };
+			dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) {
+				auto query = (PhdrQuery*)data;
+				for (ElfW(Half) i = 0; i < info->dlpi_phnum; i++)
+				{
+					if (info->dlpi_phdr[i].p_type != PT_LOAD) continue;
+					if (info->dlpi_addr + info->dlpi_phdr[i].p_vaddr != query->base) return 0;
+
+					query->bias = info->dlpi_addr;
+					const char* name = info->dlpi_name && info->dlpi_name[0] ? info->dlpi_name : "/proc/self/exe";
+					strncpy(query->path, name, sizeof(query->path) - 1);
+					query->found = true;
+					return 1;
+				}
+				return 0;
+			}, &query);
+
+			std::vector<Symbol> symbols;
+			if (!query.found) return symbols;
+
+			int fd = open(query.path, O_RDONLY);
+			if (fd < 0) return symbols;
+
+			struct stat st;
+			void* file = fstat(fd, &st) == 0 && st.st_size > 0 ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+			close(fd);
+			if (file == MAP_FAILED) return symbols;
+
+			AddSymbols((const uint8_t*)file, st.st_size, query.bias, symbols);
+			munmap(file, st.st_size);
+			return symbols;
+		}
+	}
+}
+#endif
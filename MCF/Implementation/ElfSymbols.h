@@ -0,0 +1,28 @@
+#pragma once
+#ifndef _WIN32
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Reads the function symbols of a loaded ELF module from the symbol tables of its file, which are not mapped.
+	/// </summary>
+	namespace ElfSymbols
+	{
+		struct Symbol
+		{
+			uintptr_t begin;
+			size_t size; // 0 if unknown
+		};
+
+		/// <summary>
+		/// Read the defined STT_FUNC symbols of .symtab and .dynsym of the loaded module whose lowest segment starts at
+		/// base, relocated to their address in memory. A symbol in both tables is reported twice.
+		/// </summary>
+		/// <returns>The symbols, empty if the module or its file is not found.</returns>
+		std::vector<Symbol> Functions(uintptr_t base);
+	}
+}
+#endif
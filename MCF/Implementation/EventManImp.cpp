@@ -14,12 +14,20 @@ namespace MCF
 		callbacks[callback->EventName()].erase(callback);
 	}
 
+	bool EventManImp::HasListeners(const char* event_name)
+	{
+		std::lock_guard<decltype(cb_mutex)> lock(cb_mutex);
+		auto it = callbacks.find(std::string_view(event_name));
+		return it != callbacks.end() && !it->second.empty();
+	}
+
 	void EventManImp::RaiseEvent(const char* event_name, void* event_data)
 	{
 		std::lock_guard<decltype(cb_mutex)> lock(cb_mutex);
-		if (callbacks.count(event_name) == 0) return;
+		auto it = callbacks.find(std::string_view(event_name));
+		if (it == callbacks.end()) return;
 
-		for (const auto cb : callbacks[event_name])
+		for (const auto cb : it->second)
 			cb->Run(event_data);
 	}
 
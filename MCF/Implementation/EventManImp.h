@@ -5,13 +5,21 @@
 #include <unordered_set>
 #include <mutex>
 #include <string>
+#include <string_view>
 
 namespace MCF
 {
 	class EventManImp final : public SharedInterfaceImp<EventMan, EventManImp>
 	{
 	private:
-		std::unordered_map<std::string, std::unordered_set<EventCallbackBase*>> callbacks;
+		struct StringHash
+		{
+			using is_transparent = void;
+			size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+		};
+
+		// Looked up by string_view, so that raising an event or checking for listeners does not allocate
+		std::unordered_map<std::string, std::unordered_set<EventCallbackBase*>, StringHash, std::equal_to<>> callbacks;
 		std::unordered_map<HCallResult, CallResultBase*> cr_from_handle;
 		std::unordered_map<CallResultBase*, std::unordered_set<HCallResult>> handle_from_cr;
 
@@ -35,5 +43,7 @@ namespace MCF
 		virtual void UnregisterCallResult(CallResultBase* call_result) override;
 
 		virtual bool RaiseCallResult(HCallResult handle, void* result) override;
+
+		virtual bool HasListeners(const char* event_name) override;
 	};
 }
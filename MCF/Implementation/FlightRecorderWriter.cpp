@@ -0,0 +1,62 @@
+#include "FlightRecorderWriter.h"
+
+namespace MCF
+{
+	bool FlightRecorderWriter::Open(uint32_t slot_count, const char* backing_file)
+	{
+		Close();
+		if (slot_count == 0 || slot_count > FlightRecorder::MaxSlotCount) return false;
+
+		uint32_t count = 1;
+		while (count < slot_count) count <<= 1;
+
+		size_t size = FlightRecorder::SegmentSize(count);
+		char name[64];
+		FlightRecorder::SegmentName(name, sizeof(name), GetCurrentProcessId());
+
+		if (backing_file != nullptr)
+		{
+			file = CreateFileA(backing_file, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (file == INVALID_HANDLE_VALUE) return false;
+		}
+
+		mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, name);
+		if (mapping == NULL)
+		{
+			Close();
+			return false;
+		}
+
+		header = (FlightRecorder::Header*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+		if (header == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		// Fresh mappings are zero-filled, so every slot starts out uncommitted
+		header->magic = FlightRecorder::Magic;
+		header->version = FlightRecorder::Version;
+		header->slot_size = FlightRecorder::SlotSize;
+		header->slot_count = count;
+		header->pid = GetCurrentProcessId();
+		header->write_index.store(0, std::memory_order_release);
+
+		slots = FlightRecorder::Slots(header);
+		mask = count - 1;
+		return true;
+	}
+
+	void FlightRecorderWriter::Close()
+	{
+		if (header != nullptr) UnmapViewOfFile(header);
+		if (mapping != NULL) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+
+		header = nullptr;
+		slots = nullptr;
+		mapping = NULL;
+		file = INVALID_HANDLE_VALUE;
+		mask = 0;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "Include/FlightRecorder.h"
+#include "common.h"
+#include <algorithm>
+#include <chrono>
+
+namespace MCF
+{
+	/// <summary>
+	/// Lock-free writer for the log flight recorder ring (see Include/FlightRecorder.h). 
+	/// Open/Close are not thread safe and must be externally synchronized with Write.
+	/// </summary>
+	class FlightRecorderWriter
+	{
+	private:
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+		FlightRecorder::Header* header = nullptr;
+		FlightRecorder::Slot* slots = nullptr;
+		uint64_t mask = 0;
+
+	public:
+		FlightRecorderWriter() { }
+		FlightRecorderWriter(FlightRecorderWriter&) = delete;
+		~FlightRecorderWriter() { Close(); }
+
+		/// <summary>
+		/// Create the shared memory segment. If backing_file is not null, the segment is backed by this file so that 
+		/// its contents survive the process even if no other process holds a handle to it (the file is overwritten). 
+		/// slot_count is rounded up to a power of two. Fails if it is zero or larger than FlightRecorder::MaxSlotCount.
+		/// </summary>
+		bool Open(uint32_t slot_count, const char* backing_file = nullptr);
+
+		void Close();
+
+		bool IsOpen() const { return header != nullptr; }
+
+		/// <summary>
+		/// Copy a message and its encoded structured fields into the next slot of the ring. 
+		/// Strings are truncated to fit in a slot, and the fields are dropped if they do not fit.
+		/// </summary>
+		void Write(const char* source, const char* severity, const char* message, const char* fields = nullptr, size_t fields_len = 0)
+		{
+			size_t src_len = strnlen(source, 0xFF);
+			size_t sev_len = strnlen(severity, 0xFF);
+			size_t msg_len = strlen(message);
+
+			uint64_t index = header->write_index.fetch_add(1, std::memory_order_relaxed);
+			FlightRecorder::Slot* slot = &slots[index & mask];
+
+			slot->seq.store(0, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			constexpr size_t cap = sizeof(slot->text);
+			src_len = (std::min)(src_len, cap);
+			sev_len = (std::min)(sev_len, cap - src_len);
+			msg_len = (std::min)(msg_len, cap - src_len - sev_len);
+			if (fields_len > cap - src_len - sev_len - msg_len) fields_len = 0;
+
+			slot->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+			slot->thread_id = GetCurrentThreadId();
+			slot->src_len = (uint8_t)src_len;
+			slot->sev_len = (uint8_t)sev_len;
+			slot->msg_len = (uint16_t)msg_len;
+			slot->fields_len = (uint16_t)fields_len;
+
+			char* text = slot->text;
+			memcpy(text, source, src_len);
+			memcpy(text += src_len, severity, sev_len);
+			memcpy(text += sev_len, message, msg_len);
+			if (fields_len != 0) memcpy(text + msg_len, fields, fields_len);
+
+			slot->seq.store(index + 1, std::memory_order_release);
+		}
+	};
+}
@@ -0,0 +1,155 @@
+#include "FunctionDiscovery.h"
+#include "XrefScanner.h"
+#include <string.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include "ElfSymbols.h"
+#endif
+
+namespace MCF
+{
+	namespace FunctionDiscovery
+	{
+		namespace
+		{
+			constexpr size_t ChunkSize = 1 << 20;
+
+#ifdef _WIN64
+			// UNWIND_INFO flag indicating that a chained RUNTIME_FUNCTION follows the unwind codes
+			constexpr uint8_t UnwFlagChainInfo = 4;
+
+			// Follow the chained unwind info of a function fragment to the function it belongs to
+			const RUNTIME_FUNCTION* RootFunction(uintptr_t base, const RUNTIME_FUNCTION* fn)
+			{
+				for (int depth = 0; depth < 32; depth++)
+				{
+					auto unwind = (const uint8_t*)(base + (fn->UnwindData & ~1u));
+					if (!((unwind[0] >> 3) & UnwFlagChainInfo)) break;
+
+					// Unwind codes are 2 bytes each, padded to an even count
+					uint8_t count = unwind[2];
+					fn = (const RUNTIME_FUNCTION*)(unwind + 4 + 2 * ((count + 1) & ~1));
+				}
+				return fn;
+			}
+
+			void AddPlatformFunctions(const ModuleIndex::ModuleInfo& mod_info, std::vector<Function>& out)
+			{
+				auto dos = (const IMAGE_DOS_HEADER*)mod_info.base;
+				auto nt = (const IMAGE_NT_HEADERS*)(mod_info.base + dos->e_lfanew);
+				const IMAGE_DATA_DIRECTORY& dir = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+				if (dir.VirtualAddress == 0 || dir.Size == 0) return;
+
+				auto functions = (const RUNTIME_FUNCTION*)(mod_info.base + dir.VirtualAddress);
+				size_t count = dir.Size / sizeof(RUNTIME_FUNCTION);
+				for (size_t i = 0; i < count; i++)
+				{
+					const RUNTIME_FUNCTION* root = RootFunction(mod_info.base, &functions[i]);
+					out.push_back(Function{
+						.begin = mod_info.base + functions[i].BeginAddress,
+						.end = mod_info.base + functions[i].EndAddress,
+						.owner = mod_info.base + root->BeginAddress,
+						.sources = CodeAnalysis::SourceUnwindInfo
+					});
+				}
+			}
+#elif defined(_WIN32)
+			void AddPlatformFunctions(const ModuleIndex::ModuleInfo&, std::vector<Function>&) { }
+#else
+			void AddPlatformFunctions(const ModuleIndex::ModuleInfo& mod_info, std::vector<Function>& out)
+			{
+				for (const auto& symbol : ElfSymbols::Functions(mod_info.base))
+				{
+					out.push_back(Function{
+						.begin = symbol.begin,
+						.end = symbol.size ? symbol.begin + symbol.size : 0,
+						.owner = symbol.begin,
+						.sources = CodeAnalysis::SourceSymbol
+					});
+				}
+			}
+#endif
+		}
+
+		std::vector<Function> Discover(const ModuleIndex::ModuleInfo& mod_info, const std::vector<ModuleIndex::SectionInfo>& sections, ThreadPool& pool)
+		{
+			std::vector<Function> functions;
+			AddPlatformFunctions(mod_info, functions);
+
+			// Direct call targets, from a parallel sweep of the code
+			struct Chunk
+			{
+				const ModuleIndex::SectionInfo* section;
+				uintptr_t begin;
+				uintptr_t end;
+			};
+			std::vector<Chunk> chunks;
+			for (const auto& section : sections)
+			{
+				if (!(section.flags & ModuleIndex::SectionExecute)) continue;
+				uintptr_t end = section.begin + section.size;
+				for (uintptr_t p = section.begin; p < end; p += ChunkSize)
+					chunks.push_back(Chunk{ .section = &section, .begin = p, .end = (std::min)(p + ChunkSize, end) });
+			}
+
+			std::vector<std::vector<XrefIndex::Xref>> chunk_xrefs(chunks.size());
+			pool.ParallelFor(chunks.size(), [&](size_t i) {
+				const Chunk& chunk = chunks[i];
+				auto section_begin = (const uint8_t*)chunk.section->begin;
+				XrefScanner::ScanChunk(section_begin, section_begin + chunk.section->size, (const uint8_t*)chunk.begin,
+					(const uint8_t*)chunk.end, mod_info.base, mod_info.base + mod_info.size, chunk_xrefs[i]);
+
+				std::erase_if(chunk_xrefs[i], [](const XrefIndex::Xref& xref) { return xref.type != XrefIndex::XrefType::Call; });
+			});
+
+			auto is_code = [&](uintptr_t address) {
+				for (const auto& section : sections)
+					if ((section.flags & ModuleIndex::SectionExecute) && address - section.begin < section.size) return true;
+				return false;
+			};
+			for (const auto& xrefs : chunk_xrefs)
+			{
+				for (const auto& xref : xrefs)
+				{
+					if (!is_code(xref.to)) continue;
+					functions.push_back(Function{ .begin = xref.to, .end = 0, .owner = xref.to, .sources = CodeAnalysis::SourceCallTarget });
+				}
+			}
+
+			// Merge the functions found at the same address, and drop those starting inside a known extent
+			std::sort(functions.begin(), functions.end(), [](const Function& a, const Function& b) {
+				return a.begin != b.begin ? a.begin < b.begin : a.end > b.end;
+			});
+			std::vector<Function> merged;
+			for (const auto& fn : functions)
+			{
+				if (!merged.empty())
+				{
+					Function& last = merged.back();
+					if (fn.begin == last.begin)
+					{
+						last.sources |= fn.sources;
+						if (last.end == 0) last.end = fn.end;
+						continue;
+					}
+					if (last.end != 0 && fn.begin < last.end) continue;
+				}
+				merged.push_back(fn);
+			}
+
+			// Unknown ends are bounded by the next function and the section
+			for (size_t i = 0; i < merged.size(); i++)
+			{
+				Function& fn = merged[i];
+				uintptr_t limit = i + 1 < merged.size() ? merged[i + 1].begin : UINTPTR_MAX;
+				for (const auto& section : sections)
+					if (fn.begin - section.begin < section.size) limit = (std::min)(limit, section.begin + section.size);
+				fn.end = fn.end == 0 ? limit : (std::min)(fn.end, limit);
+			}
+			return merged;
+		}
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Include/CodeAnalysis.h"
+#include "Include/ModuleIndex.h"
+#include "ThreadPool.h"
+#include <stdint.h>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Finds the functions of a loaded module: from the unwind info of .pdata on Windows x64 and the symbol tables
+	/// of the ELF file elsewhere, completed by the direct call targets found by a sweep of the executable sections.
+	/// </summary>
+	namespace FunctionDiscovery
+	{
+		struct Function
+		{
+			uintptr_t begin;
+			uintptr_t end; // 0 if only the start is known
+			uintptr_t owner; // Start of the function this is a fragment of (chained unwind info), or begin
+			uint32_t sources; // CodeAnalysis::FunctionSource flags
+		};
+
+		/// <summary>
+		/// Discover the functions of a module whose sections are given, sorted by address and not overlapping.
+		/// Functions whose end is not known end at the next function or the end of their section.
+		/// </summary>
+		std::vector<Function> Discover(const ModuleIndex::ModuleInfo& mod_info, const std::vector<ModuleIndex::SectionInfo>& sections, ThreadPool& pool);
+	}
+}
@@ -0,0 +1,236 @@
+#include "LocalSocket.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#endif
+
+namespace MCF
+{
+#ifdef _WIN32
+	LocalStream::LocalStream(HANDLE handle) : handle(handle)
+	{
+		read_event = CreateEventA(NULL, TRUE, FALSE, NULL);
+		write_event = CreateEventA(NULL, TRUE, FALSE, NULL);
+	}
+
+	LocalStream::~LocalStream()
+	{
+		CloseHandle(handle);
+		if (read_event != NULL) CloseHandle(read_event);
+		if (write_event != NULL) CloseHandle(write_event);
+	}
+
+	size_t LocalStream::Read(char* buf, size_t size)
+	{
+		if (read_event == NULL) return 0;
+
+		OVERLAPPED ov{ };
+		ov.hEvent = read_event;
+		DWORD read = 0;
+		if (!ReadFile(handle, buf, (DWORD)size, NULL, &ov) && GetLastError() != ERROR_IO_PENDING) return 0;
+		if (!GetOverlappedResult(handle, &ov, &read, TRUE)) return 0;
+		return read;
+	}
+
+	bool LocalStream::Write(const char* data, size_t size)
+	{
+		if (write_event == NULL) return false;
+
+		while (size > 0)
+		{
+			OVERLAPPED ov{ };
+			ov.hEvent = write_event;
+			DWORD written = 0;
+			if (!WriteFile(handle, data, (DWORD)size, NULL, &ov) && GetLastError() != ERROR_IO_PENDING) return false;
+			if (!GetOverlappedResult(handle, &ov, &written, TRUE)) return false;
+			data += written;
+			size -= written;
+		}
+		return true;
+	}
+
+	void LocalStream::Shutdown()
+	{
+		// Pending reads and writes of other threads complete with ERROR_OPERATION_ABORTED
+		CancelIoEx(handle, NULL);
+		DisconnectNamedPipe(handle);
+	}
+
+	LocalServer::~LocalServer()
+	{
+		Close();
+		if (close_event != NULL) CloseHandle(close_event);
+	}
+
+	std::string LocalServer::DefaultAddress()
+	{
+		return "\\\\.\\pipe\\MCF_RemoteConsole_" + std::to_string(GetCurrentProcessId());
+	}
+
+	bool LocalServer::Listen(const char* address)
+	{
+		if (!closed) return false;
+		if (close_event == NULL) close_event = CreateEventA(NULL, TRUE, FALSE, NULL);
+		if (close_event == NULL) return false;
+
+		ResetEvent(close_event);
+		this->address = address;
+		closed = false;
+		return true;
+	}
+
+	std::unique_ptr<LocalStream> LocalServer::Accept()
+	{
+		while (!closed)
+		{
+			HANDLE pipe = CreateNamedPipeA(address.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED, 
+				PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 
+				PIPE_UNLIMITED_INSTANCES, 1 << 16, 1 << 16, 0, NULL);
+			if (pipe == INVALID_HANDLE_VALUE) return nullptr;
+
+			OVERLAPPED ov{ };
+			ov.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+			if (ov.hEvent == NULL)
+			{
+				CloseHandle(pipe);
+				return nullptr;
+			}
+
+			bool connected = ConnectNamedPipe(pipe, &ov);
+			DWORD error = GetLastError();
+			if (!connected && error == ERROR_PIPE_CONNECTED) connected = true;
+			else if (!connected && error == ERROR_IO_PENDING)
+			{
+				DWORD unused;
+				HANDLE events[2] = { ov.hEvent, close_event };
+				if (WaitForMultipleObjects(2, events, FALSE, INFINITE) == WAIT_OBJECT_0)
+					connected = GetOverlappedResult(pipe, &ov, &unused, FALSE);
+				else
+				{
+					// The OVERLAPPED must outlive the operation
+					CancelIoEx(pipe, &ov);
+					GetOverlappedResult(pipe, &ov, &unused, TRUE);
+				}
+			}
+			CloseHandle(ov.hEvent);
+
+			if (connected && !closed) return std::make_unique<LocalStream>(pipe);
+			CloseHandle(pipe);
+		}
+		return nullptr;
+	}
+
+	void LocalServer::Close()
+	{
+		if (closed.exchange(true)) return;
+		if (close_event != NULL) SetEvent(close_event);
+	}
+#else
+	LocalStream::~LocalStream()
+	{
+		close(fd);
+	}
+
+	size_t LocalStream::Read(char* buf, size_t size)
+	{
+		ssize_t n;
+		do n = recv(fd, buf, size, 0);
+		while (n < 0 && errno == EINTR);
+		return n > 0 ? (size_t)n : 0;
+	}
+
+	bool LocalStream::Write(const char* data, size_t size)
+	{
+		while (size > 0)
+		{
+			ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			data += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	void LocalStream::Shutdown()
+	{
+		shutdown(fd, SHUT_RDWR);
+	}
+
+	LocalServer::~LocalServer()
+	{
+		Close();
+		if (fd >= 0) close(fd);
+	}
+
+	std::string LocalServer::DefaultAddress()
+	{
+		return "/tmp/MCF_RemoteConsole_" + std::to_string(getpid()) + ".sock";
+	}
+
+	bool LocalServer::Listen(const char* address)
+	{
+		if (!closed) return false;
+		if (fd >= 0) close(fd);
+
+		sockaddr_un addr{ };
+		addr.sun_family = AF_UNIX;
+		if (strlen(address) >= sizeof(addr.sun_path)) return false;
+		strcpy(addr.sun_path, address);
+
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd < 0) return false;
+
+		// Replace a socket left behind by a previous process, but never another kind of file
+		struct stat st;
+		if (lstat(address, &st) == 0)
+		{
+			if (!S_ISSOCK(st.st_mode))
+			{
+				close(fd);
+				fd = -1;
+				return false;
+			}
+			unlink(address);
+		}
+
+		if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0)
+		{
+			close(fd);
+			fd = -1;
+			return false;
+		}
+
+		this->address = address;
+		closed = false;
+		return true;
+	}
+
+	std::unique_ptr<LocalStream> LocalServer::Accept()
+	{
+		while (!closed)
+		{
+			int client = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+			if (client >= 0) return std::make_unique<LocalStream>(client);
+			if (errno != EINTR && errno != ECONNABORTED) break;
+		}
+		return nullptr;
+	}
+
+	void LocalServer::Close()
+	{
+		if (closed.exchange(true)) return;
+
+		// Shutting down the socket wakes up a pending accept. It is closed later, as that thread may still use it
+		shutdown(fd, SHUT_RDWR);
+
+		struct stat st;
+		if (lstat(address.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) unlink(address.c_str());
+	}
+#endif
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace MCF
+{
+	/// <summary>
+	/// Connected stream of a LocalServer: a named pipe instance on Windows, a Unix domain socket elsewhere.
+	/// Reads and writes block the calling thread, but a read and a write may be pending on two threads at once.
+	/// </summary>
+	class LocalStream
+	{
+	private:
+#ifdef _WIN32
+		// The pipe is opened for overlapped I/O, as synchronous I/O on a pipe handle is serialized
+		HANDLE handle;
+		HANDLE read_event;
+		HANDLE write_event;
+#else
+		int fd;
+#endif
+
+	public:
+#ifdef _WIN32
+		LocalStream(HANDLE handle);
+#else
+		LocalStream(int fd) : fd(fd) { }
+#endif
+		LocalStream(LocalStream&) = delete;
+		~LocalStream();
+
+		/// <summary>
+		/// Read up to size bytes. Returns the number of bytes read, or 0 once the stream is closed.
+		/// </summary>
+		size_t Read(char* buf, size_t size);
+
+		/// <summary>
+		/// Write a whole buffer. Returns false if the stream was closed.
+		/// </summary>
+		bool Write(const char* data, size_t size);
+
+		/// <summary>
+		/// Close the connection, making pending reads and writes on other threads fail.
+		/// </summary>
+		void Shutdown();
+	};
+
+	/// <summary>
+	/// Listener for local connections on a named pipe (Windows) or a Unix domain socket path.
+	/// </summary>
+	class LocalServer
+	{
+	private:
+		std::string address;
+		std::atomic<bool> closed = true;
+#ifdef _WIN32
+		HANDLE close_event = NULL; // Set by Close to stop a pending Accept
+#else
+		int fd = -1;
+#endif
+
+	public:
+		LocalServer() { }
+		LocalServer(LocalServer&) = delete;
+		~LocalServer();
+
+		/// <summary>
+		/// Default address for this process, "\\.\pipe\MCF_RemoteConsole_PID" or "/tmp/MCF_RemoteConsole_PID.sock".
+		/// </summary>
+		static std::string DefaultAddress();
+
+		/// <summary>
+		/// Start listening. On Unix, an existing socket file at the address is replaced, but any other file is not.
+		/// </summary>
+		bool Listen(const char* address);
+
+		/// <summary>
+		/// Wait for the next client. Returns null once the server is closed.
+		/// </summary>
+		std::unique_ptr<LocalStream> Accept();
+
+		/// <summary>
+		/// Stop listening, making a pending Accept on another thread return null.
+		/// The server can listen again once that thread is done with it.
+		/// </summary>
+		void Close();
+
+		const std::string& Address() const { return address; }
+	};
+}
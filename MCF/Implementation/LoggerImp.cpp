@@ -1,16 +1,219 @@
 #include "LoggerImp.h"
 
+namespace
+{
+	/// <summary>
+	/// Reusable per-thread string buffer. Buffers are pooled by nesting depth, since event listeners may log themselves.
+	/// </summary>
+	class ScratchString
+	{
+		static constexpr int PoolSize = 4;
+		static thread_local std::string pool[PoolSize];
+		static thread_local int depth;
+
+		std::string local;
+		std::string* str;
+
+	public:
+		ScratchString() : str(depth < PoolSize ? &pool[depth] : &local) { depth++; str->clear(); }
+		~ScratchString() { depth--; }
+
+		std::string& operator*() { return *str; }
+		std::string* operator->() { return str; }
+	};
+	thread_local std::string ScratchString::pool[ScratchString::PoolSize];
+	thread_local int ScratchString::depth = 0;
+
+	int64_t SteadyNow()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
 namespace MCF
 {
-	void LoggerImp::Log(const char* source, const char* severity, const char* message)
+	LoggerImp::LoggerImp() :
+		flags_table(new std::atomic<uint32_t>[MaxLogSources]),
+		sources(new SourceState[MaxLogSources])
 	{
-		std::shared_lock<decltype(filter_mutex)> lock(filter_mutex);
+		source_flags = flags_table.get();
+
+		// Source 0 collects messages from unregistered sources and from sources registered past the table size
+		sources[InvalidLogSource].name = "unknown";
+		flags_table[InvalidLogSource].store(SourceEnabled | SourcePassesFilter);
+		for (LogSourceId i = 1; i < MaxLogSources; i++) flags_table[i].store(0);
+		source_ids["unknown"] = InvalidLogSource;
+		source_count = 1;
 
-		if ((re_flags & SRC_MASK) && !std::regex_search(source, re_src)) return;
+		if (recorder_writer.Open(4096)) PublishRecorder(&recorder_writer);
+	}
+
+	LogSourceId LoggerImp::RegisterSource(const char* name)
+	{
+		return AddSource(name, false);
+	}
+
+	LogSourceId LoggerImp::FindSource(const char* name)
+	{
+		return AddSource(name, true);
+	}
+
+	LogSourceId LoggerImp::AddSource(const char* name, bool implicit)
+	{
+		{
+			std::shared_lock<decltype(source_mutex)> lock(source_mutex);
+			auto it = source_ids.find(std::string_view(name));
+			if (it != source_ids.end()) return it->second;
+		}
+
+		std::unique_lock<decltype(source_mutex)> lock(source_mutex);
+		auto it = source_ids.find(std::string_view(name));
+		if (it != source_ids.end()) return it->second;
+
+		LogSourceId id = source_count.load(std::memory_order_relaxed);
+		if (id >= MaxLogSources) return InvalidLogSource;
+		if (implicit && implicit_count >= MaxImplicitSources) return InvalidLogSource;
+		if (implicit) implicit_count++;
+
+		SourceState& state = sources[id];
+		state.name = name;
+		source_ids.emplace(state.name, id);
+
+		// Publish under both config locks so that concurrent SetFilter/SetRule calls see the new source
+		std::shared_lock<decltype(config_mutex)> cfg_lock(config_mutex);
+		std::lock_guard<decltype(limit_mutex)> limit_lock(limit_mutex);
+
+		uint32_t flags = SourceEnabled;
+		if (recorder.load() != nullptr) flags |= SourceRecorded;
+		if (!(re_flags & SRC_MASK) || std::regex_search(name, re_src)) flags |= SourcePassesFilter;
+		if (ApplyRules(state)) flags |= SourceLimited;
+
+		flags_table[id].store(flags, std::memory_order_release);
+		source_count.store(id + 1, std::memory_order_release);
+		return id;
+	}
+
+	const char* LoggerImp::SourceName(LogSourceId source)
+	{
+		if (source >= source_count.load(std::memory_order_acquire)) source = InvalidLogSource;
+		return sources[source].name.c_str();
+	}
+
+	void LoggerImp::SetSourceEnabled(LogSourceId source, bool enabled)
+	{
+		if (source >= source_count.load(std::memory_order_acquire)) return;
+
+		if (enabled) flags_table[source].fetch_or(SourceEnabled);
+		else flags_table[source].fetch_and(~SourceEnabled);
+	}
+
+	void LoggerImp::Log(LogSourceId source, const char* severity, const char* message)
+	{
+		if (source >= MaxLogSources) source = InvalidLogSource;
+
+		// Preformatted messages are often built in reused buffers, so they are keyed on their text rather than address
+		uint32_t flags = flags_table[source].load(std::memory_order_relaxed);
+		if ((flags & SourceLimited) && (flags & (SourceEnabled | SourceRecorded)) &&
+			!Admit(source, severity, (const void*)std::hash<std::string_view>{}(message))) return;
+
+		LogAdmitted(source, severity, message);
+	}
+
+	void LoggerImp::LogAdmitted(LogSourceId source, const char* severity, const char* message)
+	{
+		if (source >= MaxLogSources) source = InvalidLogSource;
+
+		if (repeats_deadline.load(std::memory_order_relaxed) != INT64_MAX) FlushRepeats();
+
+		uint32_t flags = flags_table[source].load(std::memory_order_relaxed);
+		if (flags & SourceRecorded) WriteRecorder(source, severity, message, nullptr, 0);
+		if (!(flags & SourceEnabled)) return;
+
+		Dispatch(source, flags, severity, message, nullptr, 0);
+	}
+
+	void LoggerImp::LogFields(LogSourceId source, const char* severity, const char* message, const LogField* fields, size_t count)
+	{
+		if (source >= MaxLogSources) source = InvalidLogSource;
+
+		if (repeats_deadline.load(std::memory_order_relaxed) != INT64_MAX) FlushRepeats();
+
+		uint32_t flags = flags_table[source].load(std::memory_order_relaxed);
+		if (!(flags & (SourceEnabled | SourceRecorded))) return;
+		if ((flags & SourceLimited) && !Admit(source, severity, message)) return;
+
+		ScratchString record;
+		LogRecord::Encode(*record, fields, count);
+		if (flags & SourceRecorded) WriteRecorder(source, severity, message, record->data(), record->size());
+		if (flags & SourceEnabled) Dispatch(source, flags, severity, message, record->data(), record->size());
+	}
+
+	void LoggerImp::WriteRecorder(LogSourceId source, const char* severity, const char* message, const char* fields, size_t fields_size)
+	{
+		recorder_writers.fetch_add(1);
+		FlightRecorderWriter* writer = recorder.load();
+		if (writer != nullptr) writer->Write(sources[source].name.c_str(), severity, message, fields, fields_size);
+		recorder_writers.fetch_sub(1, std::memory_order_release);
+	}
+
+	void LoggerImp::PublishRecorder(FlightRecorderWriter* writer)
+	{
+		{
+			// Excludes RegisterSource, which sets SourceRecorded on new sources from the published pointer
+			std::shared_lock<decltype(source_mutex)> lock(source_mutex);
+			recorder.store(writer);
+
+			LogSourceId count = source_count.load(std::memory_order_acquire);
+			for (LogSourceId i = 0; i < count; i++)
+			{
+				if (writer != nullptr) flags_table[i].fetch_or(SourceRecorded);
+				else flags_table[i].fetch_and(~SourceRecorded);
+			}
+		}
+
+		// A writer which loaded the previous pointer has already been counted
+		while (recorder_writers.load() != 0) std::this_thread::yield();
+	}
+
+	void LoggerImp::Dispatch(LogSourceId source, uint32_t flags, const char* severity, const char* message, const char* fields, size_t fields_size)
+	{
+		const char* name = sources[source].name.c_str();
+		std::shared_lock<decltype(config_mutex)> lock(config_mutex);
+
+		if (!(flags & SourcePassesFilter)) return;
 		if ((re_flags & SEV_MASK) && !std::regex_search(severity, re_sev)) return;
 		if ((re_flags & MSG_MASK) && !std::regex_search(message, re_msg)) return;
 
-		C<EventMan>()->RaiseEvent(LogEvent{ .source = source, .sev = severity, .msg = message });
+		EventMan* events = C<EventMan>();
+		if (events->HasListeners(StructuredLogEvent::name))
+		{
+			events->RaiseEvent(StructuredLogEvent{
+				.source = name,
+				.source_id = source,
+				.sev = severity,
+				.msg = message,
+				.fields = (const uint8_t*)fields,
+				.fields_size = fields_size
+			});
+		}
+
+		if (fields_size == 0)
+		{
+			events->RaiseEvent(LogEvent{ .source = name, .sev = severity, .msg = message, .source_id = source });
+		}
+		else if (events->HasListeners(LogEvent::name))
+		{
+			ScratchString text;
+			text->append(message);
+			text->push_back(' ');
+			LogRecord::RenderText(*text, (const uint8_t*)fields, fields_size);
+			events->RaiseEvent(LogEvent{ .source = name, .sev = severity, .msg = text->c_str(), .source_id = source });
+		}
+	}
+
+	void LoggerImp::Log(const char* source, const char* severity, const char* message)
+	{
+		Log(FindSource(source), severity, message);
 	}
 
 	void LoggerImp::Log(const char* source, const char* severity, const wchar_t* message)
@@ -25,15 +228,27 @@ namespace MCF
 
 	void LoggerImp::SetFilter(const char* src_regex, const char* sev_regex, const char* msg_regex)
 	{
-		std::unique_lock<decltype(filter_mutex)> lock(filter_mutex);
+		std::unique_lock<decltype(config_mutex)> lock(config_mutex);
 
 		if (src_regex == FilterRemove) re_flags &= ~SRC_MASK;
 		if (sev_regex == FilterRemove) re_flags &= ~SEV_MASK;
 		if (msg_regex == FilterRemove) re_flags &= ~MSG_MASK;
 
-		if (src_regex != nullptr) { re_src = std::regex(src_regex); re_flags |= SRC_MASK; }
-		if (sev_regex != nullptr) { re_sev = std::regex(sev_regex); re_flags |= SEV_MASK; }
-		if (msg_regex != nullptr) { re_msg = std::regex(msg_regex); re_flags |= MSG_MASK; }
+		if (src_regex != nullptr && src_regex != FilterRemove) { re_src = std::regex(src_regex); re_flags |= SRC_MASK; }
+		if (sev_regex != nullptr && sev_regex != FilterRemove) { re_sev = std::regex(sev_regex); re_flags |= SEV_MASK; }
+		if (msg_regex != nullptr && msg_regex != FilterRemove) { re_msg = std::regex(msg_regex); re_flags |= MSG_MASK; }
+
+		// The source filter is evaluated once per source rather than once per message
+		if (src_regex == nullptr) return;
+
+		LogSourceId count = source_count.load(std::memory_order_acquire);
+		for (LogSourceId i = 1; i < count; i++)
+		{
+			if (!(re_flags & SRC_MASK) || std::regex_search(sources[i].name, re_src))
+				flags_table[i].fetch_or(SourcePassesFilter);
+			else
+				flags_table[i].fetch_and(~SourcePassesFilter);
+		}
 	}
 
 	void LoggerImp::SetFilter(const char* src_regex, const char* sev_regex, const wchar_t* msg_regex)
@@ -49,4 +264,202 @@ namespace MCF
 		}
 		else SetFilter(src_regex, sev_regex, (const char*)msg_regex);
 	}
+
+	bool LoggerImp::EnableFlightRecorder(uint32_t slot_count, const char* backing_file)
+	{
+		std::lock_guard<decltype(recorder_mutex)> lock(recorder_mutex);
+
+		// The segment name is per-process, so the previous ring must be closed before the new one is created
+		PublishRecorder(nullptr);
+		if (!recorder_writer.Open(slot_count, backing_file)) return false;
+		PublishRecorder(&recorder_writer);
+		return true;
+	}
+
+	void LoggerImp::DisableFlightRecorder()
+	{
+		std::lock_guard<decltype(recorder_mutex)> lock(recorder_mutex);
+		PublishRecorder(nullptr);
+		recorder_writer.Close();
+	}
+
+	bool LoggerImp::ApplyRules(SourceState& state)
+	{
+		// Later rules take precedence. Rules without a pattern are defaults for all sources.
+		state.rate = 0;
+		state.dedup_window = 0;
+
+		for (const auto& rule : rate_rules)
+		{
+			if (!rule.pattern.empty() && !std::regex_search(state.name, rule.regex)) continue;
+			state.rate = rule.rate;
+			state.burst = (float)rule.burst_or_window;
+		}
+		for (const auto& rule : dedup_rules)
+		{
+			if (!rule.pattern.empty() && !std::regex_search(state.name, rule.regex)) continue;
+			state.dedup_window = (int64_t)rule.burst_or_window * 1'000'000;
+		}
+		state.tokens = state.burst;
+		return state.rate > 0 || state.dedup_window > 0;
+	}
+
+	void LoggerImp::SetRule(std::vector<LimitRule>& rules, const char* source_regex, float rate, uint32_t burst_or_window)
+	{
+		std::lock_guard<decltype(limit_mutex)> lock(limit_mutex);
+
+		std::string pattern = source_regex == nullptr ? "" : source_regex;
+		std::erase_if(rules, [&](const LimitRule& r) { return r.pattern == pattern; });
+		if (burst_or_window != 0)
+		{
+			rules.push_back(LimitRule{
+				.pattern = pattern,
+				.regex = pattern.empty() ? std::regex() : std::regex(pattern),
+				.rate = rate,
+				.burst_or_window = burst_or_window
+			});
+		}
+
+		LogSourceId count = source_count.load(std::memory_order_acquire);
+		for (LogSourceId i = 0; i < count; i++)
+		{
+			if (ApplyRules(sources[i])) flags_table[i].fetch_or(SourceLimited);
+			else flags_table[i].fetch_and(~SourceLimited);
+		}
+	}
+
+	bool LoggerImp::Admit(LogSourceId source, const char* severity, const void* fmt_key)
+	{
+		if (source >= MaxLogSources) source = InvalidLogSource;
+
+		uint32_t repeats = 0;
+		{
+			std::lock_guard<decltype(limit_mutex)> lock(limit_mutex);
+
+			SourceState& state = sources[source];
+			int64_t now = SteadyNow();
+
+			if (state.dedup_window != 0 && fmt_key != nullptr)
+			{
+				if (state.formats.size() >= MaxTrackedFormats && !state.formats.contains(fmt_key))
+				{
+					std::erase_if(state.formats, [&](const auto& entry) {
+						return !entry.second.pending && now - entry.second.window_start >= state.dedup_window;
+					});
+				}
+
+				FormatState& fmt = state.formats[fmt_key];
+				if (fmt.window_start != 0 && now - fmt.window_start < state.dedup_window)
+				{
+					fmt.repeats++;
+					if (!fmt.pending)
+					{
+						fmt.pending = true;
+						fmt.severity = severity;
+						pending_repeats.push_back(PendingRepeat{ .source = source, .fmt_key = fmt_key });
+					}
+					int64_t window_end = fmt.window_start + state.dedup_window;
+					if (window_end < repeats_deadline.load(std::memory_order_relaxed))
+						repeats_deadline.store(window_end, std::memory_order_relaxed);
+
+					state.metrics.duplicates++;
+					total_duplicates.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				repeats = fmt.repeats;
+				fmt.repeats = 0;
+				fmt.window_start = now;
+			}
+
+			if (state.rate > 0)
+			{
+				state.tokens = (std::min)(state.burst, state.tokens + (float)(now - state.last_refill) * state.rate * 1e-9f);
+				state.last_refill = now;
+				if (state.tokens < 1.0f)
+				{
+					state.metrics.rate_limited++;
+					total_rate_limited.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				state.tokens -= 1.0f;
+			}
+		}
+
+		if (repeats > 0)
+		{
+			auto message = std::format("Previous message repeated {} times", repeats);
+			LogAdmitted(source, severity, message.c_str());
+		}
+		return true;
+	}
+
+	void LoggerImp::FlushRepeats()
+	{
+		int64_t now = SteadyNow();
+		if (now < repeats_deadline.load(std::memory_order_relaxed)) return;
+
+		struct Summary
+		{
+			LogSourceId source;
+			std::string severity;
+			uint32_t repeats;
+		};
+		std::vector<Summary> summaries;
+		{
+			std::lock_guard<decltype(limit_mutex)> lock(limit_mutex);
+
+			int64_t deadline = INT64_MAX;
+			std::erase_if(pending_repeats, [&](const PendingRepeat& pending)
+			{
+				SourceState& state = sources[pending.source];
+				FormatState& fmt = state.formats[pending.fmt_key];
+
+				int64_t window_end = fmt.window_start + state.dedup_window;
+				if (fmt.repeats != 0 && now < window_end)
+				{
+					deadline = (std::min)(deadline, window_end);
+					return false;
+				}
+
+				// A repeat logged after the window may already have taken the count in Admit
+				if (fmt.repeats != 0) summaries.push_back(Summary{ .source = pending.source, .severity = fmt.severity, .repeats = fmt.repeats });
+				fmt.repeats = 0;
+				fmt.pending = false;
+				return true;
+			});
+			repeats_deadline.store(deadline, std::memory_order_relaxed);
+		}
+
+		for (const auto& summary : summaries)
+		{
+			auto message = std::format("Previous message repeated {} times", summary.repeats);
+			LogAdmitted(summary.source, summary.severity.c_str(), message.c_str());
+		}
+	}
+
+	void LoggerImp::SetRateLimit(const char* source_regex, float msgs_per_sec, uint32_t burst)
+	{
+		SetRule(rate_rules, source_regex, msgs_per_sec, msgs_per_sec > 0 ? (std::max)(burst, 1u) : 0);
+	}
+
+	void LoggerImp::SetDuplicateSuppression(const char* source_regex, uint32_t window_ms)
+	{
+		SetRule(dedup_rules, source_regex, 0, window_ms);
+	}
+
+	Logger::LogMetrics LoggerImp::GetTotalMetrics()
+	{
+		return LogMetrics{
+			.rate_limited = total_rate_limited.load(std::memory_order_relaxed),
+			.duplicates = total_duplicates.load(std::memory_order_relaxed)
+		};
+	}
+
+	Logger::LogMetrics LoggerImp::GetMetrics(LogSourceId source)
+	{
+		if (source >= source_count.load(std::memory_order_acquire)) return LogMetrics{ };
+
+		std::lock_guard<decltype(limit_mutex)> lock(limit_mutex);
+		return sources[source].metrics;
+	}
 }
@@ -1,8 +1,13 @@
 #pragma once
 #include "Include/Logger.h"
+#include "FlightRecorderWriter.h"
 #include <regex>
 #include <mutex>
 #include <shared_mutex>
+#include <atomic>
+#include <chrono>
+#include <string_view>
+#include <thread>
 
 namespace MCF
 {
@@ -12,19 +17,133 @@ namespace MCF
 		std::regex re_src;
 		std::regex re_sev;
 		std::regex re_msg;
-		uint32_t re_flags;
+		uint32_t re_flags = 0;
 
-		std::shared_mutex filter_mutex;
+		/// <summary>
+		/// The flight recorder is written without locking. Writers count themselves in recorder_writers before loading
+		/// the recorder pointer, so that it can be unpublished and the ring unmapped once the count drops to zero.
+		/// </summary>
+		FlightRecorderWriter recorder_writer;
+		std::atomic<FlightRecorderWriter*> recorder = nullptr;
+		std::atomic<uint32_t> recorder_writers = 0;
+		std::mutex recorder_mutex; // Serializes EnableFlightRecorder and DisableFlightRecorder
+
+		struct StringHash
+		{
+			using is_transparent = void;
+			size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+		};
+
+		/// <summary>
+		/// Rate limit or duplicate suppression settings applied to the sources matching a regex.
+		/// An empty pattern matches all sources.
+		/// </summary>
+		struct LimitRule
+		{
+			std::string pattern;
+			std::regex regex;
+			float rate;
+			uint32_t burst_or_window;
+		};
+
+		struct FormatState
+		{
+			int64_t window_start = 0;
+			uint32_t repeats = 0;
+			bool pending = false; // In pending_repeats
+			std::string severity; // Severity of the first suppressed repeat
+		};
+
+		struct PendingRepeat
+		{
+			LogSourceId source;
+			const void* fmt_key;
+		};
+
+		/// <summary>
+		/// State of a registered source. Entries live in a flat array indexed by LogSourceId and are never moved,
+		/// so their flags can be read without locking.
+		/// </summary>
+		struct SourceState
+		{
+			std::string name;
+			float rate = 0;
+			float burst = 0;
+			float tokens = 0;
+			int64_t last_refill = 0;
+			int64_t dedup_window = 0;
+			std::unordered_map<const void*, FormatState> formats; // Bounded by MaxTrackedFormats
+			LogMetrics metrics{ };
+		};
+
+		std::unique_ptr<std::atomic<uint32_t>[]> flags_table;
+		std::unique_ptr<SourceState[]> sources;
+		std::atomic<LogSourceId> source_count = 0;
+		LogSourceId implicit_count = 0; // Sources registered by FindSource, guarded by source_mutex
+		std::unordered_map<std::string, LogSourceId, StringHash, std::equal_to<>> source_ids;
+		std::shared_mutex source_mutex;
+
+		std::vector<LimitRule> rate_rules;
+		std::vector<LimitRule> dedup_rules;
+		std::mutex limit_mutex;
+
+		// Formats with suppressed repeats, whose summary is logged by the first message after their window ends
+		std::vector<PendingRepeat> pending_repeats;
+		// End of the earliest window in pending_repeats, checked by every message
+		std::atomic<int64_t> repeats_deadline = INT64_MAX;
+
+		// Formats tracked by duplicate suppression per source, past which those whose window ended are forgotten
+		static constexpr size_t MaxTrackedFormats = 1024;
+
+		std::atomic<uint64_t> total_rate_limited = 0;
+		std::atomic<uint64_t> total_duplicates = 0;
+
+		LogSourceId AddSource(const char* name, bool implicit);
+
+		void Dispatch(LogSourceId source, uint32_t flags, const char* severity, const char* message, const char* fields, size_t fields_size);
+
+		void WriteRecorder(LogSourceId source, const char* severity, const char* message, const char* fields, size_t fields_size);
+		// Publish a new recorder (or null), update the SourceRecorded flags and wait for writers of the previous one
+		void PublishRecorder(FlightRecorderWriter* writer);
+
+		// Returns true if a rate limit or duplicate suppression rule applies to the source
+		bool ApplyRules(SourceState& state);
+		// Log the summaries of the pending repeats whose window has ended
+		void FlushRepeats();
+		// Adds or replaces the rule with this pattern, or removes it if burst_or_window is 0
+		void SetRule(std::vector<LimitRule>& rules, const char* source_regex, float rate, uint32_t burst_or_window);
+
+		std::shared_mutex config_mutex;
 
 		static constexpr uint32_t SRC_MASK = 1;
 		static constexpr uint32_t SEV_MASK = 2;
 		static constexpr uint32_t MSG_MASK = 4;
 
 	public:
+		LoggerImp();
+
+		virtual LogSourceId RegisterSource(const char* name) override;
+		virtual const char* SourceName(LogSourceId source) override;
+		virtual void SetSourceEnabled(LogSourceId source, bool enabled) override;
+
+		virtual void Log(LogSourceId source, const char* severity, const char* message) override;
 		virtual void Log(const char* source, const char* severity, const char* message) override;
 		virtual void Log(const char* source, const char* severity, const wchar_t* message) override;
 
+		virtual void LogFields(LogSourceId source, const char* severity, const char* message, const LogField* fields, size_t count) override;
+
 		virtual void SetFilter(const char* source_regex, const char* sev_regex, const char* msg_regex) override;
 		virtual void SetFilter(const char* source_regex, const char* sev_regex, const wchar_t* msg_regex) override;
+
+		virtual bool EnableFlightRecorder(uint32_t slot_count, const char* backing_file = nullptr) override;
+		virtual void DisableFlightRecorder() override;
+
+		virtual bool Admit(LogSourceId source, const char* severity, const void* fmt_key) override;
+		virtual void SetRateLimit(const char* source_regex, float msgs_per_sec, uint32_t burst) override;
+		virtual void SetDuplicateSuppression(const char* source_regex, uint32_t window_ms) override;
+		virtual LogMetrics GetMetrics(LogSourceId source) override;
+		virtual void LogAdmitted(LogSourceId source, const char* severity, const char* message) override;
+		virtual LogMetrics GetTotalMetrics() override;
+		virtual LogSourceId FindSource(const char* name) override;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "MemoryRegions.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+namespace MCF
+{
+	namespace MemoryRegions
+	{
+		static void Append(std::vector<Region>& regions, uintptr_t begin, size_t size)
+		{
+			if (!regions.empty() && regions.back().begin + regions.back().size == begin) regions.back().size += size;
+			else regions.push_back(Region{ .begin = begin, .size = size });
+		}
+
+#ifdef _WIN32
+		std::vector<Region> Writable()
+		{
+			constexpr DWORD writable = PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+
+			std::vector<Region> regions;
+			MEMORY_BASIC_INFORMATION mbi;
+			for (uintptr_t p = 0; VirtualQuery((LPCVOID)p, &mbi, sizeof(mbi)) == sizeof(mbi); p = (uintptr_t)mbi.BaseAddress + mbi.RegionSize)
+			{
+				if (mbi.State == MEM_COMMIT && (mbi.Protect & writable) && !(mbi.Protect & (PAGE_GUARD | PAGE_NOACCESS)))
+					Append(regions, (uintptr_t)mbi.BaseAddress, mbi.RegionSize);
+			}
+			return regions;
+		}
+
+		bool SafeRead(uintptr_t address, void* out, size_t size)
+		{
+			SIZE_T read = 0;
+			return ReadProcessMemory(GetCurrentProcess(), (LPCVOID)address, out, size, &read) && read == size;
+		}
+#else
+		std::vector<Region> Writable()
+		{
+			std::vector<Region> regions;
+			FILE* maps = fopen("/proc/self/maps", "r");
+			if (maps == nullptr) return regions;
+
+			char line[512];
+			while (fgets(line, sizeof(line), maps))
+			{
+				unsigned long long begin, end;
+				char perms[5], path[256] = "";
+				if (sscanf(line, "%llx-%llx %4s %*s %*s %*s %255s", &begin, &end, perms, path) < 3) continue;
+
+				// Reading device memory may have side effects, and [vvar] is not readable through SafeRead
+				if (perms[0] != 'r' || perms[1] != 'w' || strncmp(path, "/dev/", 5) == 0 || strcmp(path, "[vvar]") == 0) continue;
+				Append(regions, (uintptr_t)begin, (size_t)(end - begin));
+			}
+			fclose(maps);
+			return regions;
+		}
+
+		bool SafeRead(uintptr_t address, void* out, size_t size)
+		{
+			iovec local{ .iov_base = out, .iov_len = size };
+			iovec remote{ .iov_base = (void*)address, .iov_len = size };
+			return process_vm_readv(getpid(), &local, 1, &remote, 1, 0) == (ssize_t)size;
+		}
+#endif
+	}
+}
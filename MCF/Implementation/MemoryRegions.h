@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Enumeration of the memory of the current process, and reads which do not fault if it is freed concurrently.
+	/// </summary>
+	namespace MemoryRegions
+	{
+		struct Region
+		{
+			uintptr_t begin;
+			size_t size;
+		};
+
+		/// <summary>
+		/// Committed, readable and writable regions of the process, sorted by address, with adjacent regions merged.
+		/// Guard pages and mapped devices are excluded.
+		/// </summary>
+		std::vector<Region> Writable();
+
+		/// <summary>
+		/// Copy size bytes at address to out, through the OS rather than by dereferencing them.
+		/// </summary>
+		/// <returns>False if part of the range is not readable.</returns>
+		bool SafeRead(uintptr_t address, void* out, size_t size);
+	}
+}
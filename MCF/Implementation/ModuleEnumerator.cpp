@@ -0,0 +1,144 @@
+#include "ModuleEnumerator.h"
+#include <string.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <link.h>
+#include <unistd.h>
+#endif
+
+namespace MCF
+{
+	namespace ModuleEnumerator
+	{
+		namespace
+		{
+			using ModuleInfo = ModuleTypes::ModuleInfo;
+			using SectionInfo = ModuleTypes::SectionInfo;
+			using enum ModuleTypes::SectionFlags;
+
+			void CopyName(char* dst, size_t size, const char* path)
+			{
+				const char* name = path;
+				for (const char* p = path; *p; p++)
+					if (*p == '/' || *p == '\\') name = p + 1;
+
+				size_t len = (std::min)(strlen(name), size - 1);
+				memcpy(dst, name, len);
+				dst[len] = 0;
+			}
+		}
+
+#ifdef _WIN32
+		bool ReadModule(uintptr_t base, const char* name, ModuleEntry& entry)
+		{
+			auto dos = (const IMAGE_DOS_HEADER*)base;
+			if (dos->e_magic != IMAGE_DOS_SIGNATURE) return false;
+			auto nt = (const IMAGE_NT_HEADERS*)(base + dos->e_lfanew);
+			if (nt->Signature != IMAGE_NT_SIGNATURE) return false;
+
+			entry.info = ModuleInfo{ };
+			entry.info.base = base;
+			entry.info.size = nt->OptionalHeader.SizeOfImage;
+			entry.info.timestamp = nt->FileHeader.TimeDateStamp;
+			entry.info.num_sections = nt->FileHeader.NumberOfSections;
+			CopyName(entry.info.name, sizeof(entry.info.name), name);
+
+			entry.sections.clear();
+			const IMAGE_SECTION_HEADER* headers = IMAGE_FIRST_SECTION(nt);
+			for (WORD i = 0; i < nt->FileHeader.NumberOfSections; i++)
+			{
+				const IMAGE_SECTION_HEADER& header = headers[i];
+				SectionInfo section{ };
+				section.begin = base + header.VirtualAddress;
+				section.size = header.Misc.VirtualSize ? header.Misc.VirtualSize : header.SizeOfRawData;
+				section.module_base = base;
+				if (header.Characteristics & IMAGE_SCN_MEM_READ) section.flags |= SectionRead;
+				if (header.Characteristics & IMAGE_SCN_MEM_WRITE) section.flags |= SectionWrite;
+				if (header.Characteristics & IMAGE_SCN_MEM_EXECUTE) section.flags |= SectionExecute;
+				memcpy(section.name, header.Name, sizeof(header.Name));
+				section.header = &header;
+				entry.sections.push_back(section);
+			}
+			return true;
+		}
+
+		std::vector<ModuleEntry> Enumerate()
+		{
+			HANDLE process = GetCurrentProcess();
+			std::vector<HMODULE> handles;
+			DWORD needed = 0;
+			EnumProcessModules(process, nullptr, 0, &needed);
+			handles.resize(needed / sizeof(HMODULE));
+			if (!EnumProcessModules(process, handles.data(), needed, &needed)) handles.clear();
+			handles.resize((std::min)(handles.size(), needed / sizeof(HMODULE)));
+
+			std::vector<ModuleEntry> entries;
+			char name[MAX_PATH];
+			for (HMODULE handle : handles)
+			{
+				if (GetModuleBaseNameA(process, handle, name, sizeof(name)) == 0) continue;
+				ModuleEntry entry;
+				if (ReadModule((uintptr_t)handle, name, entry)) entries.push_back(std::move(entry));
+			}
+			return entries;
+		}
+
+#else
+		std::vector<ModuleEntry> Enumerate()
+		{
+			std::vector<ModuleEntry> entries;
+			dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) {
+				auto& entries = *(std::vector<ModuleEntry>*)data;
+				ModuleInfo module{ };
+				std::vector<SectionInfo> sections;
+
+				uintptr_t lo = UINTPTR_MAX, hi = 0;
+				for (ElfW(Half) i = 0; i < info->dlpi_phnum; i++)
+				{
+					const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+					if (phdr.p_type != PT_LOAD) continue;
+
+					SectionInfo section{ };
+					section.begin = info->dlpi_addr + phdr.p_vaddr;
+					section.size = phdr.p_memsz;
+					if (phdr.p_flags & PF_R) section.flags |= SectionRead;
+					if (phdr.p_flags & PF_W) section.flags |= SectionWrite;
+					if (phdr.p_flags & PF_X) section.flags |= SectionExecute;
+					section.name[0] = phdr.p_flags & PF_R ? 'r' : '-';
+					section.name[1] = phdr.p_flags & PF_W ? 'w' : '-';
+					section.name[2] = phdr.p_flags & PF_X ? 'x' : '-';
+					section.header = &phdr;
+					sections.push_back(section);
+
+					lo = (std::min)(lo, section.begin);
+					hi = (std::max)(hi, section.begin + section.size);
+				}
+				if (sections.empty()) return 0;
+
+				module.base = lo;
+				module.size = hi - lo;
+				module.num_sections = (uint32_t)sections.size();
+				for (auto& section : sections) section.module_base = lo;
+
+				// The main program is reported first, with an empty name
+				if (info->dlpi_name && info->dlpi_name[0]) CopyName(module.name, sizeof(module.name), info->dlpi_name);
+				else
+				{
+					char path[4096];
+					ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+					path[len < 0 ? 0 : len] = 0;
+					CopyName(module.name, sizeof(module.name), path);
+				}
+
+				entries.push_back({ module, std::move(sections) });
+				return 0;
+			}, &entries);
+			return entries;
+		}
+#endif
+	}
+}
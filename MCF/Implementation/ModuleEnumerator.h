@@ -0,0 +1,36 @@
+#pragma once
+#include "Include/ModuleTypes.h"
+#include <stdint.h>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Enumeration of the modules loaded in the process and of their sections, read from their PE headers on Windows
+	/// and from the program headers reported by dl_iterate_phdr elsewhere. Used by ModuleIndexImp, which keeps the
+	/// result up to date.
+	/// </summary>
+	namespace ModuleEnumerator
+	{
+		/// <summary>
+		/// A module along with its sections, as read from its headers.
+		/// </summary>
+		struct ModuleEntry
+		{
+			ModuleTypes::ModuleInfo info;
+			std::vector<ModuleTypes::SectionInfo> sections;
+		};
+
+		/// <summary>
+		/// Enumerate the loaded modules and read their headers. The main module comes first.
+		/// </summary>
+		std::vector<ModuleEntry> Enumerate();
+
+#ifdef _WIN32
+		/// <summary>
+		/// Read the PE headers of a loaded module. name may be a path, of which only the file name is kept.
+		/// </summary>
+		bool ReadModule(uintptr_t base, const char* name, ModuleEntry& entry);
+#endif
+	}
+}
@@ -0,0 +1,261 @@
+#include "ModuleIndexImp.h"
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace MCF
+{
+	namespace
+	{
+		bool NameEquals(const char* a, const char* b)
+		{
+			for (; *a && *b; a++, b++)
+				if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) return false;
+			return *a == *b;
+		}
+
+#ifdef _WIN32
+		// Layout of LDR_DLL_NOTIFICATION_DATA, which is the same for load and unload notifications
+		struct NtString
+		{
+			USHORT length;
+			USHORT max_length;
+			PWSTR buffer;
+		};
+		struct DllNotificationData
+		{
+			ULONG flags;
+			const NtString* full_name;
+			const NtString* base_name;
+			void* base;
+			ULONG size;
+		};
+
+		constexpr ULONG DllLoaded = 1;
+		constexpr ULONG DllUnloaded = 2;
+
+		typedef LONG(NTAPI* LdrRegisterDllNotificationFn)(ULONG, void*, void*, void**);
+		typedef LONG(NTAPI* LdrUnregisterDllNotificationFn)(void*);
+#endif
+	}
+
+	ModuleIndexImp::ModuleIndexImp()
+	{
+		std::lock_guard<decltype(update_mutex)> update_lock(update_mutex);
+
+#ifdef _WIN32
+		// Registered before enumerating, so that no module loaded in between is missed
+		HMODULE ntdll = GetModuleHandleA("ntdll.dll");
+		auto ldr_register = (LdrRegisterDllNotificationFn)GetProcAddress(ntdll, "LdrRegisterDllNotification");
+		if (ldr_register == nullptr || ldr_register(0, (void*)&OnDllNotification, this, &notification_cookie) < 0)
+			notification_cookie = nullptr;
+		else event_thread = std::thread(&ModuleIndexImp::EventLoop, this);
+#endif
+
+		std::vector<ModuleEntry> entries = ModuleEnumerator::Enumerate();
+		if (!entries.empty()) main_module = entries.front().info.base;
+		for (auto& entry : entries) Add(std::move(entry));
+	}
+
+	ModuleIndexImp::~ModuleIndexImp()
+	{
+#ifdef _WIN32
+		if (notification_cookie == nullptr) return;
+
+		HMODULE ntdll = GetModuleHandleA("ntdll.dll");
+		auto ldr_unregister = (LdrUnregisterDllNotificationFn)GetProcAddress(ntdll, "LdrUnregisterDllNotification");
+		if (ldr_unregister) ldr_unregister(notification_cookie);
+
+		{
+			std::lock_guard<decltype(events_mutex)> lock(events_mutex);
+			events_stop = true;
+		}
+		events_cv.notify_all();
+		event_thread.join();
+#endif
+	}
+
+	void ModuleIndexImp::EventLoop()
+	{
+		std::unique_lock<decltype(events_mutex)> lock(events_mutex);
+		while (true)
+		{
+			events_cv.wait(lock, [this] { return events_stop || !pending_events.empty(); });
+			if (events_stop) return;
+
+			PendingEvent pending = pending_events.front();
+			pending_events.pop_front();
+			lock.unlock();
+			if (pending.loaded) C<EventMan>()->RaiseEvent(ModuleLoadedEvent{ .module = pending.module });
+			else C<EventMan>()->RaiseEvent(ModuleUnloadedEvent{ .module = pending.module });
+			lock.lock();
+		}
+	}
+
+#ifdef _WIN32
+	void __stdcall ModuleIndexImp::OnDllNotification(unsigned long reason, const void* data, void* context)
+	{
+		auto self = (ModuleIndexImp*)context;
+		auto notification = (const DllNotificationData*)data;
+
+		ModuleEntry entry;
+		bool changed = false;
+		{
+			std::lock_guard<decltype(self->update_mutex)> update_lock(self->update_mutex);
+			if (reason == DllLoaded)
+			{
+				char name[MAX_PATH]{ };
+				if (notification->base_name)
+				{
+					WideCharToMultiByte(CP_UTF8, 0, notification->base_name->buffer, notification->base_name->length / sizeof(WCHAR),
+						name, sizeof(name) - 1, nullptr, nullptr);
+				}
+				changed = ModuleEnumerator::ReadModule((uintptr_t)notification->base, name, entry);
+				if (changed) self->Add(ModuleEntry(entry));
+			}
+			else if (reason == DllUnloaded) changed = self->Remove((uintptr_t)notification->base, entry.info);
+		}
+		if (!changed) return;
+
+		// The loader lock is held: the events are raised by the event thread
+		{
+			std::lock_guard<decltype(self->events_mutex)> lock(self->events_mutex);
+			self->pending_events.push_back(PendingEvent{ .loaded = reason == DllLoaded, .module = entry.info });
+		}
+		self->events_cv.notify_one();
+	}
+#endif
+
+	void ModuleIndexImp::Add(ModuleEntry&& entry)
+	{
+		std::unique_lock<decltype(mutex)> lock(mutex);
+
+		auto mod_it = std::lower_bound(modules.begin(), modules.end(), entry.info.base,
+			[](const ModuleInfo& m, uintptr_t base) { return m.base < base; });
+		if (mod_it != modules.end() && mod_it->base == entry.info.base) return;
+		modules.insert(mod_it, entry.info);
+
+		for (const SectionInfo& section : entry.sections)
+		{
+			auto it = std::upper_bound(sections.begin(), sections.end(), section.begin,
+				[](uintptr_t begin, const SectionInfo& s) { return begin < s.begin; });
+			sections.insert(it, section);
+		}
+		generation++;
+	}
+
+	bool ModuleIndexImp::Remove(uintptr_t base, ModuleInfo& removed)
+	{
+		std::unique_lock<decltype(mutex)> lock(mutex);
+
+		auto mod_it = std::lower_bound(modules.begin(), modules.end(), base,
+			[](const ModuleInfo& m, uintptr_t base) { return m.base < base; });
+		if (mod_it == modules.end() || mod_it->base != base) return false;
+		removed = *mod_it;
+		modules.erase(mod_it);
+
+		std::erase_if(sections, [&removed](const SectionInfo& s) { return s.module_base == removed.base; });
+		generation++;
+		return true;
+	}
+
+	void ModuleIndexImp::Refresh()
+	{
+		std::vector<ModuleInfo> loaded, unloaded;
+		{
+			std::lock_guard<decltype(update_mutex)> update_lock(update_mutex);
+			std::vector<ModuleEntry> entries = ModuleEnumerator::Enumerate();
+
+			std::vector<ModuleInfo> current;
+			{
+				std::shared_lock<decltype(mutex)> lock(mutex);
+				current = modules;
+			}
+
+			// Modules are matched by base, size and timestamp, in case a different one was loaded at the same address
+			auto same = [](const ModuleInfo& a, const ModuleInfo& b) {
+				return a.base == b.base && a.size == b.size && a.timestamp == b.timestamp;
+			};
+			for (const ModuleInfo& module : current)
+			{
+				bool found = std::any_of(entries.begin(), entries.end(), [&](const ModuleEntry& e) { return same(e.info, module); });
+				ModuleInfo removed;
+				if (!found && Remove(module.base, removed)) unloaded.push_back(removed);
+			}
+			for (ModuleEntry& entry : entries)
+			{
+				bool found = std::any_of(current.begin(), current.end(), [&](const ModuleInfo& m) { return same(entry.info, m); });
+				if (found) continue;
+				loaded.push_back(entry.info);
+				Add(std::move(entry));
+			}
+		}
+
+		for (const ModuleInfo& module : unloaded) C<EventMan>()->RaiseEvent(ModuleUnloadedEvent{ .module = module });
+		for (const ModuleInfo& module : loaded) C<EventMan>()->RaiseEvent(ModuleLoadedEvent{ .module = module });
+	}
+
+	bool ModuleIndexImp::FindModule(uintptr_t address, ModuleInfo* out)
+	{
+		std::shared_lock<decltype(mutex)> lock(mutex);
+		auto it = std::upper_bound(modules.begin(), modules.end(), address,
+			[](uintptr_t address, const ModuleInfo& m) { return address < m.base; });
+		if (it == modules.begin()) return false;
+		--it;
+		if (address - it->base >= it->size) return false;
+
+		*out = *it;
+		return true;
+	}
+
+	bool ModuleIndexImp::FindModuleByName(const char* name, ModuleInfo* out)
+	{
+		std::shared_lock<decltype(mutex)> lock(mutex);
+		for (const ModuleInfo& module : modules)
+		{
+			if (name ? NameEquals(module.name, name) : module.base == main_module)
+			{
+				*out = module;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ModuleIndexImp::FindSection(uintptr_t address, SectionInfo* out)
+	{
+		std::shared_lock<decltype(mutex)> lock(mutex);
+		auto it = std::upper_bound(sections.begin(), sections.end(), address,
+			[](uintptr_t address, const SectionInfo& s) { return address < s.begin; });
+		if (it == sections.begin()) return false;
+		--it;
+		if (address - it->begin >= it->size) return false;
+
+		*out = *it;
+		return true;
+	}
+
+	size_t ModuleIndexImp::GetModules(ModuleInfo* out, size_t max)
+	{
+		std::shared_lock<decltype(mutex)> lock(mutex);
+		std::copy_n(modules.begin(), (std::min)(max, modules.size()), out);
+		return modules.size();
+	}
+
+	size_t ModuleIndexImp::GetSections(uintptr_t module_base, SectionInfo* out, size_t max)
+	{
+		std::shared_lock<decltype(mutex)> lock(mutex);
+
+		// Modules do not overlap, so the sections of a module are contiguous
+		auto begin = std::lower_bound(sections.begin(), sections.end(), module_base,
+			[](const SectionInfo& s, uintptr_t base) { return s.begin < base; });
+		size_t count = 0;
+		for (auto it = begin; it != sections.end() && it->module_base == module_base; it++, count++)
+			if (count < max) out[count] = *it;
+		return count;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "Include/ModuleIndex.h"
+#include "Include/Export.h"
+#include "ModuleEnumerator.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+
+namespace MCF
+{
+	class ModuleIndexImp final : public SharedInterfaceImp<ModuleIndex, ModuleIndexImp, DepList<EventMan>>
+	{
+	private:
+		using ModuleEntry = ModuleEnumerator::ModuleEntry;
+
+		std::vector<ModuleInfo> modules; // Sorted by base
+		std::vector<SectionInfo> sections; // Sections of all modules, sorted by begin
+		uintptr_t main_module = 0;
+		std::shared_mutex mutex;
+		std::atomic<uint64_t> generation = 0;
+
+		// Serializes Refresh and load notifications, which update the index outside of the lock while reading headers
+		std::mutex update_mutex;
+		void* notification_cookie = nullptr;
+
+		/// <summary>
+		/// Change of the index made by a loader notification, whose event is raised by event_thread. Events cannot
+		/// be raised from the notification, since handlers run under EventMan's lock while the loader lock is held.
+		/// </summary>
+		struct PendingEvent
+		{
+			bool loaded;
+			ModuleInfo module;
+		};
+		std::deque<PendingEvent> pending_events;
+		bool events_stop = false;
+		std::mutex events_mutex;
+		std::condition_variable events_cv;
+		std::thread event_thread;
+
+		void EventLoop();
+
+		void Add(ModuleEntry&& entry);
+		bool Remove(uintptr_t base, ModuleInfo& removed);
+
+#ifdef _WIN32
+		static void __stdcall OnDllNotification(unsigned long reason, const void* data, void* context);
+#endif
+
+	public:
+		ModuleIndexImp();
+		~ModuleIndexImp();
+
+		virtual bool IsUnloadable() const override { return true; }
+
+		virtual bool FindModule(uintptr_t address, ModuleInfo* out) override;
+
+		virtual bool FindModuleByName(const char* name, ModuleInfo* out) override;
+
+		virtual bool FindSection(uintptr_t address, SectionInfo* out) override;
+
+		virtual size_t GetModules(ModuleInfo* out, size_t max) override;
+
+		virtual size_t GetSections(uintptr_t module_base, SectionInfo* out, size_t max) override;
+
+		virtual uint64_t Generation() override { return generation; }
+
+		virtual void Refresh() override;
+	};
+
+	MCF_COMPONENT_EXPORT(ModuleIndexImp);
+}
@@ -0,0 +1,44 @@
+#include "ModuleRef.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#include <sys/auxv.h>
+#endif
+
+namespace MCF
+{
+#ifdef _WIN32
+	ModuleRef::ModuleRef(uintptr_t base)
+	{
+		HMODULE module;
+		if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (LPCSTR)base, &module)) return;
+		if ((uintptr_t)module == base) handle = module;
+		else FreeLibrary(module);
+	}
+
+	ModuleRef::~ModuleRef()
+	{
+		if (handle) FreeLibrary((HMODULE)handle);
+	}
+#else
+	ModuleRef::ModuleRef(uintptr_t base)
+	{
+		Dl_info info;
+		if (!dladdr((const void*)base, &info) || (uintptr_t)info.dli_fbase != base) return;
+		handle = dlopen(info.dli_fname, RTLD_NOW | RTLD_NOLOAD);
+		if (handle) return;
+
+		// The executable cannot be opened by name, but is never unloaded
+		Dl_info main_info;
+		if (dladdr((const void*)getauxval(AT_PHDR), &main_info) && main_info.dli_fbase == info.dli_fbase)
+			handle = dlopen(nullptr, RTLD_NOW);
+	}
+
+	ModuleRef::~ModuleRef()
+	{
+		if (handle) dlclose(handle);
+	}
+#endif
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+
+namespace MCF
+{
+	/// <summary>
+	/// Reference to a loaded module which keeps the loader from unmapping it, so that a worker thread can read its
+	/// memory. Module unload events may be raised after the module is unmapped, so they cannot be used to wait for
+	/// such readers.
+	/// </summary>
+	class ModuleRef
+	{
+	private:
+		void* handle = nullptr;
+
+	public:
+		/// <summary>
+		/// Reference the module whose image starts at base. Fails if no module is loaded there.
+		/// </summary>
+		explicit ModuleRef(uintptr_t base);
+		~ModuleRef();
+
+		ModuleRef(const ModuleRef&) = delete;
+		ModuleRef& operator=(const ModuleRef&) = delete;
+
+		explicit operator bool() const { return handle != nullptr; }
+	};
+}
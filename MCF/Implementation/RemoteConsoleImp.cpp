@@ -0,0 +1,303 @@
+#include "RemoteConsoleImp.h"
+#include <format>
+#include <algorithm>
+
+namespace MCF
+{
+	RemoteConsoleImp::RemoteConsoleImp()
+	{
+		Listen(nullptr);
+	}
+
+	RemoteConsoleImp::~RemoteConsoleImp()
+	{
+		Stop();
+	}
+
+	bool RemoteConsoleImp::Listen(const char* address)
+	{
+		if (accept_thread.joinable()) return false;
+
+		std::string addr = address ? address : LocalServer::DefaultAddress();
+		if (!server.Listen(addr.c_str()))
+		{
+			C<Logger>()->Error(this, "Could not listen at \"{}\"", addr);
+			return false;
+		}
+
+		accept_thread = std::thread(&RemoteConsoleImp::AcceptLoop, this);
+		C<Logger>()->Info(this, "Listening at \"{}\"", addr);
+		return true;
+	}
+
+	void RemoteConsoleImp::Stop()
+	{
+		if (!accept_thread.joinable()) return;
+
+		server.Close();
+		accept_thread.join();
+
+		{
+			std::shared_lock<decltype(clients_mutex)> lock(clients_mutex);
+			for (const auto& client : clients)
+			{
+				std::vector<HCallResult> running;
+				{
+					std::lock_guard<decltype(client->mutex)> client_lock(client->mutex);
+					running = client->running;
+				}
+				for (HCallResult handle : running) C<CommandMan>()->CancelCommand(handle);
+				client->stream->Shutdown();
+			}
+		}
+		Reap(true);
+	}
+
+	void RemoteConsoleImp::SetClientBufferSize(size_t bytes)
+	{
+		buffer_size = bytes;
+	}
+
+	size_t RemoteConsoleImp::ClientCount()
+	{
+		return client_count;
+	}
+
+	size_t RemoteConsoleImp::GetClientStats(ClientStats* out, size_t max)
+	{
+		std::shared_lock<decltype(clients_mutex)> lock(clients_mutex);
+		size_t n = 0;
+		for (const auto& client : clients)
+		{
+			if (n == max) break;
+
+			std::lock_guard<decltype(client->mutex)> client_lock(client->mutex);
+			if (client->closed) continue;
+			out[n++] = ClientStats{ 
+				.id = client->id, 
+				.bytes_sent = client->bytes_sent, 
+				.dropped_lines = client->dropped, 
+				.pending_bytes = client->pending.size() 
+			};
+		}
+		return n;
+	}
+
+	void RemoteConsoleImp::AcceptLoop()
+	{
+		while (auto stream = server.Accept())
+		{
+			Reap(false);
+
+			auto client = std::make_shared<Client>();
+			client->stream = std::move(stream);
+			client->cr.SetCallback([this, c = client.get()](CommandMan::CommandResult* res) {
+				static constexpr const char* status_names[] = { "done", "failed", "cancelled", "timed out" };
+				Send(*c, std::format("[{}] {} us\n", status_names[(uint32_t)res->status], res->elapsed_us));
+
+				std::lock_guard<decltype(c->mutex)> lock(c->mutex);
+				std::erase(c->running, res->handle);
+			});
+
+			{
+				std::unique_lock<decltype(clients_mutex)> lock(clients_mutex);
+				client->id = next_id++;
+				clients.push_back(client);
+				client_count++;
+			}
+			UpdateLogRegistration();
+
+			client->writer = std::thread(&RemoteConsoleImp::WriteLoop, this, client.get());
+			client->reader = std::thread(&RemoteConsoleImp::ReadLoop, this, client);
+		}
+	}
+
+	void RemoteConsoleImp::Reap(bool all)
+	{
+		std::vector<std::shared_ptr<Client>> reaped;
+		{
+			std::unique_lock<decltype(clients_mutex)> lock(clients_mutex);
+			for (auto it = clients.begin(); it != clients.end();)
+			{
+				bool closed;
+				{
+					std::lock_guard<decltype((*it)->mutex)> client_lock((*it)->mutex);
+					closed = (*it)->closed;
+				}
+				if (all || closed)
+				{
+					reaped.push_back(std::move(*it));
+					it = clients.erase(it);
+				}
+				else it++;
+			}
+		}
+
+		// Threads are joined outside of the lock, as they may be logging
+		for (auto& client : reaped)
+		{
+			client->reader.join();
+			client->writer.join();
+		}
+	}
+
+	void RemoteConsoleImp::ReadLoop(std::shared_ptr<Client> client)
+	{
+		char buf[4096];
+		std::string line;
+		bool too_long = false;
+		while (size_t n = client->stream->Read(buf, sizeof(buf)))
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				if (buf[i] != '\n')
+				{
+					if (line.size() < MaxLineLength) line.push_back(buf[i]);
+					else too_long = true;
+					continue;
+				}
+				if (too_long) Send(*client, std::format("Line longer than {} bytes ignored\n", MaxLineLength));
+				else
+				{
+					if (!line.empty() && line.back() == '\r') line.pop_back();
+					if (!line.empty()) RunLine(client, line);
+				}
+				line.clear();
+				too_long = false;
+			}
+		}
+
+		{
+			std::lock_guard<decltype(client->mutex)> lock(client->mutex);
+			client->closed = true;
+		}
+		client->cv.notify_one();
+		client_count--;
+		UpdateLogRegistration();
+	}
+
+	void RemoteConsoleImp::RunLine(const std::shared_ptr<Client>& client, const std::string& line)
+	{
+		// The command is queued on the client's pump, which is pumped on the worker pool while the reader keeps
+		// reading. Its handle is recorded before it can run, so that all of its output reaches the client.
+		HCallResult handle = C<CommandMan>()->RunCommandAsync(line.c_str(), &client->cr, ClientPumpBase | client->id, 0);
+
+		bool submit;
+		{
+			std::lock_guard<decltype(client->mutex)> lock(client->mutex);
+			client->running.push_back(handle);
+			client->queued++;
+			submit = !client->pumping;
+			client->pumping = true;
+		}
+		if (submit) pool.Submit([this, client] { PumpClient(client); });
+	}
+
+	void RemoteConsoleImp::PumpClient(const std::shared_ptr<Client>& client)
+	{
+		while (true)
+		{
+			{
+				std::lock_guard<decltype(client->mutex)> lock(client->mutex);
+				if (client->queued == 0)
+				{
+					client->pumping = false;
+					return;
+				}
+				client->queued = 0;
+			}
+			C<CommandMan>()->PumpCommands(ClientPumpBase | client->id);
+		}
+	}
+
+	void RemoteConsoleImp::OnOutput(CommandMan::CommandOutputEvent* evt)
+	{
+		if (client_count.load(std::memory_order_relaxed) == 0) return;
+
+		std::shared_lock<decltype(clients_mutex)> lock(clients_mutex);
+		for (const auto& client : clients)
+		{
+			bool owned;
+			{
+				std::lock_guard<decltype(client->mutex)> client_lock(client->mutex);
+				owned = std::find(client->running.begin(), client->running.end(), evt->handle) != client->running.end();
+			}
+			if (!owned) continue;
+
+			Send(*client, evt->text);
+			Send(*client, "\n");
+			return;
+		}
+	}
+
+	void RemoteConsoleImp::WriteLoop(Client* client)
+	{
+		std::unique_lock<decltype(client->mutex)> lock(client->mutex);
+		while (true)
+		{
+			client->cv.wait(lock, [client] { return client->closed || !client->pending.empty(); });
+			if (client->closed) return;
+
+			client->writing.swap(client->pending);
+			lock.unlock();
+			bool ok = client->stream->Write(client->writing.data(), client->writing.size());
+			lock.lock();
+
+			client->bytes_sent += client->writing.size();
+			client->writing.clear();
+			if (!ok)
+			{
+				// Let the reader notice the disconnection
+				client->stream->Shutdown();
+				return;
+			}
+		}
+	}
+
+	void RemoteConsoleImp::Send(Client& client, std::string_view text)
+	{
+		bool wake;
+		{
+			std::lock_guard<decltype(client.mutex)> lock(client.mutex);
+			if (client.closed) return;
+			if (client.pending.size() + text.size() > buffer_size.load(std::memory_order_relaxed))
+			{
+				client.dropped++;
+				return;
+			}
+			wake = client.pending.empty();
+			client.pending.append(text);
+		}
+		if (wake) client.cv.notify_one();
+	}
+
+	void RemoteConsoleImp::OnLog(Logger::LogEvent* evt)
+	{
+		if (client_count.load(std::memory_order_relaxed) == 0) return;
+
+		// Log style: [SEV] [SOURCE] MESSAGE
+		thread_local std::string line;
+		line.clear();
+		line.push_back('[');
+		line.append(evt->sev);
+		line.append("] [");
+		line.append(evt->source);
+		line.append("] ");
+		line.append(evt->msg);
+		line.push_back('\n');
+
+		std::shared_lock<decltype(clients_mutex)> lock(clients_mutex);
+		for (const auto& client : clients) Send(*client, line);
+	}
+
+	void RemoteConsoleImp::UpdateLogRegistration()
+	{
+		std::lock_guard<decltype(log_reg_mutex)> lock(log_reg_mutex);
+		bool want = client_count > 0;
+		if (want == log_registered) return;
+
+		if (want) log_cb.Register([this](Logger::LogEvent* evt) { OnLog(evt); });
+		else log_cb.Unregister();
+		log_registered = want;
+	}
+}
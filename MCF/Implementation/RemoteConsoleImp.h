@@ -0,0 +1,109 @@
+#pragma once
+#include "Include/RemoteConsole.h"
+#include "Include/CommandMan.h"
+#include "Include/Logger.h"
+#include "Include/Export.h"
+#include "LocalSocket.h"
+#include "ThreadPool.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace MCF
+{
+	class RemoteConsoleImp final : public SharedInterfaceImp<RemoteConsole, RemoteConsoleImp, DepList<EventMan, Logger, CommandMan>>
+	{
+	private:
+		/// <summary>
+		/// A connected client. The reader thread queues the commands it sends under the client's pump ID, and a
+		/// single task of the worker pool pumps them at a time, so that they run one after the other in order.
+		/// Their output is routed to the client by the handles in running. The writer thread sends its pending
+		/// output in batches.
+		/// </summary>
+		struct Client
+		{
+			uint32_t id;
+			std::unique_ptr<LocalStream> stream;
+			std::vector<HCallResult> running; // Guarded by mutex
+			size_t queued = 0; // Commands queued since the pump task last checked, guarded by mutex
+			bool pumping = false; // A pump task is submitted or running, guarded by mutex
+			CallResult<CommandMan::CommandResult> cr;
+
+			std::string pending;
+			std::string writing;
+			uint64_t bytes_sent = 0;
+			uint64_t dropped = 0;
+			bool closed = false;
+			std::mutex mutex;
+			std::condition_variable cv;
+
+			std::thread reader;
+			std::thread writer;
+		};
+
+		// Pump IDs of clients are their ID with the high bit set
+		static constexpr uint32_t ClientPumpBase = 0x80000000;
+
+		// Longest command line read from a client. Longer lines are discarded.
+		static constexpr size_t MaxLineLength = 1 << 16;
+
+		LocalServer server;
+		std::thread accept_thread;
+
+		std::vector<std::shared_ptr<Client>> clients;
+		std::shared_mutex clients_mutex;
+		std::atomic<size_t> client_count = 0;
+		std::atomic<size_t> buffer_size = 1 << 20;
+		uint32_t next_id = 1;
+
+		// The log callback is only registered while clients are connected, to keep logging free otherwise
+		EventCallback<Logger::LogEvent> log_cb;
+		bool log_registered = false;
+		std::mutex log_reg_mutex;
+
+		EventCallback<CommandMan::CommandOutputEvent> output_cb = [this](CommandMan::CommandOutputEvent* evt) {
+			OnOutput(evt);
+		};
+
+		void AcceptLoop();
+		void ReadLoop(std::shared_ptr<Client> client);
+		void WriteLoop(Client* client);
+		void RunLine(const std::shared_ptr<Client>& client, const std::string& line);
+		// Pump the commands of a client until none are queued
+		void PumpClient(const std::shared_ptr<Client>& client);
+		// Send the output of a command to the client which started it, whichever thread it was printed from
+		void OnOutput(CommandMan::CommandOutputEvent* evt);
+		void Send(Client& client, std::string_view text);
+		void OnLog(Logger::LogEvent* evt);
+		void UpdateLogRegistration();
+		void Reap(bool all);
+
+		// Runs the commands of clients. Declared last so that it is destroyed first, while the rest is alive.
+		ThreadPool pool{ 2 };
+
+	public:
+		RemoteConsoleImp();
+		~RemoteConsoleImp();
+
+		virtual bool IsUnloadable() const override { return true; }
+
+		virtual bool Listen(const char* address) override;
+
+		virtual void Stop() override;
+
+		virtual void SetClientBufferSize(size_t bytes) override;
+
+		virtual size_t ClientCount() override;
+
+		virtual size_t GetClientStats(ClientStats* out, size_t max) override;
+	};
+
+	MCF_COMPONENT_EXPORT(RemoteConsoleImp);
+}
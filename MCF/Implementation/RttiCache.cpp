@@ -0,0 +1,100 @@
+#include "RttiCache.h"
+#include <fstream>
+#include <filesystem>
+
+namespace MCF
+{
+	bool RttiCache::Load(const char* path)
+	{
+		modules.clear();
+		dirty = false;
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+
+		uint32_t header[3];
+		if (!file.read((char*)header, sizeof(header)) || header[0] != Magic || header[1] != Version) return false;
+
+		for (uint32_t i = 0; i < header[2]; i++)
+		{
+			uint64_t identity;
+			uint32_t count;
+			if (!file.read((char*)&identity, sizeof(identity)) || !file.read((char*)&count, sizeof(count)))
+			{
+				modules.clear();
+				return false;
+			}
+
+			std::vector<Entry>& entries = modules[identity];
+			entries.resize(count);
+			for (auto& entry : entries)
+			{
+				uint32_t fields[4]; // rva, num_methods, offset, name length
+				if (!file.read((char*)fields, sizeof(fields)))
+				{
+					modules.clear();
+					return false;
+				}
+				entry.rva = fields[0];
+				entry.num_methods = fields[1];
+				entry.offset = (int32_t)fields[2];
+				entry.mangled.resize(fields[3]);
+				if (!file.read(entry.mangled.data(), fields[3]))
+				{
+					modules.clear();
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool RttiCache::Save(const char* path)
+	{
+		if (!dirty) return true;
+
+		std::string tmp_path = std::string(path) + ".tmp";
+		{
+			std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+			uint32_t header[3] = { Magic, Version, (uint32_t)modules.size() };
+			file.write((const char*)header, sizeof(header));
+			for (const auto& [identity, entries] : modules)
+			{
+				uint32_t count = (uint32_t)entries.size();
+				file.write((const char*)&identity, sizeof(identity));
+				file.write((const char*)&count, sizeof(count));
+				for (const auto& entry : entries)
+				{
+					uint32_t fields[4] = { entry.rva, entry.num_methods, (uint32_t)entry.offset, (uint32_t)entry.mangled.size() };
+					file.write((const char*)fields, sizeof(fields));
+					file.write(entry.mangled.data(), entry.mangled.size());
+				}
+			}
+			if (!file.flush()) return false;
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tmp_path, path, ec);
+		if (ec) return false;
+
+		dirty = false;
+		return true;
+	}
+
+	const std::vector<RttiCache::Entry>* RttiCache::Lookup(uint64_t identity) const
+	{
+		auto it = modules.find(identity);
+		return it == modules.end() ? nullptr : &it->second;
+	}
+
+	void RttiCache::Store(uint64_t identity, std::vector<Entry> entries)
+	{
+		modules[identity] = std::move(entries);
+		dirty = true;
+	}
+
+	void RttiCache::Erase(uint64_t identity)
+	{
+		if (modules.erase(identity)) dirty = true;
+	}
+}
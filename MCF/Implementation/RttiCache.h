@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace MCF
+{
+	/// <summary>
+	/// On-disk map from module identities to the vtables found in them, see RttiIndex. Vtables are stored by RVA
+	/// along with the decorated name of their class, so that entries can be checked against the RTTI when loaded.
+	/// </summary>
+	class RttiCache
+	{
+	public:
+		struct Entry
+		{
+			std::string mangled;
+			uint32_t rva;
+			uint32_t num_methods;
+			int32_t offset;
+		};
+
+	private:
+		static constexpr uint32_t Magic = 0x5646434D; // "MCFV"
+		static constexpr uint32_t Version = 1;
+
+		std::unordered_map<uint64_t, std::vector<Entry>> modules;
+		bool dirty = false;
+
+	public:
+		/// <summary>
+		/// Replace the contents of the cache by those of a file.
+		/// </summary>
+		/// <returns>False if the file does not exist or is not a valid cache, in which case the cache is cleared.</returns>
+		bool Load(const char* path);
+
+		/// <summary>
+		/// Write the cache to a file if it was modified since it was loaded or last saved, replacing it atomically.
+		/// </summary>
+		bool Save(const char* path);
+
+		const std::vector<Entry>* Lookup(uint64_t identity) const;
+		void Store(uint64_t identity, std::vector<Entry> entries);
+		void Erase(uint64_t identity);
+	};
+}
@@ -0,0 +1,213 @@
+#include "RttiIndexImp.h"
+#include "RttiParser.h"
+#include "AobCache.h"
+#include "ModuleRef.h"
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#include <limits.h>
+#endif
+
+namespace MCF
+{
+	std::string RttiIndexImp::DefaultCachePath()
+	{
+#ifdef _WIN32
+		char exe_path[MAX_PATH], temp_path[MAX_PATH];
+		DWORD len = GetModuleFileNameA(NULL, exe_path, sizeof(exe_path));
+		if (len == 0 || len == sizeof(exe_path)) strcpy_s(exe_path, sizeof(exe_path), "unknown");
+		if (GetTempPathA(sizeof(temp_path), temp_path) == 0) temp_path[0] = 0;
+
+		const char* exe_name = strrchr(exe_path, '\\');
+		return std::string(temp_path) + "MCF_RttiCache_" + (exe_name ? exe_name + 1 : exe_path) + ".bin";
+#else
+		char exe_path[PATH_MAX];
+		ssize_t len = readlink("/proc/self/exe", exe_path, sizeof(exe_path) - 1);
+		exe_path[len > 0 ? len : 0] = 0;
+
+		const char* exe_name = strrchr(exe_path, '/');
+		std::error_code ec;
+		std::filesystem::path temp_path = std::filesystem::temp_directory_path(ec);
+		return (temp_path / ("MCF_RttiCache_" + std::string(exe_name ? exe_name + 1 : "unknown") + ".bin")).string();
+#endif
+	}
+
+	uint64_t RttiIndexImp::ModuleIdentity(const ModuleIndex::ModuleInfo& mod_info)
+	{
+		uint64_t identity = AobCache::Hash(mod_info.name, strlen(mod_info.name));
+		identity = AobCache::Hash(&mod_info.timestamp, sizeof(mod_info.timestamp), identity);
+		identity = AobCache::Hash(&mod_info.size, sizeof(mod_info.size), identity);
+		return AobCache::Hash(&mod_info.num_sections, sizeof(mod_info.num_sections), identity);
+	}
+
+	std::vector<ModuleIndex::SectionInfo> RttiIndexImp::GetSections(const ModuleIndex::ModuleInfo& mod_info)
+	{
+		std::vector<ModuleIndex::SectionInfo> sections(mod_info.num_sections);
+		sections.resize((std::min)(sections.size(), C<ModuleIndex>()->GetSections(mod_info.base, sections.data(), sections.size())));
+		return sections;
+	}
+
+	void RttiIndexImp::SetCachePath(const char* path)
+	{
+		std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+		cache_enabled = path != nullptr;
+		cache_path = path ? path : "";
+		cache_loaded = false;
+	}
+
+	std::shared_ptr<RttiIndexImp::ModuleRtti> RttiIndexImp::GetModule(const char* module_name)
+	{
+		// Read before looking up the module, so that an unload after the lookup is noticed before inserting
+		uint64_t generation = C<ModuleIndex>()->Generation();
+		ModuleIndex::ModuleInfo mod_info;
+		if (!C<ModuleIndex>()->FindModuleByName(module_name, &mod_info)) return nullptr;
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			auto it = modules.find(mod_info.base);
+			if (it != modules.end()) return it->second;
+		}
+
+		// Another thread may have indexed the module while we waited
+		std::lock_guard<decltype(index_mutex)> index_lock(index_mutex);
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			auto it = modules.find(mod_info.base);
+			if (it != modules.end()) return it->second;
+		}
+
+		// Unload events may come after the module is unmapped, so it is kept loaded while it is indexed
+		ModuleRef ref(mod_info.base);
+		if (!ref) return nullptr;
+
+		auto rtti = BuildModule(mod_info);
+
+		// The unload event erases the module under the lock, so it either comes after the insertion or changed
+		// the generation before it
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		ModuleIndex::ModuleInfo current;
+		if (C<ModuleIndex>()->Generation() != generation && (!C<ModuleIndex>()->FindModule(mod_info.base, &current)
+			|| current.base != mod_info.base || current.timestamp != mod_info.timestamp)) return nullptr;
+		modules[mod_info.base] = rtti;
+		return rtti;
+	}
+
+	std::shared_ptr<RttiIndexImp::ModuleRtti> RttiIndexImp::BuildModule(const ModuleIndex::ModuleInfo& mod_info)
+	{
+		if (!cache_loaded && cache_enabled)
+		{
+			if (cache_path.empty()) cache_path = DefaultCachePath();
+			cache.Load(cache_path.c_str());
+			cache_loaded = true;
+		}
+
+		auto sections = GetSections(mod_info);
+		uint64_t identity = ModuleIdentity(mod_info);
+
+		// Cached vtables are only used if they all still point to the RTTI of their class
+		std::vector<RttiCache::Entry> entries;
+		const std::vector<RttiCache::Entry>* cached = cache_enabled ? cache.Lookup(identity) : nullptr;
+		bool valid = cached != nullptr;
+		for (size_t i = 0; valid && i < cached->size(); i++)
+		{
+			std::string mangled;
+			const RttiCache::Entry& entry = (*cached)[i];
+			valid = RttiParser::MangledName(mod_info.base + entry.rva, sections, mangled) && mangled == entry.mangled;
+		}
+
+		if (valid)
+		{
+			entries = *cached;
+			C<Logger>()->Debug(this, "{} vtables of {} loaded from the cache", entries.size(), mod_info.name);
+		}
+		else
+		{
+			auto vtables = RttiParser::Parse(sections, *pool, [this](uintptr_t address) {
+				ModuleIndex::SectionInfo section;
+				return C<ModuleIndex>()->FindSection(address, &section) && (section.flags & ModuleIndex::SectionExecute);
+			});
+			for (auto& vtable : vtables)
+			{
+				entries.push_back(RttiCache::Entry{
+					.mangled = std::move(vtable.mangled),
+					.rva = (uint32_t)(vtable.address - mod_info.base),
+					.num_methods = vtable.num_methods,
+					.offset = vtable.offset
+				});
+			}
+			C<Logger>()->Debug(this, "{} vtables found in {}", entries.size(), mod_info.name);
+
+			if (cache_enabled)
+			{
+				cache.Store(identity, entries);
+				if (!cache.Save(cache_path.c_str()))
+					C<Logger>()->Warn(this, "Could not write the RTTI cache to \"{}\"", cache_path);
+			}
+		}
+
+		auto rtti = std::make_shared<ModuleRtti>();
+		rtti->count = entries.size();
+		for (const auto& entry : entries)
+		{
+			VTableInfo info{
+				.address = mod_info.base + entry.rva,
+				.module_base = mod_info.base,
+				.num_methods = entry.num_methods,
+				.offset = entry.offset
+			};
+			std::string demangled = RttiParser::Demangle(entry.mangled);
+			if (demangled != entry.mangled) rtti->by_name[demangled].push_back(info);
+			rtti->by_name[entry.mangled].push_back(info);
+		}
+		for (auto& [name, vtables] : rtti->by_name)
+		{
+			std::stable_sort(vtables.begin(), vtables.end(), [](const VTableInfo& a, const VTableInfo& b) {
+				return a.offset < b.offset;
+			});
+		}
+		return rtti;
+	}
+
+	size_t RttiIndexImp::FindVTables(const char* class_name, VTableInfo* out, size_t max, const char* module_name)
+	{
+		auto rtti = GetModule(module_name);
+		if (!rtti) return 0;
+
+		auto it = rtti->by_name.find(class_name);
+		if (it == rtti->by_name.end()) return 0;
+
+		std::copy_n(it->second.begin(), (std::min)(max, it->second.size()), out);
+		return it->second.size();
+	}
+
+	bool RttiIndexImp::ClassNameOf(uintptr_t vtable, char* out, size_t size)
+	{
+		uint64_t generation = C<ModuleIndex>()->Generation();
+		ModuleIndex::ModuleInfo mod_info;
+		if (!C<ModuleIndex>()->FindModule(vtable, &mod_info)) return false;
+
+		// Keep the module loaded while its RTTI is read, and check that it is still the one that was looked up
+		ModuleRef ref(mod_info.base);
+		ModuleIndex::ModuleInfo current;
+		if (!ref || (C<ModuleIndex>()->Generation() != generation && (!C<ModuleIndex>()->FindModule(mod_info.base, &current)
+			|| current.base != mod_info.base || current.timestamp != mod_info.timestamp))) return false;
+
+		std::string mangled;
+		if (!RttiParser::MangledName(vtable, GetSections(mod_info), mangled)) return false;
+
+		std::string name = RttiParser::Demangle(mangled);
+		if (name.size() >= size) return false;
+		memcpy(out, name.c_str(), name.size() + 1);
+		return true;
+	}
+
+	size_t RttiIndexImp::IndexModule(const char* module_name)
+	{
+		auto rtti = GetModule(module_name);
+		return rtti ? rtti->count : 0;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Include/RttiIndex.h"
+#include "Include/ModuleIndex.h"
+#include "Include/Logger.h"
+#include "Include/Export.h"
+#include "ThreadPool.h"
+#include "RttiCache.h"
+
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace MCF
+{
+	class RttiIndexImp final : public SharedInterfaceImp<RttiIndex, RttiIndexImp, DepList<EventMan, Logger, ModuleIndex>>
+	{
+	private:
+		/// <summary>
+		/// Vtables of an indexed module, by demangled and decorated class name, each sorted by offset.
+		/// </summary>
+		struct ModuleRtti
+		{
+			std::unordered_map<std::string, std::vector<VTableInfo>> by_name;
+			size_t count = 0;
+		};
+
+		std::unordered_map<uintptr_t, std::shared_ptr<ModuleRtti>> modules; // By base address
+		std::mutex mutex;
+		std::mutex index_mutex; // Held while indexing a module, and guards the cache
+		std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>();
+
+		RttiCache cache;
+		std::string cache_path;
+		bool cache_enabled = true;
+		bool cache_loaded = false;
+
+		// Cache file in the temp directory, named after the executable
+		static std::string DefaultCachePath();
+
+		// Identifies a module across launches, as long as the binary is not modified
+		static uint64_t ModuleIdentity(const ModuleIndex::ModuleInfo& mod_info);
+
+		std::vector<ModuleIndex::SectionInfo> GetSections(const ModuleIndex::ModuleInfo& mod_info);
+
+		// Get the index of a module, building it if needed. Returns null if the module is not loaded
+		std::shared_ptr<ModuleRtti> GetModule(const char* module_name);
+
+		std::shared_ptr<ModuleRtti> BuildModule(const ModuleIndex::ModuleInfo& mod_info);
+
+		EventCallback<ModuleIndex::ModuleUnloadedEvent> module_unloaded_cb = [this](ModuleIndex::ModuleUnloadedEvent* evt) {
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			modules.erase(evt->module.base);
+		};
+
+	public:
+		virtual bool IsUnloadable() const override { return true; }
+
+		virtual size_t FindVTables(const char* class_name, VTableInfo* out, size_t max, const char* module_name) override;
+
+		virtual bool ClassNameOf(uintptr_t vtable, char* out, size_t size) override;
+
+		virtual size_t IndexModule(const char* module_name) override;
+
+		virtual void SetCachePath(const char* path) override;
+	};
+
+	MCF_COMPONENT_EXPORT(RttiIndexImp);
+}
@@ -0,0 +1,292 @@
+#include "RttiParser.h"
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <stdlib.h>
+#endif
+
+namespace MCF
+{
+	namespace RttiParser
+	{
+		namespace
+		{
+			using SectionList = std::vector<ModuleTypes::SectionInfo>;
+
+			constexpr size_t ChunkSize = 1 << 20;
+			constexpr size_t MaxNameLength = 1024;
+			constexpr uint32_t MaxMethods = 4096;
+			constexpr size_t PtrSize = sizeof(uintptr_t);
+
+			/// <summary>
+			/// RTTI object identifying a class, referenced by the word preceding each of its vtables: a complete
+			/// object locator on Windows, and a typeinfo object elsewhere.
+			/// </summary>
+			struct TypeRecord
+			{
+				uintptr_t address;
+				std::string mangled;
+				int32_t offset; // Offset of the subobject, if stored in the record
+			};
+
+			struct Chunk
+			{
+				uintptr_t begin;
+				uintptr_t end;
+				uintptr_t section_end;
+			};
+
+			// Find the readable section containing [address, address + size)
+			const ModuleTypes::SectionInfo* FindReadable(const SectionList& sections, uintptr_t address, size_t size)
+			{
+				auto it = std::upper_bound(sections.begin(), sections.end(), address, [](uintptr_t a, const ModuleTypes::SectionInfo& s) {
+					return a < s.begin;
+				});
+				if (it == sections.begin()) return nullptr;
+				--it;
+
+				if (!(it->flags & ModuleTypes::SectionRead) || address + size < address || address + size > it->begin + it->size)
+					return nullptr;
+				return &*it;
+			}
+
+			template<typename T>
+			bool ReadValue(const SectionList& sections, uintptr_t address, T& out)
+			{
+				if (!FindReadable(sections, address, sizeof(T))) return false;
+				memcpy(&out, (const void*)address, sizeof(T));
+				return true;
+			}
+
+			bool ReadName(const SectionList& sections, uintptr_t address, std::string& out)
+			{
+				auto section = FindReadable(sections, address, 1);
+				if (section == nullptr) return false;
+
+				size_t max = (std::min)(MaxNameLength, (size_t)(section->begin + section->size - address));
+				size_t len = strnlen((const char*)address, max);
+				if (len == 0 || len == max) return false;
+				out.assign((const char*)address, len);
+				return true;
+			}
+
+			// Pieces of the readable, non-executable sections, which contain the RTTI and vtables
+			std::vector<Chunk> DataChunks(const SectionList& sections)
+			{
+				std::vector<Chunk> chunks;
+				for (const auto& section : sections)
+				{
+					if (!(section.flags & ModuleTypes::SectionRead) || (section.flags & ModuleTypes::SectionExecute)) continue;
+
+					uintptr_t end = section.begin + section.size;
+					for (uintptr_t p = section.begin; p < end; p += ChunkSize)
+						chunks.push_back(Chunk{ .begin = p, .end = (std::min)(p + ChunkSize, end), .section_end = end });
+				}
+				return chunks;
+			}
+
+#ifdef _WIN32
+			struct TypeContext { };
+
+			bool InitContext(TypeContext&) { return true; }
+
+			// Read the class name from a complete object locator, checking that it is one
+			bool ReadLocator(const SectionList& sections, uintptr_t col, std::string& name, int32_t& offset)
+			{
+				uint32_t fields[6];
+				if (!ReadValue(sections, col, fields)) return false;
+#ifdef _WIN64
+				// signature, offset, cd_offset, type descriptor RVA, class descriptor RVA, self RVA
+				uintptr_t base = sections.front().module_base;
+				if (fields[0] != 1 || fields[5] != col - base) return false;
+				uintptr_t type_desc = base + fields[3];
+#else
+				// signature, offset, cd_offset, type descriptor, class descriptor
+				if (fields[0] != 0 || !FindReadable(sections, fields[4], 4)) return false;
+				uintptr_t type_desc = fields[3];
+#endif
+				if (!ReadName(sections, type_desc + 2 * PtrSize, name)) return false;
+				if (name.compare(0, 4, ".?AV") != 0 && name.compare(0, 4, ".?AU") != 0) return false;
+				offset = (int32_t)fields[1];
+				return true;
+			}
+
+			void FindTypes(const TypeContext&, const SectionList& sections, const Chunk& chunk, std::vector<TypeRecord>& out)
+			{
+				for (uintptr_t p = chunk.begin; p < chunk.end && p + 24 <= chunk.section_end; p += 4)
+				{
+#ifdef _WIN64
+					if (*(const uint32_t*)p != 1) continue;
+#endif
+					TypeRecord record{ .address = p };
+					if (ReadLocator(sections, p, record.mangled, record.offset)) out.push_back(std::move(record));
+				}
+			}
+
+			// Offset of the subobject of a vtable, whose locator was referenced at ref
+			bool VTableOffset(const SectionList&, uintptr_t, const TypeRecord& record, int32_t& offset)
+			{
+				offset = record.offset;
+				return true;
+			}
+#else
+			struct TypeContext
+			{
+				uintptr_t type_info_vtables[3]; // Address points of the vtables of the typeinfo classes
+			};
+
+			bool InitContext(TypeContext& ctx)
+			{
+				const char* names[] = {
+					"_ZTVN10__cxxabiv117__class_type_infoE",
+					"_ZTVN10__cxxabiv120__si_class_type_infoE",
+					"_ZTVN10__cxxabiv121__vmi_class_type_infoE"
+				};
+				bool any = false;
+				for (int i = 0; i < 3; i++)
+				{
+					auto vtable = (uintptr_t)dlsym(RTLD_DEFAULT, names[i]);
+					ctx.type_info_vtables[i] = vtable ? vtable + 2 * PtrSize : 0;
+					any |= vtable != 0;
+				}
+				return any;
+			}
+
+			bool IsTypeInfoVTable(const TypeContext& ctx, uintptr_t value)
+			{
+				return value != 0 && (value == ctx.type_info_vtables[0] || value == ctx.type_info_vtables[1] || value == ctx.type_info_vtables[2]);
+			}
+
+			void FindTypes(const TypeContext& ctx, const SectionList& sections, const Chunk& chunk, std::vector<TypeRecord>& out)
+			{
+				uintptr_t begin = (chunk.begin + PtrSize - 1) & ~(PtrSize - 1);
+				for (uintptr_t p = begin; p < chunk.end && p + 2 * PtrSize <= chunk.section_end; p += PtrSize)
+				{
+					if (!IsTypeInfoVTable(ctx, *(const uintptr_t*)p)) continue;
+
+					TypeRecord record{ .address = p, .offset = 0 };
+					if (ReadName(sections, *(const uintptr_t*)(p + PtrSize), record.mangled)) out.push_back(std::move(record));
+				}
+			}
+
+			// The word preceding the typeinfo pointer of a vtable is the offset to the top of the complete object
+			bool VTableOffset(const SectionList& sections, uintptr_t ref, const TypeRecord&, int32_t& offset)
+			{
+				intptr_t offset_to_top;
+				if (!ReadValue(sections, ref - PtrSize, offset_to_top)) return false;
+				if (offset_to_top > 0 || offset_to_top < -(intptr_t)INT32_MAX || offset_to_top % (intptr_t)PtrSize != 0) return false;
+				offset = (int32_t)-offset_to_top;
+				return true;
+			}
+#endif
+		}
+
+		std::vector<VTable> Parse(const std::vector<ModuleTypes::SectionInfo>& sections, ThreadPool& pool,
+			const std::function<bool(uintptr_t)>& is_code)
+		{
+			TypeContext ctx;
+			if (sections.empty() || !InitContext(ctx)) return { };
+
+			std::vector<Chunk> chunks = DataChunks(sections);
+
+			// Find the RTTI objects, then the words referencing them
+			std::vector<std::vector<TypeRecord>> chunk_types(chunks.size());
+			pool.ParallelFor(chunks.size(), [&](size_t i) {
+				FindTypes(ctx, sections, chunks[i], chunk_types[i]);
+			});
+
+			std::vector<TypeRecord> types;
+			for (auto& v : chunk_types)
+				for (auto& record : v) types.push_back(std::move(record));
+			if (types.empty()) return { };
+
+			std::unordered_map<uintptr_t, const TypeRecord*> by_address;
+			uintptr_t min_address = UINTPTR_MAX, max_address = 0;
+			for (const auto& record : types)
+			{
+				by_address[record.address] = &record;
+				min_address = (std::min)(min_address, record.address);
+				max_address = (std::max)(max_address, record.address);
+			}
+
+			std::vector<std::vector<VTable>> chunk_vtables(chunks.size());
+			pool.ParallelFor(chunks.size(), [&](size_t i) {
+				const Chunk& chunk = chunks[i];
+				uintptr_t begin = (chunk.begin + PtrSize - 1) & ~(PtrSize - 1);
+				for (uintptr_t p = begin; p < chunk.end && p + 2 * PtrSize <= chunk.section_end; p += PtrSize)
+				{
+					uintptr_t value = *(const uintptr_t*)p;
+					if (value < min_address || value > max_address) continue;
+
+					auto it = by_address.find(value);
+					if (it == by_address.end()) continue;
+
+					VTable vtable{ .mangled = it->second->mangled, .address = p + PtrSize, .num_methods = 0 };
+					if (!VTableOffset(sections, p, *it->second, vtable.offset)) continue;
+
+					uintptr_t method;
+					while (vtable.num_methods < MaxMethods && ReadValue(sections, vtable.address + vtable.num_methods * PtrSize, method)
+						&& is_code(method)) vtable.num_methods++;
+
+					if (vtable.num_methods > 0) chunk_vtables[i].push_back(std::move(vtable));
+				}
+			});
+
+			std::vector<VTable> vtables;
+			for (auto& v : chunk_vtables)
+				for (auto& vtable : v) vtables.push_back(std::move(vtable));
+			return vtables;
+		}
+
+		bool MangledName(uintptr_t vtable, const std::vector<ModuleTypes::SectionInfo>& sections, std::string& out)
+		{
+			uintptr_t meta;
+			if (!ReadValue(sections, vtable - PtrSize, meta)) return false;
+#ifdef _WIN32
+			int32_t offset;
+			return ReadLocator(sections, meta, out, offset);
+#else
+			TypeContext ctx;
+			uintptr_t type_info_vtable, name;
+			return InitContext(ctx) && ReadValue(sections, meta, type_info_vtable) && IsTypeInfoVTable(ctx, type_info_vtable)
+				&& ReadValue(sections, meta + PtrSize, name) && ReadName(sections, name, out);
+#endif
+		}
+
+		std::string Demangle(const std::string& mangled)
+		{
+#ifdef _WIN32
+			// .?AV (class) or .?AU (struct), then the name and its enclosing scopes, innermost first, each followed by @
+			if (mangled.size() < 6 || mangled.compare(0, 3, ".?A") != 0 || mangled.compare(mangled.size() - 2, 2, "@@") != 0)
+				return mangled;
+
+			std::string result;
+			size_t end = mangled.size() - 1;
+			for (size_t p = 4; p < end; )
+			{
+				size_t at = mangled.find('@', p);
+				if (at == p || mangled[p] == '?' || (mangled[p] >= '0' && mangled[p] <= '9')) return mangled;
+
+				std::string scope = mangled.substr(p, at - p);
+				result = result.empty() ? scope : scope + "::" + result;
+				p = at + 1;
+			}
+			return result;
+#else
+			// Names of types with internal linkage are prefixed with *
+			int status;
+			const char* name = mangled.c_str() + (mangled[0] == '*');
+			char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+			if (status != 0 || demangled == nullptr) return mangled;
+
+			std::string result = demangled;
+			free(demangled);
+			return result;
+#endif
+		}
+	}
+}
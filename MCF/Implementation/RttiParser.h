@@ -0,0 +1,45 @@
+#pragma once
+#include "Include/ModuleTypes.h"
+#include "ThreadPool.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace MCF
+{
+	/// <summary>
+	/// Finds the vtables of a loaded module from its RTTI. On Windows, complete object locators are recognized by 
+	/// their self RVA (x64) or type descriptor (x86). Elsewhere, typeinfo objects are recognized by the vtable of 
+	/// their class, which is resolved from the C++ runtime. Vtables are then the pointers following a reference to 
+	/// one of these objects.
+	/// </summary>
+	namespace RttiParser
+	{
+		struct VTable
+		{
+			std::string mangled; // Decorated name of the class
+			uintptr_t address;
+			uint32_t num_methods;
+			int32_t offset;
+		};
+
+		/// <summary>
+		/// Find all vtables of a module whose sections are given, sorted by address. Readable data sections are 
+		/// scanned in chunks on the pool. is_code tells whether an address is executable, to count methods.
+		/// </summary>
+		std::vector<VTable> Parse(const std::vector<ModuleTypes::SectionInfo>& sections, ThreadPool& pool,
+			const std::function<bool(uintptr_t)>& is_code);
+
+		/// <summary>
+		/// Get the decorated name of the class of a vtable in a module whose sections are given.
+		/// </summary>
+		bool MangledName(uintptr_t vtable, const std::vector<ModuleTypes::SectionInfo>& sections, std::string& out);
+
+		/// <summary>
+		/// Demangle a decorated class name (ex. .?AVChrIns@CS@@ or N2CS6ChrInsE to CS::ChrIns). On Windows, names
+		/// with templates or back references are returned decorated.
+		/// </summary>
+		std::string Demangle(const std::string& mangled);
+	}
+}
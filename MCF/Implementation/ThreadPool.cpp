@@ -0,0 +1,81 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace MCF
+{
+	ThreadPool::ThreadPool(size_t num_threads) : num_threads(num_threads)
+	{
+		if (this->num_threads == 0) this->num_threads = std::thread::hardware_concurrency();
+		if (this->num_threads == 0) this->num_threads = 1;
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			stop = true;
+		}
+		cv.notify_all();
+		for (auto& thread : threads) thread.join();
+	}
+
+	void ThreadPool::Submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<decltype(mutex)> lock(mutex);
+			tasks.push_back(std::move(task));
+			if (threads.empty())
+			{
+				for (size_t i = 0; i < num_threads; i++)
+					threads.emplace_back(&ThreadPool::WorkerLoop, this);
+			}
+		}
+		cv.notify_one();
+	}
+
+	void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn)
+	{
+		if (count == 0) return;
+
+		struct State
+		{
+			std::atomic<size_t> next = 0;
+			size_t done = 0;
+			std::mutex mutex;
+			std::condition_variable cv;
+		};
+		auto state = std::make_shared<State>();
+
+		// Helpers starting after all indices were claimed return without touching fn
+		auto work = [state, count, &fn] {
+			for (size_t i; (i = state->next.fetch_add(1)) < count;)
+			{
+				fn(i);
+				std::lock_guard<decltype(state->mutex)> lock(state->mutex);
+				if (++state->done == count) state->cv.notify_all();
+			}
+		};
+		size_t helpers = (std::min)(count, num_threads) - 1;
+		for (size_t h = 0; h < helpers; h++) Submit(work);
+		work();
+
+		std::unique_lock<decltype(state->mutex)> lock(state->mutex);
+		state->cv.wait(lock, [&] { return state->done == count; });
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		std::unique_lock<decltype(mutex)> lock(mutex);
+		while (true)
+		{
+			cv.wait(lock, [this] { return stop || !tasks.empty(); });
+			if (tasks.empty()) return;
+
+			auto task = std::move(tasks.front());
+			tasks.pop_front();
+			lock.unlock();
+			task();
+			lock.lock();
+		}
+	}
+}
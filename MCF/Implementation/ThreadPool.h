@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+
+namespace MCF
+{
+	/// <summary>
+	/// Fixed-size pool of worker threads executing tasks in FIFO order. Threads are only started once the first
+	/// task is submitted, so an idle pool costs nothing. Pending tasks are completed before the pool is destroyed.
+	/// </summary>
+	class ThreadPool
+	{
+	private:
+		size_t num_threads;
+		std::vector<std::thread> threads;
+		std::deque<std::function<void()>> tasks;
+		bool stop = false;
+		std::mutex mutex;
+		std::condition_variable cv;
+
+		void WorkerLoop();
+
+	public:
+		/// <summary>
+		/// Construct a pool of num_threads workers, or one per hardware thread if zero.
+		/// </summary>
+		ThreadPool(size_t num_threads = 0);
+
+		ThreadPool(ThreadPool&) = delete;
+		~ThreadPool();
+
+		void Submit(std::function<void()> task);
+
+		/// <summary>
+		/// Call fn(i) for every i in [0, count), on the workers and the calling thread, and wait for all calls to 
+		/// return. Indices are claimed in increasing order. Since the calling thread takes part, this completes even 
+		/// if no worker is free (e.g. when called from a task of this pool).
+		/// </summary>
+		void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+		size_t Size() const { return num_threads; }
+	};
+}
@@ -0,0 +1,478 @@
+#include "ValueCompare.h"
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+#include <bit>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MCF_VALUE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define MCF_TARGET(isa)
+#else
+#define MCF_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace MCF
+{
+	namespace ValueCompare
+	{
+		namespace
+		{
+			template<typename T>
+			T Load(const uint8_t* p)
+			{
+				T v;
+				memcpy(&v, p, sizeof(T));
+				return v;
+			}
+
+			template<typename T>
+			T Operand(const ScanValue& v)
+			{
+				if constexpr (std::is_floating_point_v<T>) return (T)v.f;
+				else return (T)v.i;
+			}
+
+			template<typename T>
+			bool Test(ScanCompare compare, const uint8_t* value, const uint8_t* previous, T a, T b)
+			{
+				T x = Load<T>(value);
+				switch (compare)
+				{
+				case ScanCompare::Exact: return x == a;
+				case ScanCompare::Range: return x >= a && x <= b;
+				case ScanCompare::Unknown: return true;
+				// Bits are compared, so that a NaN which stays the same is unchanged
+				case ScanCompare::Changed: return memcmp(value, previous, sizeof(T)) != 0;
+				case ScanCompare::Unchanged: return memcmp(value, previous, sizeof(T)) == 0;
+				case ScanCompare::Increased: return x > Load<T>(previous);
+				case ScanCompare::Decreased: return x < Load<T>(previous);
+				default: return false;
+				}
+			}
+
+			// Compare the values from index begin, a multiple of 64, to count. Values are stride bytes apart, and
+			// previous values are contiguous
+			template<typename T, typename Pred>
+			size_t ScalarLoop(const uint8_t* values, const uint8_t* previous, size_t begin, size_t count, size_t stride,
+				uint64_t* out, Pred pred)
+			{
+				size_t matches = 0;
+				for (size_t i = begin; i < count; i += 64)
+				{
+					uint64_t word = 0;
+					size_t n = (std::min)((size_t)64, count - i);
+					for (size_t j = 0; j < n; j++)
+					{
+						const uint8_t* prev = previous ? previous + (i + j) * sizeof(T) : nullptr;
+						if (pred(values + (i + j) * stride, prev)) word |= 1ull << j;
+					}
+					out[i / 64] = word;
+					matches += std::popcount(word);
+				}
+				return matches;
+			}
+
+			template<typename T>
+			size_t CompareScalar(ScanCompare compare, const uint8_t* values, const uint8_t* previous, size_t begin, size_t count,
+				size_t stride, T a, T b, uint64_t* out)
+			{
+				using P = const uint8_t*;
+				switch (compare)
+				{
+				case ScanCompare::Exact:
+					return ScalarLoop<T>(values, previous, begin, count, stride, out, [=](P v, P) { return Load<T>(v) == a; });
+				case ScanCompare::Range:
+					return ScalarLoop<T>(values, previous, begin, count, stride, out, [=](P v, P) { T x = Load<T>(v); return x >= a && x <= b; });
+				case ScanCompare::Changed:
+					return ScalarLoop<T>(values, previous, begin, count, stride, out, [](P v, P p) { return memcmp(v, p, sizeof(T)) != 0; });
+				case ScanCompare::Unchanged:
+					return ScalarLoop<T>(values, previous, begin, count, stride, out, [](P v, P p) { return memcmp(v, p, sizeof(T)) == 0; });
+				case ScanCompare::Increased:
+					return ScalarLoop<T>(values, previous, begin, count, stride, out, [](P v, P p) { return Load<T>(v) > Load<T>(p); });
+				case ScanCompare::Decreased:
+					return ScalarLoop<T>(values, previous, begin, count, stride, out, [](P v, P p) { return Load<T>(v) < Load<T>(p); });
+				default:
+					return ScalarLoop<T>(values, previous, begin, count, stride, out, [](P, P) { return true; });
+				}
+			}
+
+			template<typename T>
+			size_t DispatchScalar(ScanCompare compare, const uint8_t* values, const uint8_t* previous, size_t count, size_t stride,
+				const ScanValue& a, const ScanValue& b, uint64_t* out)
+			{
+				return CompareScalar<T>(compare, values, previous, 0, count, stride, Operand<T>(a), Operand<T>(b), out);
+			}
+
+#ifdef MCF_VALUE_X86
+			// Keep the even bits of a byte mask, to get one bit per 16-bit lane
+			inline uint32_t EvenBits(uint32_t x)
+			{
+				x &= 0x55555555;
+				x = (x | (x >> 1)) & 0x33333333;
+				x = (x | (x >> 2)) & 0x0F0F0F0F;
+				x = (x | (x >> 4)) & 0x00FF00FF;
+				return (x | (x >> 8)) & 0x0000FFFF;
+			}
+
+			/// <summary>
+			/// Lane-wise compares of a vector ISA, for one value type. Each compare returns one bit per lane.
+			/// </summary>
+			template<typename Elem>
+			struct IntSSE42
+			{
+				using T = Elem;
+				using V = __m128i;
+				static constexpr size_t Lanes = 16 / sizeof(T);
+				static constexpr uint32_t All = (1u << Lanes) - 1;
+
+				MCF_TARGET("sse4.2") static V Load(const uint8_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+
+				MCF_TARGET("sse4.2") static V Set(T v)
+				{
+					if constexpr (sizeof(T) == 1) return _mm_set1_epi8(v);
+					else if constexpr (sizeof(T) == 2) return _mm_set1_epi16(v);
+					else if constexpr (sizeof(T) == 4) return _mm_set1_epi32(v);
+					else return _mm_set1_epi64x(v);
+				}
+
+				MCF_TARGET("sse4.2") static uint32_t Mask(V m)
+				{
+					if constexpr (sizeof(T) == 1) return (uint32_t)_mm_movemask_epi8(m);
+					else if constexpr (sizeof(T) == 2) return EvenBits((uint32_t)_mm_movemask_epi8(m));
+					else if constexpr (sizeof(T) == 4) return (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(m));
+					else return (uint32_t)_mm_movemask_pd(_mm_castsi128_pd(m));
+				}
+
+				MCF_TARGET("sse4.2") static V CmpEq(V x, V y)
+				{
+					if constexpr (sizeof(T) == 1) return _mm_cmpeq_epi8(x, y);
+					else if constexpr (sizeof(T) == 2) return _mm_cmpeq_epi16(x, y);
+					else if constexpr (sizeof(T) == 4) return _mm_cmpeq_epi32(x, y);
+					else return _mm_cmpeq_epi64(x, y);
+				}
+
+				MCF_TARGET("sse4.2") static V CmpGt(V x, V y)
+				{
+					if constexpr (sizeof(T) == 1) return _mm_cmpgt_epi8(x, y);
+					else if constexpr (sizeof(T) == 2) return _mm_cmpgt_epi16(x, y);
+					else if constexpr (sizeof(T) == 4) return _mm_cmpgt_epi32(x, y);
+					else return _mm_cmpgt_epi64(x, y);
+				}
+
+				MCF_TARGET("sse4.2") static uint32_t Eq(V x, V y) { return Mask(CmpEq(x, y)); }
+				MCF_TARGET("sse4.2") static uint32_t BitEq(V x, V y) { return Mask(CmpEq(x, y)); }
+				MCF_TARGET("sse4.2") static uint32_t Gt(V x, V y) { return Mask(CmpGt(x, y)); }
+				MCF_TARGET("sse4.2") static uint32_t InRange(V x, V a, V b) { return ~Mask(_mm_or_si128(CmpGt(a, x), CmpGt(x, b))) & All; }
+			};
+
+			// Vector type of floating point lanes, by element type and vector size
+			template<typename T, size_t Bytes> struct FloatVector;
+			template<> struct FloatVector<float, 16> { using Type = __m128; };
+			template<> struct FloatVector<double, 16> { using Type = __m128d; };
+			template<> struct FloatVector<float, 32> { using Type = __m256; };
+			template<> struct FloatVector<double, 32> { using Type = __m256d; };
+
+			template<typename Elem>
+			struct FloatSSE42
+			{
+				using T = Elem;
+				using V = typename FloatVector<T, 16>::Type;
+				static constexpr size_t Lanes = 16 / sizeof(T);
+				static constexpr uint32_t All = (1u << Lanes) - 1;
+
+				MCF_TARGET("sse4.2") static V Load(const uint8_t* p)
+				{
+					if constexpr (sizeof(T) == 4) return _mm_loadu_ps((const float*)p);
+					else return _mm_loadu_pd((const double*)p);
+				}
+
+				MCF_TARGET("sse4.2") static V Set(T v)
+				{
+					if constexpr (sizeof(T) == 4) return _mm_set1_ps(v);
+					else return _mm_set1_pd(v);
+				}
+
+				MCF_TARGET("sse4.2") static uint32_t Eq(V x, V y)
+				{
+					if constexpr (sizeof(T) == 4) return (uint32_t)_mm_movemask_ps(_mm_cmpeq_ps(x, y));
+					else return (uint32_t)_mm_movemask_pd(_mm_cmpeq_pd(x, y));
+				}
+
+				MCF_TARGET("sse4.2") static uint32_t BitEq(V x, V y)
+				{
+					if constexpr (sizeof(T) == 4) return (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_castps_si128(x), _mm_castps_si128(y))));
+					else return (uint32_t)_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(_mm_castpd_si128(x), _mm_castpd_si128(y))));
+				}
+
+				MCF_TARGET("sse4.2") static uint32_t Gt(V x, V y)
+				{
+					if constexpr (sizeof(T) == 4) return (uint32_t)_mm_movemask_ps(_mm_cmpgt_ps(x, y));
+					else return (uint32_t)_mm_movemask_pd(_mm_cmpgt_pd(x, y));
+				}
+
+				MCF_TARGET("sse4.2") static uint32_t InRange(V x, V a, V b)
+				{
+					if constexpr (sizeof(T) == 4) return (uint32_t)_mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(x, a), _mm_cmple_ps(x, b)));
+					else return (uint32_t)_mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(x, a), _mm_cmple_pd(x, b)));
+				}
+			};
+
+			template<typename Elem>
+			struct IntAVX2
+			{
+				using T = Elem;
+				using V = __m256i;
+				static constexpr size_t Lanes = 32 / sizeof(T);
+				static constexpr uint32_t All = Lanes == 32 ? 0xFFFFFFFF : (1u << Lanes) - 1;
+
+				MCF_TARGET("avx2") static V Load(const uint8_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+
+				MCF_TARGET("avx2") static V Set(T v)
+				{
+					if constexpr (sizeof(T) == 1) return _mm256_set1_epi8(v);
+					else if constexpr (sizeof(T) == 2) return _mm256_set1_epi16(v);
+					else if constexpr (sizeof(T) == 4) return _mm256_set1_epi32(v);
+					else return _mm256_set1_epi64x(v);
+				}
+
+				MCF_TARGET("avx2") static uint32_t Mask(V m)
+				{
+					if constexpr (sizeof(T) == 1) return (uint32_t)_mm256_movemask_epi8(m);
+					else if constexpr (sizeof(T) == 2) return EvenBits((uint32_t)_mm256_movemask_epi8(m));
+					else if constexpr (sizeof(T) == 4) return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(m));
+					else return (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(m));
+				}
+
+				MCF_TARGET("avx2") static V CmpEq(V x, V y)
+				{
+					if constexpr (sizeof(T) == 1) return _mm256_cmpeq_epi8(x, y);
+					else if constexpr (sizeof(T) == 2) return _mm256_cmpeq_epi16(x, y);
+					else if constexpr (sizeof(T) == 4) return _mm256_cmpeq_epi32(x, y);
+					else return _mm256_cmpeq_epi64(x, y);
+				}
+
+				MCF_TARGET("avx2") static V CmpGt(V x, V y)
+				{
+					if constexpr (sizeof(T) == 1) return _mm256_cmpgt_epi8(x, y);
+					else if constexpr (sizeof(T) == 2) return _mm256_cmpgt_epi16(x, y);
+					else if constexpr (sizeof(T) == 4) return _mm256_cmpgt_epi32(x, y);
+					else return _mm256_cmpgt_epi64(x, y);
+				}
+
+				MCF_TARGET("avx2") static uint32_t Eq(V x, V y) { return Mask(CmpEq(x, y)); }
+				MCF_TARGET("avx2") static uint32_t BitEq(V x, V y) { return Mask(CmpEq(x, y)); }
+				MCF_TARGET("avx2") static uint32_t Gt(V x, V y) { return Mask(CmpGt(x, y)); }
+				MCF_TARGET("avx2") static uint32_t InRange(V x, V a, V b) { return ~Mask(_mm256_or_si256(CmpGt(a, x), CmpGt(x, b))) & All; }
+			};
+
+			template<typename Elem>
+			struct FloatAVX2
+			{
+				using T = Elem;
+				using V = typename FloatVector<T, 32>::Type;
+				static constexpr size_t Lanes = 32 / sizeof(T);
+				static constexpr uint32_t All = (1u << Lanes) - 1;
+
+				MCF_TARGET("avx2") static V Load(const uint8_t* p)
+				{
+					if constexpr (sizeof(T) == 4) return _mm256_loadu_ps((const float*)p);
+					else return _mm256_loadu_pd((const double*)p);
+				}
+
+				MCF_TARGET("avx2") static V Set(T v)
+				{
+					if constexpr (sizeof(T) == 4) return _mm256_set1_ps(v);
+					else return _mm256_set1_pd(v);
+				}
+
+				MCF_TARGET("avx2") static uint32_t Eq(V x, V y)
+				{
+					if constexpr (sizeof(T) == 4) return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(x, y, _CMP_EQ_OQ));
+					else return (uint32_t)_mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_EQ_OQ));
+				}
+
+				MCF_TARGET("avx2") static uint32_t BitEq(V x, V y)
+				{
+					if constexpr (sizeof(T) == 4) return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_castps_si256(x), _mm256_castps_si256(y))));
+					else return (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_castpd_si256(x), _mm256_castpd_si256(y))));
+				}
+
+				MCF_TARGET("avx2") static uint32_t Gt(V x, V y)
+				{
+					if constexpr (sizeof(T) == 4) return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(x, y, _CMP_GT_OQ));
+					else return (uint32_t)_mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_GT_OQ));
+				}
+
+				MCF_TARGET("avx2") static uint32_t InRange(V x, V a, V b)
+				{
+					if constexpr (sizeof(T) == 4) return (uint32_t)_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(x, a, _CMP_GE_OQ), _mm256_cmp_ps(x, b, _CMP_LE_OQ)));
+					else return (uint32_t)_mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(x, a, _CMP_GE_OQ), _mm256_cmp_pd(x, b, _CMP_LE_OQ)));
+				}
+			};
+
+			// The kernels compare 64 values at a time, so that each word of the output is written once, and the
+			// remaining values with the scalar code. The comparison is a template parameter to keep it out of the loop
+			struct KernelSSE42
+			{
+				template<typename Ops, ScanCompare Cmp>
+				MCF_TARGET("sse4.2") static size_t Run(const uint8_t* values, const uint8_t* previous, size_t count,
+					typename Ops::T a, typename Ops::T b, uint64_t* out)
+				{
+					constexpr size_t size = sizeof(typename Ops::T);
+					typename Ops::V va = Ops::Set(a), vb = Ops::Set(b);
+					size_t matches = 0, i = 0;
+					for (; i + 64 <= count; i += 64)
+					{
+						uint64_t word = 0;
+						for (size_t j = 0; j < 64; j += Ops::Lanes)
+						{
+							typename Ops::V x = Ops::Load(values + (i + j) * size);
+							uint32_t bits;
+							if constexpr (Cmp == ScanCompare::Exact) bits = Ops::Eq(x, va);
+							else if constexpr (Cmp == ScanCompare::Range) bits = Ops::InRange(x, va, vb);
+							else
+							{
+								typename Ops::V p = Ops::Load(previous + (i + j) * size);
+								if constexpr (Cmp == ScanCompare::Changed) bits = ~Ops::BitEq(x, p) & Ops::All;
+								else if constexpr (Cmp == ScanCompare::Unchanged) bits = Ops::BitEq(x, p);
+								else if constexpr (Cmp == ScanCompare::Increased) bits = Ops::Gt(x, p);
+								else bits = Ops::Gt(p, x);
+							}
+							word |= (uint64_t)bits << j;
+						}
+						out[i / 64] = word;
+						matches += std::popcount(word);
+					}
+					return matches + CompareScalar<typename Ops::T>(Cmp, values, previous, i, count, size, a, b, out);
+				}
+			};
+
+			struct KernelAVX2
+			{
+				template<typename Ops, ScanCompare Cmp>
+				MCF_TARGET("avx2") static size_t Run(const uint8_t* values, const uint8_t* previous, size_t count,
+					typename Ops::T a, typename Ops::T b, uint64_t* out)
+				{
+					constexpr size_t size = sizeof(typename Ops::T);
+					typename Ops::V va = Ops::Set(a), vb = Ops::Set(b);
+					size_t matches = 0, i = 0;
+					for (; i + 64 <= count; i += 64)
+					{
+						uint64_t word = 0;
+						for (size_t j = 0; j < 64; j += Ops::Lanes)
+						{
+							typename Ops::V x = Ops::Load(values + (i + j) * size);
+							uint32_t bits;
+							if constexpr (Cmp == ScanCompare::Exact) bits = Ops::Eq(x, va);
+							else if constexpr (Cmp == ScanCompare::Range) bits = Ops::InRange(x, va, vb);
+							else
+							{
+								typename Ops::V p = Ops::Load(previous + (i + j) * size);
+								if constexpr (Cmp == ScanCompare::Changed) bits = ~Ops::BitEq(x, p) & Ops::All;
+								else if constexpr (Cmp == ScanCompare::Unchanged) bits = Ops::BitEq(x, p);
+								else if constexpr (Cmp == ScanCompare::Increased) bits = Ops::Gt(x, p);
+								else bits = Ops::Gt(p, x);
+							}
+							word |= (uint64_t)bits << j;
+						}
+						out[i / 64] = word;
+						matches += std::popcount(word);
+					}
+					return matches + CompareScalar<typename Ops::T>(Cmp, values, previous, i, count, size, a, b, out);
+				}
+			};
+
+			template<typename Kernel, typename Ops>
+			size_t DispatchCompare(ScanCompare compare, const uint8_t* values, const uint8_t* previous, size_t count,
+				const ScanValue& a, const ScanValue& b, uint64_t* out)
+			{
+				using T = typename Ops::T;
+				T va = Operand<T>(a), vb = Operand<T>(b);
+				switch (compare)
+				{
+				case ScanCompare::Exact: return Kernel::template Run<Ops, ScanCompare::Exact>(values, previous, count, va, vb, out);
+				case ScanCompare::Range: return Kernel::template Run<Ops, ScanCompare::Range>(values, previous, count, va, vb, out);
+				case ScanCompare::Changed: return Kernel::template Run<Ops, ScanCompare::Changed>(values, previous, count, va, vb, out);
+				case ScanCompare::Unchanged: return Kernel::template Run<Ops, ScanCompare::Unchanged>(values, previous, count, va, vb, out);
+				case ScanCompare::Increased: return Kernel::template Run<Ops, ScanCompare::Increased>(values, previous, count, va, vb, out);
+				case ScanCompare::Decreased: return Kernel::template Run<Ops, ScanCompare::Decreased>(values, previous, count, va, vb, out);
+				default: return CompareScalar<T>(compare, values, previous, 0, count, sizeof(T), va, vb, out);
+				}
+			}
+
+			template<typename Kernel, template<typename> class IntOps, template<typename> class FloatOps>
+			size_t DispatchType(ValueType type, ScanCompare compare, const uint8_t* values, const uint8_t* previous, size_t count,
+				const ScanValue& a, const ScanValue& b, uint64_t* out)
+			{
+				switch (type)
+				{
+				case ValueType::I8: return DispatchCompare<Kernel, IntOps<int8_t>>(compare, values, previous, count, a, b, out);
+				case ValueType::I16: return DispatchCompare<Kernel, IntOps<int16_t>>(compare, values, previous, count, a, b, out);
+				case ValueType::I32: return DispatchCompare<Kernel, IntOps<int32_t>>(compare, values, previous, count, a, b, out);
+				case ValueType::I64: return DispatchCompare<Kernel, IntOps<int64_t>>(compare, values, previous, count, a, b, out);
+				case ValueType::F32: return DispatchCompare<Kernel, FloatOps<float>>(compare, values, previous, count, a, b, out);
+				default: return DispatchCompare<Kernel, FloatOps<double>>(compare, values, previous, count, a, b, out);
+				}
+			}
+#endif
+		}
+
+		size_t SizeOf(ValueType type)
+		{
+			switch (type)
+			{
+			case ValueType::I8: return 1;
+			case ValueType::I16: return 2;
+			case ValueType::I32: case ValueType::F32: return 4;
+			default: return 8;
+			}
+		}
+
+		bool Compare(ValueType type, ScanCompare compare, const uint8_t* value, const uint8_t* previous, const ScanValue& a, const ScanValue& b)
+		{
+			switch (type)
+			{
+			case ValueType::I8: return Test<int8_t>(compare, value, previous, Operand<int8_t>(a), Operand<int8_t>(b));
+			case ValueType::I16: return Test<int16_t>(compare, value, previous, Operand<int16_t>(a), Operand<int16_t>(b));
+			case ValueType::I32: return Test<int32_t>(compare, value, previous, Operand<int32_t>(a), Operand<int32_t>(b));
+			case ValueType::I64: return Test<int64_t>(compare, value, previous, Operand<int64_t>(a), Operand<int64_t>(b));
+			case ValueType::F32: return Test<float>(compare, value, previous, Operand<float>(a), Operand<float>(b));
+			default: return Test<double>(compare, value, previous, Operand<double>(a), Operand<double>(b));
+			}
+		}
+
+		size_t CompareArray(ValueType type, ScanCompare compare, const uint8_t* values, const uint8_t* previous, size_t count,
+			size_t stride, const ScanValue& a, const ScanValue& b, uint64_t* out, AobScanner::Kernel kernel)
+		{
+			if (compare == ScanCompare::Unknown)
+			{
+				std::fill_n(out, count / 64, ~0ull);
+				if (count % 64) out[count / 64] = (1ull << (count % 64)) - 1;
+				return count;
+			}
+
+			// The vector kernels only handle contiguous values
+			switch (stride == SizeOf(type) ? kernel : AobScanner::Kernel::Scalar)
+			{
+#ifdef MCF_VALUE_X86
+			case AobScanner::Kernel::AVX2: return DispatchType<KernelAVX2, IntAVX2, FloatAVX2>(type, compare, values, previous, count, a, b, out);
+			case AobScanner::Kernel::SSE42: return DispatchType<KernelSSE42, IntSSE42, FloatSSE42>(type, compare, values, previous, count, a, b, out);
+#endif
+			default: break;
+			}
+
+			switch (type)
+			{
+			case ValueType::I8: return DispatchScalar<int8_t>(compare, values, previous, count, stride, a, b, out);
+			case ValueType::I16: return DispatchScalar<int16_t>(compare, values, previous, count, stride, a, b, out);
+			case ValueType::I32: return DispatchScalar<int32_t>(compare, values, previous, count, stride, a, b, out);
+			case ValueType::I64: return DispatchScalar<int64_t>(compare, values, previous, count, stride, a, b, out);
+			case ValueType::F32: return DispatchScalar<float>(compare, values, previous, count, stride, a, b, out);
+			default: return DispatchScalar<double>(compare, values, previous, count, stride, a, b, out);
+			}
+		}
+	}
+}
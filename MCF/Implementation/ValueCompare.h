@@ -0,0 +1,38 @@
+#pragma once
+#include "Include/ValueScanTypes.h"
+#include "AobScanner.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace MCF
+{
+	/// <summary>
+	/// Comparison of memory values for ValueScanner, with AVX2 and SSE4.2 kernels for arrays of values selected
+	/// at runtime like those of AobScanner, and a scalar fallback.
+	/// </summary>
+	namespace ValueCompare
+	{
+		using ValueType = ValueScanTypes::ValueType;
+		using ScanCompare = ValueScanTypes::ScanCompare;
+		using ScanValue = ValueScanTypes::ScanValue;
+
+		/// <summary>
+		/// Size of a value of a type, in bytes.
+		/// </summary>
+		size_t SizeOf(ValueType type);
+
+		/// <summary>
+		/// Compare a single value, and its previous value for the comparisons which need one.
+		/// </summary>
+		bool Compare(ValueType type, ScanCompare compare, const uint8_t* value, const uint8_t* previous, const ScanValue& a, const ScanValue& b);
+
+		/// <summary>
+		/// Compare count values stride bytes apart, and the contiguous previous values for the comparisons which need
+		/// them. Bit i of out is set if value i matches, and out must hold (count + 63) / 64 words. The vector kernels
+		/// are used if the values are contiguous.
+		/// </summary>
+		/// <returns>The number of matches.</returns>
+		size_t CompareArray(ValueType type, ScanCompare compare, const uint8_t* values, const uint8_t* previous, size_t count,
+			size_t stride, const ScanValue& a, const ScanValue& b, uint64_t* out, AobScanner::Kernel kernel = AobScanner::BestKernel());
+	}
+}
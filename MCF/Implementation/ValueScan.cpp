@@ -0,0 +1,146 @@
+#include "ValueScan.h"
+#include "ValueCompare.h"
+#include <string.h>
+#include <algorithm>
+
+namespace MCF
+{
+	namespace
+	{
+		// Scratch buffers of the scan threads, reused across blocks
+		thread_local std::vector<uint8_t> read_buffer;
+		thread_local std::vector<uint64_t> match_bits;
+	}
+
+	ValueScan::ValueScan(ValueType type, size_t alignment) :
+		type(type), size(ValueCompare::SizeOf(type)), alignment(alignment)
+	{ }
+
+	void ValueScan::StoreValues(CandidateBlock& block, const uint8_t* buffer, uint32_t first) const
+	{
+		std::vector<uint8_t> values(block.count * size);
+		if (block.encoding == CandidateBlock::Encoding::All && alignment == size)
+			memcpy(values.data(), buffer + first * size, values.size());
+		else
+		{
+			uint8_t* out = values.data();
+			block.ForEach([&](uint32_t slot) {
+				memcpy(out, buffer + (slot - first) * alignment, size);
+				out += size;
+			});
+		}
+		block.values = std::move(values);
+	}
+
+	void ValueScan::FirstBlock(CandidateBlock& block, ScanCompare compare, const ScanValue& a, const ScanValue& b) const
+	{
+		size_t read_size = (block.slots - 1) * alignment + size;
+		read_buffer.resize(read_size);
+		match_bits.assign(((size_t)block.slots + 63) / 64, 0);
+		if (!MemoryRegions::SafeRead(block.begin, read_buffer.data(), read_size))
+		{
+			block.count = 0;
+			return;
+		}
+
+		size_t matches = ValueCompare::CompareArray(type, compare, read_buffer.data(), nullptr, block.slots, alignment,
+			a, b, match_bits.data());
+		block.Assign(match_bits.data(), matches);
+		if (block.count) StoreValues(block, read_buffer.data(), 0);
+	}
+
+	void ValueScan::NextBlock(CandidateBlock& block, ScanCompare compare, const ScanValue& a, const ScanValue& b) const
+	{
+		// Only the memory spanned by the candidates is read, as the block might have few left
+		uint32_t first, last;
+		block.Bounds(first, last);
+		size_t read_size = (last - first) * alignment + size;
+		read_buffer.resize(read_size);
+		match_bits.assign(((size_t)block.slots + 63) / 64, 0);
+		if (!MemoryRegions::SafeRead(block.begin + first * alignment, read_buffer.data(), read_size))
+		{
+			block.count = 0;
+			return;
+		}
+
+		size_t matches = 0;
+		if (block.encoding == CandidateBlock::Encoding::All)
+			matches = ValueCompare::CompareArray(type, compare, read_buffer.data(), block.values.data(), block.slots, alignment,
+				a, b, match_bits.data());
+		else
+		{
+			const uint8_t* previous = block.values.data();
+			block.ForEach([&](uint32_t slot) {
+				if (ValueCompare::Compare(type, compare, read_buffer.data() + (slot - first) * alignment, previous, a, b))
+				{
+					match_bits[slot / 64] |= 1ull << (slot % 64);
+					matches++;
+				}
+				previous += size;
+			});
+		}
+
+		block.Assign(match_bits.data(), matches);
+		if (block.count) StoreValues(block, read_buffer.data(), first);
+	}
+
+	void ValueScan::Compact()
+	{
+		std::erase_if(blocks, [](const CandidateBlock& block) { return block.count == 0; });
+		count = 0;
+		for (const auto& block : blocks) count += block.count;
+	}
+
+	void ValueScan::First(const std::vector<MemoryRegions::Region>& regions, ScanCompare compare, const ScanValue& a, const ScanValue& b, ThreadPool& pool)
+	{
+		// Split the regions into blocks of slots whose values are entirely in the region
+		std::vector<CandidateBlock> new_blocks;
+		for (const auto& region : regions)
+		{
+			if (region.size < size) continue;
+			uintptr_t region_end = region.begin + region.size, slots_end = region_end - size + 1;
+			for (uintptr_t p = region.begin; p < slots_end; p += ChunkSize)
+			{
+				uintptr_t begin = (p + alignment - 1) & ~(uintptr_t)(alignment - 1);
+				uintptr_t end = (std::min)(p + ChunkSize, slots_end);
+				if (begin >= end) continue;
+				new_blocks.push_back(CandidateBlock{ .begin = begin, .slots = (uint32_t)((end - begin + alignment - 1) / alignment) });
+			}
+		}
+
+		pool.ParallelFor(new_blocks.size(), [&](size_t i) {
+			FirstBlock(new_blocks[i], compare, a, b);
+		});
+
+		blocks = std::move(new_blocks);
+		started = true;
+		Compact();
+	}
+
+	void ValueScan::Next(ScanCompare compare, const ScanValue& a, const ScanValue& b, ThreadPool& pool)
+	{
+		pool.ParallelFor(blocks.size(), [&](size_t i) {
+			NextBlock(blocks[i], compare, a, b);
+		});
+		Compact();
+	}
+
+	size_t ValueScan::Results(uintptr_t* out, size_t max, size_t first) const
+	{
+		size_t written = 0;
+		for (const auto& block : blocks)
+		{
+			if (written == max) break;
+			if (first >= block.count)
+			{
+				first -= block.count;
+				continue;
+			}
+			block.ForEach([&](uint32_t slot) {
+				if (first > 0) first--;
+				else if (written < max) out[written++] = block.begin + slot * alignment;
+			});
+		}
+		return written;
+	}
+}
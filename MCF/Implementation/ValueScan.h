@@ -0,0 +1,65 @@
+#pragma once
+#include "Include/ValueScanTypes.h"
+#include "CandidateBlock.h"
+#include "MemoryRegions.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Candidates of a value scan and the passes narrowing them down, which read memory through
+	/// MemoryRegions::SafeRead. Not synchronized: ValueScannerImp serializes the passes and the reads of results.
+	/// </summary>
+	class ValueScan
+	{
+	public:
+		using ValueType = ValueScanTypes::ValueType;
+		using ScanCompare = ValueScanTypes::ScanCompare;
+		using ScanValue = ValueScanTypes::ScanValue;
+
+		// Size of the pieces of memory scanned in parallel, each of which gets a candidate block
+		static constexpr size_t ChunkSize = 1 << 20;
+
+		const ValueType type;
+		const size_t size; // Size of the values
+		const size_t alignment;
+		bool started = false; // Whether the first scan was done
+		size_t count = 0;
+		std::vector<CandidateBlock> blocks; // Sorted by address
+
+		/// <summary>
+		/// Construct a scan of values of a type, at addresses that are a multiple of alignment. The alignment must be
+		/// a power of two no larger than ChunkSize.
+		/// </summary>
+		ValueScan(ValueType type, size_t alignment);
+
+		/// <summary>
+		/// Replace the candidates by the slots of the regions whose value matches.
+		/// </summary>
+		void First(const std::vector<MemoryRegions::Region>& regions, ScanCompare compare, const ScanValue& a, const ScanValue& b, ThreadPool& pool);
+
+		/// <summary>
+		/// Keep the candidates whose value matches. The first scan must have been done.
+		/// </summary>
+		void Next(ScanCompare compare, const ScanValue& a, const ScanValue& b, ThreadPool& pool);
+
+		/// <summary>
+		/// Write the address of up to max candidates, skipping the first ones, to out.
+		/// </summary>
+		/// <returns>The number of addresses written.</returns>
+		size_t Results(uintptr_t* out, size_t max, size_t first) const;
+
+	private:
+		// Compare the values of a block read from memory, and keep the candidates which match along with their value
+		void FirstBlock(CandidateBlock& block, ScanCompare compare, const ScanValue& a, const ScanValue& b) const;
+		void NextBlock(CandidateBlock& block, ScanCompare compare, const ScanValue& a, const ScanValue& b) const;
+
+		// Store the current value of the candidates of a block, read to buffer from the address of slot first
+		void StoreValues(CandidateBlock& block, const uint8_t* buffer, uint32_t first) const;
+
+		// Remove the empty blocks and update the count
+		void Compact();
+	};
+}
@@ -0,0 +1,231 @@
+#include "ValueScannerImp.h"
+#include "ValueCompare.h"
+#include "MemoryRegions.h"
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <format>
+
+namespace MCF
+{
+	namespace
+	{
+		struct NamedType
+		{
+			const char* name;
+			ValueScanner::ValueType type;
+		};
+
+		struct NamedCompare
+		{
+			const char* name;
+			ValueScanner::ScanCompare compare;
+		};
+
+		constexpr NamedType type_names[] = {
+			{ "i8", ValueScanner::ValueType::I8 }, { "i16", ValueScanner::ValueType::I16 },
+			{ "i32", ValueScanner::ValueType::I32 }, { "i64", ValueScanner::ValueType::I64 },
+			{ "f32", ValueScanner::ValueType::F32 }, { "f64", ValueScanner::ValueType::F64 },
+		};
+
+		constexpr NamedCompare compare_names[] = {
+			{ "exact", ValueScanner::ScanCompare::Exact }, { "range", ValueScanner::ScanCompare::Range },
+			{ "unknown", ValueScanner::ScanCompare::Unknown }, { "changed", ValueScanner::ScanCompare::Changed },
+			{ "unchanged", ValueScanner::ScanCompare::Unchanged }, { "increased", ValueScanner::ScanCompare::Increased },
+			{ "decreased", ValueScanner::ScanCompare::Decreased },
+		};
+
+		bool IsFirstScanCompare(ValueScanner::ScanCompare compare)
+		{
+			return compare == ValueScanner::ScanCompare::Exact || compare == ValueScanner::ScanCompare::Range
+				|| compare == ValueScanner::ScanCompare::Unknown;
+		}
+
+		template<typename T>
+		std::string FormatValue(const uint8_t* p)
+		{
+			T v;
+			memcpy(&v, p, sizeof(T));
+			return std::format("{}", v);
+		}
+	}
+
+	ValueScannerImp::ValueScannerImp()
+	{
+		C<CommandMan>()->Register(&scan_cmd);
+	}
+
+	ValueScannerImp::~ValueScannerImp()
+	{
+		C<CommandMan>()->Unregister(&scan_cmd);
+	}
+
+	std::shared_ptr<ValueScan> ValueScannerImp::GetScan(ScanHandle handle)
+	{
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		auto it = scans.find(handle);
+		return it == scans.end() ? nullptr : it->second;
+	}
+
+	ScanHandle ValueScannerImp::NewScan(ValueType type, size_t alignment)
+	{
+		size_t size = ValueCompare::SizeOf(type);
+		if (alignment == 0) alignment = size;
+		if ((alignment & (alignment - 1)) != 0 || alignment > ValueScan::ChunkSize) return 0;
+
+		auto scan = std::make_shared<ValueScan>(type, alignment);
+
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		ScanHandle handle = next_handle++;
+		scans[handle] = scan;
+		return handle;
+	}
+
+	size_t ValueScannerImp::FirstScan(ScanHandle handle, ScanCompare compare, ScanValue a, ScanValue b)
+	{
+		auto scan = GetScan(handle);
+		if (scan == nullptr || !IsFirstScanCompare(compare)) return 0;
+
+		std::lock_guard<decltype(scan_mutex)> scan_lock(scan_mutex);
+
+		auto regions = MemoryRegions::Writable();
+		size_t total_size = 0;
+		for (const auto& region : regions) total_size += region.size;
+		scan->First(regions, compare, a, b, *pool);
+
+		C<Logger>()->Debug(this, "First scan {} found {} candidates in {} MB of memory", handle, scan->count, total_size >> 20);
+		return scan->count;
+	}
+
+	size_t ValueScannerImp::NextScan(ScanHandle handle, ScanCompare compare, ScanValue a, ScanValue b)
+	{
+		auto scan = GetScan(handle);
+		if (scan == nullptr || compare == ScanCompare::Unknown) return 0;
+
+		std::lock_guard<decltype(scan_mutex)> scan_lock(scan_mutex);
+		if (!scan->started) return 0;
+
+		scan->Next(compare, a, b, *pool);
+		return scan->count;
+	}
+
+	size_t ValueScannerImp::GetResults(ScanHandle handle, uintptr_t* out, size_t max, size_t first)
+	{
+		auto scan = GetScan(handle);
+		if (scan == nullptr) return 0;
+
+		std::lock_guard<decltype(scan_mutex)> scan_lock(scan_mutex);
+		scan->Results(out, max, first);
+		return scan->count;
+	}
+
+	void ValueScannerImp::CloseScan(ScanHandle handle)
+	{
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		scans.erase(handle);
+	}
+
+	void ValueScannerImp::SetScanThreadCount(size_t count)
+	{
+		std::lock_guard<decltype(scan_mutex)> scan_lock(scan_mutex);
+		pool = std::make_unique<ThreadPool>(count);
+	}
+
+	ValueScanner::ScanValue ValueScannerImp::ScanCommand::ParseValue(ValueType type, const char* str)
+	{
+		if (type == ValueType::F32 || type == ValueType::F64) return ScanValue::Float(strtod(str, nullptr));
+		return ScanValue::Int(strtoll(str, nullptr, 0));
+	}
+
+	void ValueScannerImp::ScanCommand::Run(const char* args[], size_t count)
+	{
+		auto cmd_man = man->C<CommandMan>();
+		if (count < 1)
+		{
+			cmd_man->Print(HelpMessage());
+			return;
+		}
+
+		std::lock_guard<decltype(mutex)> lock(mutex);
+		if (strcmp(args[0], "list") == 0)
+		{
+			size_t max = count > 1 ? (std::min)((size_t)strtoull(args[1], nullptr, 10), MaxListed) : 20;
+			std::vector<uintptr_t> addresses(max);
+			size_t total = man->GetResults(handle, addresses.data(), max, 0);
+			addresses.resize((std::min)(max, total));
+
+			for (uintptr_t address : addresses)
+			{
+				uint8_t value[8]{ };
+				if (!MemoryRegions::SafeRead(address, value, ValueCompare::SizeOf(type)))
+				{
+					cmd_man->Print(std::format("{:#x}: unreadable", address).c_str());
+					continue;
+				}
+
+				std::string str;
+				switch (type)
+				{
+				case ValueType::I8: str = FormatValue<int8_t>(value); break;
+				case ValueType::I16: str = FormatValue<int16_t>(value); break;
+				case ValueType::I32: str = FormatValue<int32_t>(value); break;
+				case ValueType::I64: str = FormatValue<int64_t>(value); break;
+				case ValueType::F32: str = FormatValue<float>(value); break;
+				default: str = FormatValue<double>(value); break;
+				}
+				cmd_man->Print(std::format("{:#x}: {}", address, str).c_str());
+			}
+			cmd_man->Print(std::format("{} candidates", total).c_str());
+			return;
+		}
+
+		bool first_scan = strcmp(args[0], "first") == 0;
+		if ((!first_scan && strcmp(args[0], "next") != 0) || count < (first_scan ? 3u : 2u))
+		{
+			cmd_man->Print(HelpMessage());
+			return;
+		}
+
+		size_t arg = 1;
+		ValueType scan_type = type;
+		if (first_scan)
+		{
+			auto t = std::find_if(std::begin(type_names), std::end(type_names), [&](const NamedType& n) { return strcmp(n.name, args[arg]) == 0; });
+			if (t == std::end(type_names))
+			{
+				cmd_man->Print(std::format("Unknown value type \"{}\"", args[arg]).c_str());
+				return;
+			}
+			scan_type = t->type;
+			arg++;
+		}
+
+		auto c = std::find_if(std::begin(compare_names), std::end(compare_names), [&](const NamedCompare& n) { return strcmp(n.name, args[arg]) == 0; });
+		if (c == std::end(compare_names) || (first_scan ? !IsFirstScanCompare(c->compare) : c->compare == ScanCompare::Unknown))
+		{
+			cmd_man->Print(std::format("Invalid comparison \"{}\" for a {} scan", args[arg], args[0]).c_str());
+			return;
+		}
+		arg++;
+
+		size_t num_operands = c->compare == ScanCompare::Range ? 2 : c->compare == ScanCompare::Exact ? 1 : 0;
+		if (count != arg + num_operands)
+		{
+			cmd_man->Print(HelpMessage());
+			return;
+		}
+		ScanValue a = num_operands > 0 ? ParseValue(scan_type, args[arg]) : ScanValue{ };
+		ScanValue b = num_operands > 1 ? ParseValue(scan_type, args[arg + 1]) : ScanValue{ };
+
+		size_t found;
+		if (first_scan)
+		{
+			man->CloseScan(handle);
+			type = scan_type;
+			handle = man->NewScan(type, 0);
+			found = man->FirstScan(handle, c->compare, a, b);
+		}
+		else found = man->NextScan(handle, c->compare, a, b);
+		cmd_man->Print(std::format("{} candidates", found).c_str());
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "Include/ValueScanner.h"
+#include "Include/Logger.h"
+#include "Include/CommandMan.h"
+#include "Include/Export.h"
+#include "ValueScan.h"
+#include "ThreadPool.h"
+
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace MCF
+{
+	class ValueScannerImp final : public SharedInterfaceImp<ValueScanner, ValueScannerImp, DepList<EventMan, Logger, CommandMan>>
+	{
+	private:
+		std::unordered_map<ScanHandle, std::shared_ptr<ValueScan>> scans;
+		ScanHandle next_handle = 1;
+		std::mutex mutex;
+		std::mutex scan_mutex; // Held during scans and while reading their results
+		std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>();
+
+		std::shared_ptr<ValueScan> GetScan(ScanHandle handle);
+
+		class ScanCommand : public CommandBase
+		{
+			// Most candidates printed by vscan list
+			static constexpr size_t MaxListed = 1000;
+
+			ValueScannerImp* man;
+			std::mutex mutex; // Held while running, guards the current scan
+			ScanHandle handle = 0;
+			ValueType type = ValueType::I32;
+
+			// Parse a value of a type, as an integer or a float
+			static ScanValue ParseValue(ValueType type, const char* str);
+
+		public:
+			ScanCommand(ValueScannerImp* man) : man(man) { }
+
+			virtual void Run(const char* args[], size_t count) override;
+			virtual const char* Name() const override { return "vscan"; }
+			virtual const char* HelpMessage() const override
+			{
+				return "vscan first <i8|i16|i32|i64|f32|f64> <exact|range|unknown> [a] [b]: Start a new scan of writable memory\n"
+					"vscan next <exact|range|changed|unchanged|increased|decreased> [a] [b]: Narrow down the candidates\n"
+					"vscan list [max]: Print the candidates and their current value, up to 1000";
+			}
+		} scan_cmd{ this };
+
+	public:
+		ValueScannerImp();
+		~ValueScannerImp();
+
+		virtual bool IsUnloadable() const override { return true; }
+
+		virtual ScanHandle NewScan(ValueType type, size_t alignment) override;
+
+		virtual size_t FirstScan(ScanHandle handle, ScanCompare compare, ScanValue a, ScanValue b) override;
+
+		virtual size_t NextScan(ScanHandle handle, ScanCompare compare, ScanValue a, ScanValue b) override;
+
+		virtual size_t GetResults(ScanHandle handle, uintptr_t* out, size_t max, size_t first) override;
+
+		virtual void CloseScan(ScanHandle handle) override;
+
+		virtual void SetScanThreadCount(size_t count) override;
+	};
+
+	MCF_COMPONENT_EXPORT(ValueScannerImp);
+}
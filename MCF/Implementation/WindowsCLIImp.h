@@ -4,10 +4,10 @@
 #include "Include/EventMan.h"
 #include "Include/CommandMan.h"
 #include "Include/Export.h"
+#include "AnsiLogWriter.h"
 
 #include <Windows.h>
 #include <concurrent_unordered_map.h>
-#include <iomanip>
 #include <iostream>
 
 namespace MCF
@@ -17,24 +17,15 @@ namespace MCF
 	private:
 		concurrency::concurrent_unordered_map<std::string, uint16_t> colors;
 
+		AnsiLogWriter writer{ [](const char* data, size_t size) {
+			DWORD written;
+			WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), data, (DWORD)size, &written, NULL);
+		} };
+
 		EventCallback<Logger::LogEvent> log_cb = [this](Logger::LogEvent* evt) {
 			// Log style: [TIME] [SEV] [SOURCE] MESSAGE
-
 			uint16_t color = colors.count(evt->sev) ? colors.at(evt->sev) : 0x0707u;
-
-			auto time = std::time(nullptr);
-			auto tm = std::localtime(&time);
-			
-			HANDLE STDOUT = GetStdHandle(STD_OUTPUT_HANDLE);
-			
-			SetConsoleTextAttribute(STDOUT, color & 0xff);
-			std::cout << std::put_time(tm, "[%T] ") << "[";
-			SetConsoleTextAttribute(STDOUT, color >> 8);
-			std::cout << evt->sev;
-			SetConsoleTextAttribute(STDOUT, color & 0xff);
-			std::cout << "] [" << evt->source << "] ";
-			std::cout << evt->msg << std::endl;
-			SetConsoleTextAttribute(STDOUT, 0x07);
+			writer.Write(evt->sev, evt->source, evt->msg, color);
 		};
 
 	public:
@@ -64,6 +55,12 @@ namespace MCF
 				std::cerr.clear();
 				std::cin.clear();
 
+				// Log lines are colored with VT sequences instead of SetConsoleTextAttribute calls
+				HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+				DWORD mode = 0;
+				if (GetConsoleMode(console, &mode))
+					SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+
 				// Remove console close button to prevent accidentally closing the game process
 				HWND hwnd = GetConsoleWindow();
 				if (hwnd != NULL)
@@ -76,6 +73,7 @@ namespace MCF
 
 		virtual void Hide() override
 		{
+			writer.Flush();
 			fclose(stdin);
 			fclose(stdout);
 			fclose(stderr);
@@ -84,6 +82,7 @@ namespace MCF
 
 		virtual void Clear() override
 		{
+			writer.Flush();
 			COORD tl = { 0,0 };
 			CONSOLE_SCREEN_BUFFER_INFO s;
 			HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
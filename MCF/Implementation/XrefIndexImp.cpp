@@ -0,0 +1,240 @@
+#include "XrefIndexImp.h"
+#include "XrefScanner.h"
+#include "AobScanner.h"
+#include "ModuleRef.h"
+#include <string.h>
+#include <algorithm>
+
+namespace MCF
+{
+	XrefIndexImp::~XrefIndexImp()
+	{
+		{
+			std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+			index_stop = true;
+		}
+		index_cv.notify_all();
+		if (index_thread.joinable()) index_thread.join();
+	}
+
+	bool XrefIndexImp::IndexModule(const char* module_name)
+	{
+		ModuleIndex::ModuleInfo mod_info;
+		if (!C<ModuleIndex>()->FindModuleByName(module_name, &mod_info)) return false;
+
+		std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+		any_queued = true;
+		{
+			std::shared_lock<decltype(mutex)> shared_lock(mutex);
+			if (modules.count(mod_info.base)) return true;
+		}
+		if (indexing.count(mod_info.base) || std::find(index_queue.begin(), index_queue.end(), mod_info.base) != index_queue.end())
+			return true;
+
+		index_queue.push_back(mod_info.base);
+		if (!index_thread.joinable()) index_thread = std::thread(&XrefIndexImp::IndexLoop, this);
+		index_cv.notify_all();
+		return true;
+	}
+
+	void XrefIndexImp::IndexLoop()
+	{
+		std::unique_lock<decltype(index_mutex)> lock(index_mutex);
+		while (true)
+		{
+			index_cv.wait(lock, [this] { return index_stop || !index_queue.empty(); });
+			if (index_stop) return;
+
+			uintptr_t base = index_queue.front();
+			index_queue.pop_front();
+			IndexQueued(lock, base);
+		}
+	}
+
+	void XrefIndexImp::IndexQueued(std::unique_lock<std::mutex>& lock, uintptr_t base)
+	{
+		indexing[base] = false;
+		lock.unlock();
+
+		ModuleIndex::ModuleInfo mod_info;
+		std::shared_ptr<ModuleXrefs> xrefs;
+		{
+			// Unload events may come after the module is unmapped, so it is kept loaded while it is decoded
+			ModuleRef ref(base);
+			if (ref && C<ModuleIndex>()->FindModule(base, &mod_info) && mod_info.base == base) xrefs = Build(mod_info);
+		}
+
+		lock.lock();
+		bool cancelled = indexing[base];
+		indexing.erase(base);
+		if (!xrefs || cancelled || index_stop)
+		{
+			index_cv.notify_all();
+			return;
+		}
+		{
+			std::unique_lock<decltype(mutex)> unique_lock(mutex);
+			modules[base] = xrefs;
+		}
+		index_cv.notify_all();
+
+		// The Logger raises events under EventMan's lock, which a waiting query may hold, so the waiters are
+		// released first
+		lock.unlock();
+		C<Logger>()->Debug(this, "Indexed {} references in module {}", xrefs->entries.size(), mod_info.name);
+		lock.lock();
+	}
+
+	std::shared_ptr<XrefIndexImp::ModuleXrefs> XrefIndexImp::Build(const ModuleIndex::ModuleInfo& mod_info)
+	{
+		uintptr_t base = mod_info.base;
+		std::vector<ModuleIndex::SectionInfo> sections(mod_info.num_sections);
+		sections.resize((std::min)(sections.size(), C<ModuleIndex>()->GetSections(base, sections.data(), sections.size())));
+
+		struct Chunk
+		{
+			const ModuleIndex::SectionInfo* section;
+			uintptr_t begin;
+			uintptr_t end;
+		};
+		std::vector<Chunk> chunks;
+		for (const auto& section : sections)
+		{
+			if (!(section.flags & ModuleIndex::SectionExecute)) continue;
+			uintptr_t end = section.begin + section.size;
+			for (uintptr_t p = section.begin; p < end; p += ChunkSize)
+				chunks.push_back(Chunk{ .section = &section, .begin = p, .end = (std::min)(p + ChunkSize, end) });
+		}
+
+		std::vector<std::vector<Xref>> chunk_xrefs(chunks.size());
+		pool->ParallelFor(chunks.size(), [&](size_t i) {
+			const Chunk& chunk = chunks[i];
+			auto section_begin = (const uint8_t*)chunk.section->begin;
+			XrefScanner::ScanChunk(section_begin, section_begin + chunk.section->size, (const uint8_t*)chunk.begin,
+				(const uint8_t*)chunk.end, mod_info.base, mod_info.base + mod_info.size, chunk_xrefs[i]);
+		});
+
+		auto xrefs = std::make_shared<ModuleXrefs>();
+		xrefs->base = base;
+		for (const auto& v : chunk_xrefs)
+			for (const auto& xref : v)
+				xrefs->entries.push_back(Entry{ .to = xref.to, .from = (uint32_t)(xref.from - base), .type = xref.type });
+
+		std::sort(xrefs->entries.begin(), xrefs->entries.end(), [](const Entry& a, const Entry& b) {
+			return a.to != b.to ? a.to < b.to : a.from < b.from;
+		});
+		return xrefs;
+	}
+
+	void XrefIndexImp::WaitIndexed()
+	{
+		bool queue_main;
+		{
+			std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+			queue_main = !any_queued;
+		}
+		if (queue_main) IndexModule(nullptr);
+
+		std::unique_lock<decltype(index_mutex)> lock(index_mutex);
+		while (!index_stop)
+		{
+			if (!index_queue.empty())
+			{
+				uintptr_t base = index_queue.front();
+				index_queue.pop_front();
+				IndexQueued(lock, base);
+			}
+			else if (indexing.empty()) return;
+			else index_cv.wait(lock);
+		}
+	}
+
+	void XrefIndexImp::OnModuleUnloaded(ModuleIndex::ModuleUnloadedEvent* evt)
+	{
+		uintptr_t base = evt->module.base;
+		{
+			// This runs under EventMan's lock, so the indexer is not waited for: it keeps the module loaded while
+			// decoding it, and discards its index once cancelled
+			std::lock_guard<decltype(index_mutex)> lock(index_mutex);
+			std::erase(index_queue, base);
+			auto it = indexing.find(base);
+			if (it != indexing.end()) it->second = true;
+		}
+
+		std::unique_lock<decltype(mutex)> lock(mutex);
+		modules.erase(base);
+	}
+
+	template<typename TPred>
+	size_t XrefIndexImp::Collect(uintptr_t begin, uintptr_t end, Xref* out, size_t max, TPred pred)
+	{
+		size_t count = 0;
+		std::shared_lock<decltype(mutex)> lock(mutex);
+		for (const auto& [base, xrefs] : modules)
+		{
+			auto it = std::lower_bound(xrefs->entries.begin(), xrefs->entries.end(), begin, [](const Entry& e, uintptr_t to) {
+				return e.to < to;
+			});
+			for (; it != xrefs->entries.end() && it->to < end; ++it)
+			{
+				if (!pred(it->type)) continue;
+				if (count < max) out[count] = Xref{ .from = base + it->from, .to = it->to, .type = it->type };
+				count++;
+			}
+		}
+		return count;
+	}
+
+	size_t XrefIndexImp::FindReferences(uintptr_t address, Xref* out, size_t max, size_t size)
+	{
+		WaitIndexed();
+		return Collect(address, address + size, out, max, [](XrefType) { return true; });
+	}
+
+	size_t XrefIndexImp::FindCallers(uintptr_t function, Xref* out, size_t max)
+	{
+		WaitIndexed();
+		return Collect(function, function + 1, out, max, [](XrefType type) { return type != XrefType::Data; });
+	}
+
+	size_t XrefIndexImp::FindStringReferences(const char* string, Xref* out, size_t max, const char* module_name)
+	{
+		ModuleIndex::ModuleInfo mod_info;
+		if (!C<ModuleIndex>()->FindModuleByName(module_name, &mod_info)) return 0;
+		ModuleRef ref(mod_info.base);
+		if (!ref) return 0;
+
+		std::vector<ModuleIndex::SectionInfo> sections(mod_info.num_sections);
+		sections.resize((std::min)(sections.size(), C<ModuleIndex>()->GetSections(mod_info.base, sections.data(), sections.size())));
+
+		// The string as narrow and UTF-16 text, with its terminator
+		size_t length = strlen(string);
+		if (length == 0) return 0;
+		std::vector<uint8_t> narrow(string, string + length + 1), wide((length + 1) * 2, 0);
+		for (size_t i = 0; i < length; i++) wide[2 * i] = (uint8_t)string[i];
+		std::vector<uint8_t> narrow_mask(narrow.size(), 0xFF), wide_mask(wide.size(), 0xFF);
+		CompiledAob patterns[2] = {
+			CompiledAob(narrow.data(), narrow_mask.data(), narrow.size()),
+			CompiledAob(wide.data(), wide_mask.data(), wide.size())
+		};
+
+		IndexModule(module_name);
+		WaitIndexed();
+		size_t count = 0;
+		for (const auto& section : sections)
+		{
+			if (!(section.flags & ModuleIndex::SectionRead) || (section.flags & ModuleIndex::SectionExecute)) continue;
+
+			auto begin = (const uint8_t*)section.begin, end = begin + section.size;
+			for (const auto& pattern : patterns)
+			{
+				for (const uint8_t* p = begin; (p = AobScanner::Find(pattern, p, end)) != nullptr; p++)
+				{
+					size_t written = (std::min)(count, max);
+					count += Collect((uintptr_t)p, (uintptr_t)p + 1, out + written, max - written, [](XrefType) { return true; });
+				}
+			}
+		}
+		return count;
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "Include/XrefIndex.h"
+#include "Include/ModuleIndex.h"
+#include "Include/Logger.h"
+#include "Include/Export.h"
+#include "ThreadPool.h"
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+
+namespace MCF
+{
+	class XrefIndexImp final : public SharedInterfaceImp<XrefIndex, XrefIndexImp, DepList<EventMan, Logger, ModuleIndex>>
+	{
+	private:
+		struct Entry
+		{
+			uintptr_t to;
+			uint32_t from; // Relative to the module base
+			XrefType type;
+		};
+
+		/// <summary>
+		/// References made by the code of a module, sorted by target and then by source.
+		/// </summary>
+		struct ModuleXrefs
+		{
+			uintptr_t base;
+			std::vector<Entry> entries;
+		};
+
+		// Size of the pieces of code sections decoded in parallel
+		static constexpr size_t ChunkSize = 1 << 20;
+
+		std::map<uintptr_t, std::shared_ptr<ModuleXrefs>> modules; // By base address
+		std::shared_mutex mutex;
+		std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>();
+
+		// State of the background thread building the index
+		std::deque<uintptr_t> index_queue; // Base of the modules to index
+		std::map<uintptr_t, bool> indexing; // Modules being decoded, and whether they were unloaded meanwhile
+		bool any_queued = false;
+		bool index_stop = false;
+		std::mutex index_mutex;
+		std::condition_variable index_cv;
+		std::thread index_thread;
+
+		void IndexLoop();
+
+		// Index a module taken from the queue, and publish its index unless it was unloaded meanwhile. Called with
+		// the index lock held, which is released while the module is decoded and while the result is logged
+		void IndexQueued(std::unique_lock<std::mutex>& lock, uintptr_t base);
+
+		// Decode the code sections of a module, which must be kept loaded
+		std::shared_ptr<ModuleXrefs> Build(const ModuleIndex::ModuleInfo& mod_info);
+
+		// Wait until the queued modules are indexed, queuing the main module if none was. Modules still in the
+		// queue are decoded on the calling thread, so that a query never waits for a worker which is logging
+		void WaitIndexed();
+
+		// Find the references to [begin, end) of the types accepted by pred
+		template<typename TPred>
+		size_t Collect(uintptr_t begin, uintptr_t end, Xref* out, size_t max, TPred pred);
+
+		void OnModuleUnloaded(ModuleIndex::ModuleUnloadedEvent* evt);
+
+		EventCallback<ModuleIndex::ModuleUnloadedEvent> module_unloaded_cb = [this](ModuleIndex::ModuleUnloadedEvent* evt) {
+			OnModuleUnloaded(evt);
+		};
+
+	public:
+		~XrefIndexImp();
+
+		virtual bool IsUnloadable() const override { return true; }
+
+		virtual bool IndexModule(const char* module_name) override;
+
+		virtual size_t FindReferences(uintptr_t address, Xref* out, size_t max, size_t size) override;
+
+		virtual size_t FindCallers(uintptr_t function, Xref* out, size_t max) override;
+
+		virtual size_t FindStringReferences(const char* string, Xref* out, size_t max, const char* module_name) override;
+	};
+
+	MCF_COMPONENT_EXPORT(XrefIndexImp);
+}
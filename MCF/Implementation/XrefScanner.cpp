@@ -0,0 +1,66 @@
+#include "XrefScanner.h"
+#include <Zydis/Zydis.h>
+#include <algorithm>
+
+namespace MCF
+{
+	namespace XrefScanner
+	{
+		void ScanChunk(const uint8_t* section_begin, const uint8_t* section_end, const uint8_t* begin, const uint8_t* end,
+			uintptr_t image_begin, uintptr_t image_end, std::vector<XrefIndex::Xref>& out)
+		{
+			ZydisDecoder decoder;
+			ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_ADDRESS_WIDTH_64);
+
+			const uint8_t* p = (size_t)(begin - section_begin) > ResyncBytes ? begin - ResyncBytes : section_begin;
+			ZydisDecodedInstruction instr;
+			while (p < end)
+			{
+				size_t available = (std::min)((size_t)(section_end - p), (size_t)ZYDIS_MAX_INSTRUCTION_LENGTH);
+				if (!ZYAN_SUCCESS(ZydisDecoderDecodeBuffer(&decoder, p, available, &instr)))
+				{
+					p++;
+					continue;
+				}
+
+				const uint8_t* instr_begin = p;
+				p += instr.length;
+				if (instr_begin < begin) continue;
+
+				auto address = (uintptr_t)instr_begin;
+				for (ZyanU8 i = 0; i < instr.operand_count; i++)
+				{
+					const ZydisDecodedOperand& op = instr.operands[i];
+					ZyanU64 target;
+					XrefIndex::XrefType type = XrefIndex::XrefType::Data;
+
+					if (op.type == ZYDIS_OPERAND_TYPE_MEMORY && op.mem.base == ZYDIS_REGISTER_RIP)
+					{
+						if (!ZYAN_SUCCESS(ZydisCalcAbsoluteAddress(&instr, &op, address, &target))) continue;
+					}
+					else if (op.type == ZYDIS_OPERAND_TYPE_MEMORY && op.mem.base == ZYDIS_REGISTER_NONE && op.mem.index == ZYDIS_REGISTER_NONE)
+					{
+						target = (ZyanU64)op.mem.disp.value;
+						if (target < image_begin || target >= image_end) continue;
+					}
+					else if (op.type == ZYDIS_OPERAND_TYPE_IMMEDIATE && op.imm.is_relative)
+					{
+						// Conditional and short jumps stay within their function and would only bloat the index
+						if (instr.meta.category == ZYDIS_CATEGORY_CALL) type = XrefIndex::XrefType::Call;
+						else if (instr.meta.category == ZYDIS_CATEGORY_UNCOND_BR && instr.raw.imm[0].size == 32) type = XrefIndex::XrefType::Jump;
+						else continue;
+						if (!ZYAN_SUCCESS(ZydisCalcAbsoluteAddress(&instr, &op, address, &target))) continue;
+					}
+					else if (op.type == ZYDIS_OPERAND_TYPE_IMMEDIATE && op.size >= 32)
+					{
+						target = op.imm.value.u;
+						if (target < image_begin || target >= image_end) continue;
+					}
+					else continue;
+
+					out.push_back(XrefIndex::Xref{ .from = address, .to = (uintptr_t)target, .type = type });
+				}
+			}
+		}
+	}
+}
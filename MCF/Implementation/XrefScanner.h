@@ -0,0 +1,26 @@
+#pragma once
+#include "Include/XrefIndex.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace MCF
+{
+	/// <summary>
+	/// Linear sweep of code with Zydis, collecting the references made by each instruction.
+	/// </summary>
+	namespace XrefScanner
+	{
+		// Bytes decoded before a chunk so that the sweep is synchronized with instruction boundaries when it 
+		// reaches the chunk, as x86 decoding realigns itself after a few instructions
+		static constexpr size_t ResyncBytes = 64;
+
+		/// <summary>
+		/// Collect the references of the instructions starting in [begin, end), decoding from up to ResyncBytes 
+		/// before begin, but not before section_begin nor past section_end. Immediates are only references if they
+		/// point into [image_begin, image_end). Undecodable bytes are skipped one at a time.
+		/// </summary>
+		void ScanChunk(const uint8_t* section_begin, const uint8_t* section_end, const uint8_t* begin, const uint8_t* end,
+			uintptr_t image_begin, uintptr_t image_end, std::vector<XrefIndex::Xref>& out);
+	}
+}
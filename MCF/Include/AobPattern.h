@@ -0,0 +1,113 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include "Utils.h"
+#include "TemplateUtils.h"
+
+namespace MCF
+{
+	union AobChar
+	{
+		uint16_t as_num;
+		struct {
+			uint8_t byte; // Byte to match
+			uint8_t mask; // bits of the byte to consider in the scan
+		};
+
+		constexpr AobChar() : as_num(0) { };
+		constexpr AobChar(uint16_t val) : as_num(val) { }
+		constexpr AobChar(uint8_t byte, uint8_t mask) : byte(byte), mask(mask) { }
+
+		constexpr operator uint16_t() const { return as_num; }
+
+		constexpr bool Matches(uint8_t b) const
+		{
+			return byte == (b & mask);
+		}
+	};
+
+	/// <summary>
+	/// Parser shared by MCF_AOB and AobScanMan::ConvertAobString. Tokens are separated by whitespace and are either
+	/// one or two hex digits, where each digit may be replaced by ? to ignore that nibble (ex. 48 8B ?? 4? ?F ?).
+	/// </summary>
+	namespace AobParser
+	{
+		enum class Status { Ok, End, Malformed };
+
+		constexpr bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+		}
+
+		/// <summary>
+		/// Parse the next token of a CE-style AOB string, advancing s past it.
+		/// </summary>
+		constexpr Status NextToken(const char*& s, AobChar& out)
+		{
+			while (IsSpace(*s)) s++;
+			if (*s == 0) return Status::End;
+
+			uint8_t byte = 0, mask = 0;
+			int digits = 0;
+			for (; *s != 0 && !IsSpace(*s); s++, digits++)
+			{
+				if (digits == 2) return Status::Malformed;
+				byte <<= 4;
+				mask <<= 4;
+				if (*s == '?') continue;
+
+				uint8_t n = Utils::ChrToHex(*s);
+				if (n == 0xFF) return Status::Malformed;
+				byte |= n;
+				mask |= 0xF;
+			}
+			// A single hex digit is a whole byte with a zero high nibble
+			if (digits == 1 && mask != 0) mask = 0xFF;
+
+			out = AobChar(byte, mask);
+			return Status::Ok;
+		}
+	}
+
+	/// <summary>
+	/// AOB pattern parsed from a CE-style string at compile time, see MCF_AOB. The scanner data (anchor byte,
+	/// prefilters) is built by AobScanMan when the pattern is registered, from its own byte frequency table.
+	/// </summary>
+	template<size_t N>
+	struct AobPattern
+	{
+		std::array<AobChar, N> chars{ };
+		constexpr size_t size() const { return N; }
+		constexpr const AobChar* data() const { return chars.data(); }
+	};
+
+	template<FixedString str>
+	consteval size_t AobPatternLength()
+	{
+		const char* s = str;
+		AobChar c;
+		size_t n = 0;
+		for (AobParser::Status st; (st = AobParser::NextToken(s, c)) != AobParser::Status::End; n++)
+		{
+			if (st == AobParser::Status::Malformed) throw "Malformed AOB string";
+		}
+		if (n == 0) throw "Empty AOB string";
+		return n;
+	}
+
+	template<FixedString str>
+	consteval AobPattern<AobPatternLength<str>()> CompileAobPattern()
+	{
+		AobPattern<AobPatternLength<str>()> pattern;
+		const char* s = str;
+		for (AobChar& c : pattern.chars) AobParser::NextToken(s, c);
+		return pattern;
+	}
+
+	/// <summary>
+	/// Parse a CE-style AOB string (ex. MCF_AOB("48 8B ?? 89")) to an AobPattern at compile time.
+	/// Malformed patterns are compile errors.
+	/// </summary>
+	#define MCF_AOB(str) (::MCF::CompileAobPattern<str>())
+}
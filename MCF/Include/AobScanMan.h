@@ -1,10 +1,11 @@
 #pragma once
 #include "SharedInterface.h"
 #include "EventMan.h"
-#include "SharedInterfaceMan.h"
 #include <common.h>
 #include <winnt.h>
-#include "Utils.h"
+#include "AobPattern.h"
+#include <vector>
+#include <string>
 
 namespace MCF
 {
@@ -12,40 +13,54 @@ namespace MCF
 	typedef bool (*SectionFilter)(HMODULE hMod, const char* mod_name, IMAGE_SECTION_HEADER* section);
 	typedef int AobHandle;
 
-	union AobChar
+	enum class AobResolveOp : uint8_t
 	{
-		uint16_t as_num;
-		struct {
-			uint8_t byte; // Byte to match
-			uint8_t mask; // bits of the byte to consider in the scan
-		};
-
-		AobChar() : as_num(0) { };
-		AobChar(uint16_t val) : as_num(val) { }
-		AobChar(uint8_t byte, uint8_t mask) : byte(byte), mask(mask) { }
+		Offset, // Add the offset to the address
+		RipOperand, // Decode the instruction at address + offset and take the target of its RIP-relative memory operand
+		FollowBranch, // Decode the call or jump at address + offset and take its target
+		Deref // Read the pointer at the address, then add the offset to it. Fails if the pointer is null
+	};
 
-		operator uint16_t() const { return as_num; }
+	/// <summary>
+	/// Step applied to the match of an AOB to get the address stored as its result, see AobScanMan::RegisterAob.
+	/// </summary>
+	struct AobResolveStep
+	{
+		AobResolveOp op;
+		int32_t offset;
 
-		inline bool Matches(uint8_t b)
-		{
-			return byte == (b & mask);
-		}
+		static constexpr AobResolveStep Offset(int32_t offset) { return { AobResolveOp::Offset, offset }; }
+		static constexpr AobResolveStep RipOperand(int32_t offset = 0) { return { AobResolveOp::RipOperand, offset }; }
+		static constexpr AobResolveStep FollowBranch(int32_t offset = 0) { return { AobResolveOp::FollowBranch, offset }; }
+		static constexpr AobResolveStep Deref(int32_t offset = 0) { return { AobResolveOp::Deref, offset }; }
 	};
 
 	/// <summary>
 	/// Shared interface allowing the registration of AOBs for future scan, and then querying the results by name.
 	/// </summary>
-	class AobScanMan : public SharedInterface<AobScanMan, "MCF_AOB_SCAN_MAN_001", EventMan>
+	class AobScanMan : public SharedInterface<AobScanMan, "MCF_AOB_SCAN_MAN_001">
 	{
 	public:
-		struct AobScanCompleteEvent : public Event<"MCF_AOB_SCAN_COMPLETE_EVENT"> { };
+		/// <summary>
+		/// Raised once all AOBs registered under an object have been scanned for.
+		/// If some were not found, it is raised again with success set once they are all found in modules loaded later.
+		/// This only applies to AOBs with a module filter, and results in a module are reset to 0 when it is unloaded.
+		/// </summary>
+		struct AobScanCompleteEvent : public Event<"MCF_AOB_SCAN_COMPLETE_EVENT"> 
+		{
+			const void* obj;
+			bool success; // False if at least one of the AOBs was not found
+		};
 
 		/// <summary>
 		/// Register an AOB to scan in the .text section of the main module with an object instance. 
 		/// Will set out_result (if not null) to the result of the scan and dispatch an AobScanComplete event when
-		/// all AOBs registered under the "obj" object have been found
+		/// all AOBs registered under the "obj" object have been found.
+		/// The resolve steps, if any, are applied in order to the match on the scan threads, and the final address is
+		/// used as the result. If a step fails, the AOB is considered not found.
 		/// </summary>
-		virtual AobHandle RegisterAob(const AobChar* aob, size_t length, const void* obj = nullptr, uintptr_t* out_result = nullptr, ModuleFilter module_filter = nullptr, SectionFilter section_filter = nullptr) = 0;
+		virtual AobHandle RegisterAob(const AobChar* aob, size_t length, const void* obj = nullptr, uintptr_t* out_result = nullptr, ModuleFilter module_filter = nullptr, SectionFilter section_filter = nullptr,
+			const AobResolveStep* steps = nullptr, size_t num_steps = 0) = 0;
 
 		/// <summary>
 		/// Unregister an AOB by handle.
@@ -67,40 +82,116 @@ namespace MCF
 		virtual uintptr_t QueryAobResult(AobHandle) = 0;
 
 		/// <summary>
-		/// Convert a CE-style AOB string (ex. DE ? AD BE EF) to a AobChar vector.
+		/// Scan for all the AOBs registered since the last scan. AobScanCompleteEvent is raised for each object as
+		/// soon as all of its AOBs are resolved, possibly from a scan thread, while the scan continues for the others.
+		/// AOBs with no module filter are searched in the main module, and AOBs with no section filter in .text.
 		/// </summary>
-		/// <param name="ce_aob_string"></param>
-		/// <returns></returns>
-		static std::vector<AobChar> ConvertAobString(const char* ce_aob_string)
-		{
-			std::vector<AobChar> aob;
+		virtual void ScanPending() = 0;
 
-			for (char c = *ce_aob_string; c != 0; c = *(++ce_aob_string))
-			{
-				if (isspace(c)) continue;
-				if (c == '?') aob.push_back(0);
-				
-				uint8_t byte = Utils::ChrToHex(c);
-				if (byte == 0xFF) continue;
+		/// <summary>
+		/// Bind a call result receiving an AobScanCompleteEvent once all AOBs registered under obj have been
+		/// scanned for. Raised immediately if none are pending.
+		/// </summary>
+		virtual HCallResult AwaitObj(const void* obj, CallResultBase* call_result) = 0;
+
+		/// <summary>
+		/// Set the number of threads scanning sections in parallel, or 0 for one per hardware thread (the default).
+		/// </summary>
+		virtual void SetScanThreadCount(size_t count) = 0;
 
-				char n = Utils::ChrToHex(ce_aob_string[1]);
-				if (n != 0xFF) byte = byte << 4 | n;
+		/// <summary>
+		/// Set the file in which the location of found AOBs is cached between launches, or NULL to disable the cache.
+		/// Cached locations are only used if the module and section headers are unchanged and the bytes still match,
+		/// so that only the AOBs which miss are scanned for. By default, the cache is stored in the temp directory.
+		/// </summary>
+		virtual void SetCachePath(const char* path) = 0;
 
-				aob.push_back({ byte, 0xFF });
+		/// <summary>
+		/// Set the memory budget of the index used by QueryPattern, or 0 to disable it (the default). The executable
+		/// sections of each module are indexed on a background thread, the main module first, as densely as the
+		/// remaining budget allows. Setting the budget rebuilds the index.
+		/// </summary>
+		virtual void SetQueryIndexBudget(size_t max_bytes) = 0;
+
+		/// <summary>
+		/// Find the first match of an AOB immediately, for one-off queries. Sections are searched with the index
+		/// when it covers them and the AOB has enough fully known bytes, and scanned otherwise.
+		/// Filters default to the .text section of the main module, as in RegisterAob.
+		/// </summary>
+		/// <returns>The address of the match, or 0 if not found.</returns>
+		virtual uintptr_t QueryPattern(const AobChar* aob, size_t length, ModuleFilter module_filter = nullptr, SectionFilter section_filter = nullptr) = 0;
+
+		/// <summary>
+		/// Find the first match of a CE-style AOB string immediately. See the main overload.
+		/// </summary>
+		uintptr_t QueryPattern(const char* ce_aob_string, ModuleFilter module_filter = nullptr, SectionFilter section_filter = nullptr)
+		{
+			std::vector<AobChar> aob = ConvertAobString(ce_aob_string);
+			return aob.empty() ? 0 : QueryPattern(aob.data(), aob.size(), module_filter, section_filter);
+		}
+
+		/// <summary>
+		/// Generate the shortest AOB which matches at address and nowhere else in its section, to register it later.
+		/// Instructions are taken from CodeAnalysis starting at address, and the bytes which change with relocations
+		/// and patches (relative branch targets, 32-bit displacements and pointers into the module) are wildcarded.
+		/// </summary>
+		/// <param name="out">Array receiving up to max_length characters.</param>
+		/// <returns>The length of the AOB, or 0 if the address is not in a known section or no unique AOB of up to 
+		/// max_length bytes exists.</returns>
+		virtual size_t GenerateSignature(uintptr_t address, AobChar* out, size_t max_length) = 0;
+
+		/// <summary>
+		/// Convert an AOB to a CE-style string, where each unknown nibble is written as ?.
+		/// </summary>
+		static std::string FormatAobString(const AobChar* aob, size_t length)
+		{
+			constexpr char digits[] = "0123456789ABCDEF";
+			std::string str;
+			for (size_t i = 0; i < length; i++)
+			{
+				if (i) str.push_back(' ');
+				str.push_back((aob[i].mask & 0xF0) ? digits[aob[i].byte >> 4] : '?');
+				str.push_back((aob[i].mask & 0x0F) ? digits[aob[i].byte & 0xF] : '?');
 			}
+			return str;
+		}
 
+		/// <summary>
+		/// Convert a CE-style AOB string (ex. DE ? AD BE EF) to a AobChar vector. Prefer MCF_AOB for literals.
+		/// </summary>
+		/// <returns>The pattern, or an empty vector if the string is malformed.</returns>
+		static std::vector<AobChar> ConvertAobString(const char* ce_aob_string)
+		{
+			std::vector<AobChar> aob;
+			AobChar c;
+			for (AobParser::Status st; (st = AobParser::NextToken(ce_aob_string, c)) != AobParser::Status::End; )
+			{
+				if (st == AobParser::Status::Malformed) return { };
+				aob.push_back(c);
+			}
 			return aob;
 		}
 
+		/// <summary>
+		/// Register an AOB parsed by MCF_AOB, without parsing or allocating at runtime. See the main overload.
+		/// </summary>
+		template<size_t N>
+		AobHandle RegisterAob(const AobPattern<N>& pattern, const void* obj = nullptr, uintptr_t* out_result = nullptr, ModuleFilter module_filter = nullptr, SectionFilter section_filter = nullptr,
+			const AobResolveStep* steps = nullptr, size_t num_steps = 0)
+		{
+			return RegisterAob(pattern.data(), N, obj, out_result, module_filter, section_filter, steps, num_steps);
+		}
+
 		/// <summary>
 		/// Register an AOB to scan in the .text section of the main module with an object instance. 
 		/// Will set out_result (if not null) to the result of the scan and dispatch an AobScanComplete event when
 		/// all AOBs registered under the "obj" object have been found
 		/// </summary>
-		AobHandle RegisterAob(const char* ce_aob_string, const void* obj = nullptr, uintptr_t* out_result = nullptr, ModuleFilter module_filter = nullptr, SectionFilter section_filter = nullptr)
+		AobHandle RegisterAob(const char* ce_aob_string, const void* obj = nullptr, uintptr_t* out_result = nullptr, ModuleFilter module_filter = nullptr, SectionFilter section_filter = nullptr,
+			const AobResolveStep* steps = nullptr, size_t num_steps = 0)
 		{
 			std::vector<AobChar> aob = ConvertAobString(ce_aob_string);
-			RegisterAob(aob.data(), aob.size(), obj, out_result, module_filter, section_filter);
+			return RegisterAob(aob.data(), aob.size(), obj, out_result, module_filter, section_filter, steps, num_steps);
 		}
 	};
 }
\ No newline at end of file
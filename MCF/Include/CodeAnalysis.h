@@ -0,0 +1,81 @@
+#pragma once
+#include "SharedInterface.h"
+#include "EventMan.h"
+
+namespace MCF
+{
+	/// <summary>
+	/// Shared cache of function boundaries and decoded instructions, so that hooks, signature generation and
+	/// cross-reference queries do not decode the same code again. The functions of a module are discovered the 
+	/// first time an address in it is queried, and the instructions of a function the first time they are 
+	/// requested, after which both are lookups. Safe to query from multiple threads.
+	/// </summary>
+	class CodeAnalysis : public SharedInterface<CodeAnalysis, "MCF_CODE_ANALYSIS_001">
+	{
+	public:
+		enum FunctionSource : uint32_t
+		{
+			SourceUnwindInfo = 1, // RUNTIME_FUNCTION of .pdata (Windows x64)
+			SourceSymbol = 2, // ELF symbol table
+			SourceCallTarget = 4 // Target of a direct call
+		};
+
+		enum InstructionFlags : uint8_t
+		{
+			InstrCall = 1,
+			InstrJump = 2, // Unconditional jump
+			InstrCondJump = 4,
+			InstrReturn = 8,
+			InstrRelative = 16, // Has a relative branch target or a RIP-relative operand, to fix up when relocated
+			InstrInvalid = 32 // Could not be decoded, and is assumed to be 1 byte long
+		};
+
+		struct FunctionInfo
+		{
+			uintptr_t begin;
+			uintptr_t end;
+			uint32_t sources; // FunctionSource flags
+		};
+
+		struct Instruction
+		{
+			uintptr_t target; // Direct branch target or RIP-relative operand address, 0 if none
+			uint32_t offset; // Offset from the start of the function
+			uint8_t length;
+			uint8_t flags; // InstructionFlags
+
+			// Position and size in bytes of the displacement and of the first immediate within the instruction, 
+			// 0 if it has none. Used to find the bytes which change with relocations, ex. for signatures
+			uint8_t disp_offset;
+			uint8_t disp_size;
+			uint8_t imm_offset;
+			uint8_t imm_size;
+		};
+
+		/// <summary>
+		/// Find the function containing an address. Fragments split from a function (chained unwind info) are 
+		/// reported as the function they belong to.
+		/// </summary>
+		virtual bool FindFunction(uintptr_t address, FunctionInfo* out) = 0;
+
+		/// <summary>
+		/// Get the instructions of the function containing an address, decoded linearly from its start.
+		/// </summary>
+		/// <param name="out">Array receiving up to max instructions.</param>
+		/// <returns>The total number of instructions, which may be larger than max, or 0 if not in a function.</returns>
+		virtual size_t GetInstructions(uintptr_t address, Instruction* out, size_t max) = 0;
+
+		/// <summary>
+		/// Find the instruction of a function containing an address, to get instruction boundaries.
+		/// </summary>
+		/// <param name="start">Receives the address of the instruction.</param>
+		virtual bool FindInstruction(uintptr_t address, uintptr_t* start, Instruction* out) = 0;
+
+		/// <summary>
+		/// Discover the functions of a module now rather than on first query, or of the main module if module_name
+		/// is NULL.
+		/// </summary>
+		/// <returns>The number of functions.</returns>
+		virtual size_t AnalyzeModule(const char* module_name = nullptr) = 0;
+	};
+}
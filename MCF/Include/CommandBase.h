@@ -0,0 +1,13 @@
+#pragma once
+#include <stddef.h>
+
+namespace MCF
+{
+	class CommandBase
+	{
+	public:
+		virtual void Run(const char* args[], size_t count) = 0;
+		virtual const char* Name() const = 0;
+		virtual const char* HelpMessage() const = 0;
+	};
+}
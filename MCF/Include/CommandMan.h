@@ -1,30 +1,125 @@
 #pragma once
 #include "SharedInterface.h"
 #include "EventMan.h"
+#include "CommandBase.h"
 
 namespace MCF
 {
-	class CommandBase
+	class CommandMan : public SharedInterface<CommandMan, "MCF_COMMAND_MAN_002">
 	{
 	public:
-		virtual void Run(const char* args[], size_t count) = 0;
-		virtual const char* Name() const = 0;
-		virtual const char* HelpMessage() const = 0;
-	};
+		/// <summary>
+		/// Executor ID under which RunCommandAsync runs commands on the shared worker pool.
+		/// Any other ID designates a pump, i.e. a thread which periodically calls PumpCommands with that ID.
+		/// </summary>
+		static constexpr uint32_t WorkerPool = 0;
 
-	class CommandMan : public SharedInterface<CommandMan, "MCF_COMMAND_MAN_001">
-	{
-	public:
+		enum class CommandStatus : uint32_t
+		{
+			Completed = 0,
+			Failed = 1, // The command string was malformed or the command was not found
+			Cancelled = 2,
+			TimedOut = 3,
+		};
+
+		/// <summary>
+		/// Call result of RunCommandAsync.
+		/// </summary>
+		struct CommandResult
+		{
+			HCallResult handle;
+			CommandStatus status;
+			uint64_t elapsed_us; // Time spent running the command, zero if it never started
+		};
+
+		/// <summary>
+		/// Raised with output text printed by a command running asynchronously, as it is printed.
+		/// </summary>
+		struct CommandOutputEvent : public Event<"MCF_COMMAND_OUTPUT_EVENT">
+		{
+			HCallResult handle;
+			const char* text;
+		};
+
+		/// <summary>
+		/// Register a command under its name. Fails if a command with the same name is already registered.
+		/// </summary>
 		virtual bool Register(CommandBase* cmd) = 0;
 
+		/// <summary>
+		/// Unregister a command. Waits for running invocations of the command to complete, except those of the calling
+		/// thread, so that a command (or a script using it) may unregister itself.
+		/// </summary>
 		virtual bool Unregister(CommandBase* cmd) = 0;
 
-		virtual void RunCommand(const char* command_string) = 0;
+		/// <summary>
+		/// Parse and run a command. The first token is the command name, and the remaining ones are passed to 
+		/// CommandBase::Run. Tokens are separated by whitespace, and may be quoted with single or double quotes.
+		/// Backslash escapes the next character inside double quotes.
+		/// </summary>
+		/// <returns>False if the command string was malformed or the command was not found.</returns>
+		virtual bool RunCommand(const char* command_string) = 0;
+
+		/// <summary>
+		/// Find the registered commands whose name starts with prefix, in lexicographic order.
+		/// </summary>
+		/// <param name="out_names">Array receiving up to max names.</param>
+		/// <returns>The number of names written.</returns>
+		virtual size_t Complete(const char* prefix, const char** out_names, size_t max) = 0;
+
+		/// <summary>
+		/// Queue a command to run on the worker pool or on a pump thread. The call result receives a CommandResult
+		/// once it finishes, and its output is streamed through CommandOutputEvent. If timeout_ms is not 0 and the command
+		/// is still queued or running after timeout_ms, the call result receives TimedOut at that time and the command 
+		/// is flagged cancelled. Cancellation is cooperative: the command keeps running until it polls IsCancelled.
+		/// </summary>
+		/// <param name="call_result">The call result to bind, or NULL.</param>
+		/// <param name="executor">WorkerPool, or the ID of the pump which will run the command.</param>
+		/// <returns>Handle identifying the command.</returns>
+		virtual HCallResult RunCommandAsync(const char* command_string, CallResultBase* call_result = nullptr,
+			uint32_t executor = WorkerPool, uint32_t timeout_ms = 0) = 0;
+
+		/// <summary>
+		/// Request cancellation of a command started by RunCommandAsync. Queued commands will not start.
+		/// </summary>
+		/// <returns>False if the command has already finished.</returns>
+		virtual bool CancelCommand(HCallResult handle) = 0;
+
+		/// <summary>
+		/// Run the commands queued for the given pump on the calling thread.
+		/// </summary>
+		/// <returns>The number of commands run.</returns>
+		virtual size_t PumpCommands(uint32_t pump) = 0;
+
+		/// <summary>
+		/// Run a script file on the calling thread, then print the timing of each command. The whole script is
+		/// parsed before anything runs. Besides commands, a line may contain:
+		///   # comment
+		///   set NAME VALUE       Set a variable, substituted for $NAME or ${NAME} in the following lines ($$ for $)
+		///   repeat COUNT [NAME]  Repeat the lines up to the matching "end", storing the iteration index in NAME
+		///   end
+		/// Consecutive commands prefixed with & are independent and may run in parallel.
+		/// To run a script asynchronously, use RunCommandAsync with the built-in "script" command.
+		/// </summary>
+		/// <returns>False if the script could not be read or parsed, or was cancelled.</returns>
+		virtual bool RunScript(const char* path) = 0;
+
+		/// <summary>
+		/// Output text from the command running on this thread. Asynchronous commands stream it through 
+		/// CommandOutputEvent, while synchronous ones log it.
+		/// </summary>
+		virtual void Print(const char* text) = 0;
+
+		/// <summary>
+		/// Returns true if the command running on this thread was cancelled or timed out.
+		/// </summary>
+		virtual bool IsCancelled() = 0;
 	};
 
 	/// <summary>
 	/// Command object using a std::function to allow registering callbacks on any callable object.
 	/// May be registered on creation or manually. Unregistered automatically when destroyed.
+	/// The name and help message are not copied, and must outlive the command (e.g. string literals).
 	/// </summary>
 	class Command : public CommandBase
 	{
@@ -53,7 +148,7 @@ namespace MCF
 		template<typename TObj>
 		bool Register(void(TObj::* cb)(const char*[], size_t), TObj* instance)
 		{
-			fun = std::bind(cb, instance);
+			fun = std::bind(cb, instance, std::placeholders::_1, std::placeholders::_2);
 			return TryRegister();
 		}
 
@@ -78,13 +173,14 @@ namespace MCF
 			return true;
 		}
 
-		Command() { }
+		Command(const char* name, const char* help_message) : name(name), help_message(help_message) { }
 
 		/// <summary>
 		/// Constructs and registers this command with a function to a member function pointer.
 		/// </summary>
 		template<typename TObj>
-		Command(void(TObj::* cb)(const char*[], size_t), TObj* instance)
+		Command(const char* name, const char* help_message, void(TObj::* cb)(const char*[], size_t), TObj* instance) :
+			Command(name, help_message)
 		{
 			Register(cb, instance);
 		}
@@ -93,7 +189,7 @@ namespace MCF
 		/// Constructs and registers this command with a general callable object.
 		/// </summary>
 		template<typename TCallable> requires std::is_invocable_r_v<void, TCallable, const char*[], size_t>
-		Command(TCallable cb)
+		Command(const char* name, const char* help_message, TCallable cb) : Command(name, help_message)
 		{
 			Register(cb);
 		}
@@ -1,9 +1,17 @@
 #pragma once
 #include "TemplateUtils.h"
+#include <atomic>
 
 namespace MCF
 {
 	struct CompInfo;
+	class Logger;
+
+	/// <summary>
+	/// Small integer handle to a source registered with the Logger.
+	/// </summary>
+	typedef uint32_t LogSourceId;
+	static constexpr LogSourceId InvalidLogSource = 0;
 
 	/// <summary>
 	/// Interface for components, the base objects managed automatically by MCF.
@@ -134,6 +142,8 @@ namespace MCF
 
 		DepPtrArray<DependsOn> dep_list;
 
+		mutable std::atomic<LogSourceId> log_source = InvalidLogSource;
+
 	protected:
 		/// <summary>
 		/// Efficient access to a dependency. Prefer this helper function to 
@@ -147,6 +157,21 @@ namespace MCF
 		}
 
 	public:
+		/// <summary>
+		/// Get the log source ID of this component, registering its version string with the Logger on first use.
+		/// </summary>
+		template<class TLogger = Logger>
+		LogSourceId LogSource() const
+		{
+			LogSourceId id = log_source.load(std::memory_order_relaxed);
+			if (id == InvalidLogSource)
+			{
+				id = TLogger::Get()->RegisterSource(version_string);
+				log_source.store(id, std::memory_order_relaxed);
+			}
+			return id;
+		}
+
 		Component() { };
 		Component(Component&) = delete;
 		Component(Component&&) = delete;
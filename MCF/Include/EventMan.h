@@ -44,7 +44,7 @@ namespace MCF
 	/// Class which manages and dispatches events. Events are structued similarly to Steam callbacks
 	/// and call results. Anything may listen for and dispatch events.  
 	/// </summary>
-	class EventMan : public SharedInterface<EventMan, "MCF_EVENT_MAN_001">
+	class EventMan : public SharedInterface<EventMan, "MCF_EVENT_MAN_002">
 	{
 	public:
 		/// <summary>
@@ -115,6 +115,13 @@ namespace MCF
 		/// </summary>
 		/// <returns>A boolean indicating success/failure.</returns>
 		virtual bool RaiseCallResult(HCallResult handle, void* result) = 0;
+
+		/// <summary>
+		/// Returns true if at least one callback is registered for this event. Useful to skip building 
+		/// expensive event data when nobody is listening.
+		/// </summary>
+		/// <param name="event_name">The name of the event.</param>
+		virtual bool HasListeners(const char* event_name) = 0;
 	};
 
 	/// <summary>
@@ -0,0 +1,106 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+
+namespace MCF
+{
+	/// <summary>
+	/// Binary layout of the log flight recorder, a circular buffer of fixed-size slots stored in a named shared memory
+	/// segment. Every message given to the Logger is copied into it, including the ones rejected by filters.
+	/// This header is self-contained so that external tools and crash handlers can read the ring without linking MCF.
+	/// </summary>
+	namespace FlightRecorder
+	{
+		static constexpr uint32_t Magic = 0x5246434D; // "MCFR"
+		static constexpr uint32_t Version = 2;
+		static constexpr uint32_t SlotSize = 256;
+		static constexpr uint32_t MaxSlotCount = 1 << 22; // 1 GiB of slots
+
+		/// <summary>
+		/// Header placed at the start of the shared memory segment. Slots immediately follow it.
+		/// </summary>
+		struct alignas(64) Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t slot_size;
+			uint32_t slot_count; // Always a power of two
+			uint32_t pid;
+			uint32_t reserved;
+
+			alignas(64) std::atomic<uint64_t> write_index; // Total number of messages ever written
+		};
+
+		/// <summary>
+		/// A single message. The text buffer contains the source, severity and message strings back to back
+		/// (not null terminated), followed by the structured fields of the message (see LogRecord.h), 
+		/// truncated to fit the slot.
+		/// </summary>
+		struct Slot
+		{
+			std::atomic<uint64_t> seq; // Index of the message + 1 once committed, 0 while being written
+			int64_t timestamp; // Nanoseconds since the Unix epoch
+			uint32_t thread_id;
+			uint8_t src_len;
+			uint8_t sev_len;
+			uint16_t msg_len;
+			uint16_t fields_len;
+			char text[SlotSize - 26];
+		};
+		static_assert(sizeof(Slot) == SlotSize);
+
+		/// <summary>
+		/// Total size of a segment holding slot_count slots.
+		/// </summary>
+		inline size_t SegmentSize(uint32_t slot_count)
+		{
+			return sizeof(Header) + (size_t)slot_count * sizeof(Slot);
+		}
+
+		/// <summary>
+		/// Writes the name of the shared memory segment used by the process with the given PID.
+		/// </summary>
+		inline void SegmentName(char* buf, size_t size, uint32_t pid)
+		{
+			snprintf(buf, size, "Local\\MCF_FlightRecorder_%u", pid);
+		}
+
+		inline Slot* Slots(Header* header)
+		{
+			return (Slot*)(header + 1);
+		}
+
+		/// <summary>
+		/// Iterate over the committed messages of a mapped segment, from oldest to newest. Slots which are being
+		/// written to (or were torn by a crash) are skipped. The callback receives a copy of the slot.
+		/// </summary>
+		/// <returns>The number of messages visited.</returns>
+		template<typename TCallable>
+		size_t ForEachMessage(Header* header, TCallable cb)
+		{
+			if (header->magic != Magic || header->version != Version || header->slot_size != SlotSize)
+				return 0;
+
+			uint64_t end = header->write_index.load(std::memory_order_acquire);
+			uint64_t begin = end > header->slot_count ? end - header->slot_count : 0;
+
+			size_t visited = 0;
+			Slot copy;
+			for (uint64_t i = begin; i < end; i++)
+			{
+				Slot* slot = &Slots(header)[i & (header->slot_count - 1)];
+				if (slot->seq.load(std::memory_order_acquire) != i + 1) continue;
+
+				memcpy((void*)&copy, (void*)slot, sizeof(Slot));
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot->seq.load(std::memory_order_relaxed) != i + 1) continue;
+
+				cb((const Slot*)&copy);
+				visited++;
+			}
+			return visited;
+		}
+	}
+}
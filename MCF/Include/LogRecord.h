@@ -0,0 +1,284 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <charconv>
+#include <cmath>
+
+namespace MCF
+{
+	enum class LogFieldType : uint8_t
+	{
+		Int = 0, // Signed integer, stored as a zigzag varint
+		UInt = 1, // Unsigned integer, stored as a varint
+		Float = 2, // 64-bit float
+		String = 3, // Length-prefixed (varint) string, copied into the record
+		Address = 4, // 64-bit address, rendered in hex
+		Bool = 5, // Single byte
+	};
+
+	/// <summary>
+	/// Typed key/value pair passed to Logger::LogFields. Strings are not copied until the record is encoded,
+	/// so the key and string values only need to live until the call returns.
+	/// </summary>
+	struct LogField
+	{
+		const char* key;
+		LogFieldType type;
+		union
+		{
+			int64_t i;
+			uint64_t u;
+			double f;
+			bool b;
+			struct { const char* data; size_t size; } str;
+		};
+
+		template<typename T> requires std::is_integral_v<T>
+		LogField(const char* key, T value) : key(key)
+		{
+			if constexpr (std::is_same_v<T, bool>) { type = LogFieldType::Bool; b = value; }
+			else if constexpr (std::is_signed_v<T>) { type = LogFieldType::Int; i = value; }
+			else { type = LogFieldType::UInt; u = value; }
+		}
+
+		template<typename T> requires std::is_floating_point_v<T>
+		LogField(const char* key, T value) : key(key), type(LogFieldType::Float), f(value) { }
+
+		LogField(const char* key, std::string_view value) : key(key), type(LogFieldType::String), str{ value.data(), value.size() } { }
+		LogField(const char* key, const char* value) : LogField(key, std::string_view(value)) { }
+		LogField(const char* key, const void* value) : key(key), type(LogFieldType::Address), u((uintptr_t)value) { }
+	};
+
+	/// <summary>
+	/// A decoded field. String values point into the record they were decoded from.
+	/// </summary>
+	struct LogFieldView
+	{
+		std::string_view key;
+		LogFieldType type;
+		union
+		{
+			int64_t i;
+			uint64_t u;
+			double f;
+			bool b;
+		};
+		std::string_view str;
+	};
+
+	/// <summary>
+	/// Encoding, decoding and rendering of the compact binary layout used for structured log fields.
+	/// Each field is stored as [type: u8][key length: u8][key][value], with the value encoded as described in LogFieldType.
+	/// </summary>
+	namespace LogRecord
+	{
+		inline void PutVarint(std::string& out, uint64_t v)
+		{
+			while (v >= 0x80)
+			{
+				out.push_back((char)(v | 0x80));
+				v >>= 7;
+			}
+			out.push_back((char)v);
+		}
+
+		inline bool GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+		{
+			v = 0;
+			for (int shift = 0; p < end && shift < 64; shift += 7)
+			{
+				uint8_t b = *p++;
+				v |= (uint64_t)(b & 0x7F) << shift;
+				if (!(b & 0x80)) return true;
+			}
+			return false;
+		}
+
+		/// <summary>
+		/// Append the encoding of the given fields to out. Keys longer than 255 bytes are truncated.
+		/// </summary>
+		inline void Encode(std::string& out, const LogField* fields, size_t count)
+		{
+			for (size_t n = 0; n < count; n++)
+			{
+				const LogField& field = fields[n];
+				size_t key_len = strnlen(field.key, 0xFF);
+
+				out.push_back((char)field.type);
+				out.push_back((char)key_len);
+				out.append(field.key, key_len);
+
+				switch (field.type)
+				{
+				case LogFieldType::Int: PutVarint(out, ((uint64_t)field.i << 1) ^ (uint64_t)(field.i >> 63)); break;
+				case LogFieldType::UInt: PutVarint(out, field.u); break;
+				case LogFieldType::Float: out.append((const char*)&field.f, sizeof(double)); break;
+				case LogFieldType::Address: out.append((const char*)&field.u, sizeof(uint64_t)); break;
+				case LogFieldType::Bool: out.push_back((char)field.b); break;
+				case LogFieldType::String:
+					PutVarint(out, field.str.size);
+					out.append(field.str.data, field.str.size);
+					break;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Iterate over the fields of an encoded record without copying them.
+		/// </summary>
+		/// <returns>False if the record is malformed.</returns>
+		template<typename TCallable>
+		bool Decode(const uint8_t* data, size_t size, TCallable cb)
+		{
+			const uint8_t* p = data, * end = data + size;
+			while (p < end)
+			{
+				if (end - p < 2) return false;
+				LogFieldView field{ };
+				field.type = (LogFieldType)p[0];
+				size_t key_len = p[1];
+				p += 2;
+				if ((size_t)(end - p) < key_len) return false;
+				field.key = std::string_view((const char*)p, key_len);
+				p += key_len;
+
+				uint64_t v;
+				switch (field.type)
+				{
+				case LogFieldType::Int:
+					if (!GetVarint(p, end, v)) return false;
+					field.i = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+					break;
+				case LogFieldType::UInt:
+					if (!GetVarint(p, end, field.u)) return false;
+					break;
+				case LogFieldType::Float:
+				case LogFieldType::Address:
+					if (end - p < 8) return false;
+					memcpy(&field.u, p, 8);
+					p += 8;
+					break;
+				case LogFieldType::Bool:
+					if (end - p < 1) return false;
+					field.b = *p++ != 0;
+					break;
+				case LogFieldType::String:
+					if (!GetVarint(p, end, v) || (uint64_t)(end - p) < v) return false;
+					field.str = std::string_view((const char*)p, v);
+					p += v;
+					break;
+				default:
+					return false;
+				}
+				cb((const LogFieldView&)field);
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Append a string as a quoted and escaped JSON string.
+		/// </summary>
+		inline void AppendJsonString(std::string& out, std::string_view str)
+		{
+			out.push_back('"');
+			for (char c : str)
+			{
+				if (c == '"' || c == '\\') { out.push_back('\\'); out.push_back(c); }
+				else if ((uint8_t)c < 0x20)
+				{
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04x", (uint8_t)c);
+					out.append(buf);
+				}
+				else out.push_back(c);
+			}
+			out.push_back('"');
+		}
+
+		/// <summary>
+		/// Append the value of a field as text. Strings are appended as-is, or quoted and escaped if json is true.
+		/// </summary>
+		inline void RenderValue(std::string& out, const LogFieldView& field, bool json = false)
+		{
+			char buf[32];
+			std::to_chars_result res{ buf, std::errc() };
+			switch (field.type)
+			{
+			case LogFieldType::Int: res = std::to_chars(buf, buf + sizeof(buf), field.i); break;
+			case LogFieldType::UInt: res = std::to_chars(buf, buf + sizeof(buf), field.u); break;
+			case LogFieldType::Float:
+				// JSON has no representation of NaN and infinities
+				if (json && !std::isfinite(field.f))
+				{
+					out.append("null");
+					return;
+				}
+				res = std::to_chars(buf, buf + sizeof(buf), field.f);
+				break;
+			case LogFieldType::Bool: out.append(field.b ? "true" : "false"); return;
+			case LogFieldType::Address:
+				if (json) out.push_back('"');
+				out.append("0x");
+				res = std::to_chars(buf, buf + sizeof(buf), field.u, 16);
+				out.append(buf, res.ptr);
+				if (json) out.push_back('"');
+				return;
+			case LogFieldType::String:
+				if (json) AppendJsonString(out, field.str);
+				else out.append(field.str);
+				return;
+			}
+			out.append(buf, res.ptr);
+		}
+
+		/// <summary>
+		/// Append the fields of a record as space-separated key=value pairs.
+		/// </summary>
+		inline void RenderText(std::string& out, const uint8_t* data, size_t size)
+		{
+			bool first = true;
+			Decode(data, size, [&](const LogFieldView& field) {
+				if (!first) out.push_back(' ');
+				first = false;
+				out.append(field.key);
+				out.push_back('=');
+				RenderValue(out, field);
+			});
+		}
+
+		/// <summary>
+		/// Append the fields of a record as a JSON object.
+		/// </summary>
+		inline void RenderJson(std::string& out, const uint8_t* data, size_t size)
+		{
+			bool first = true;
+			out.push_back('{');
+			Decode(data, size, [&](const LogFieldView& field) {
+				if (!first) out.push_back(',');
+				first = false;
+				AppendJsonString(out, field.key);
+				out.push_back(':');
+				RenderValue(out, field, true);
+			});
+			out.push_back('}');
+		}
+
+		/// <summary>
+		/// Append the values of the given columns, in order and separated by sep. Missing columns are left empty.
+		/// </summary>
+		inline void RenderColumns(std::string& out, const uint8_t* data, size_t size, const char* const* columns, size_t num_columns, char sep = '\t')
+		{
+			for (size_t c = 0; c < num_columns; c++)
+			{
+				if (c != 0) out.push_back(sep);
+				Decode(data, size, [&](const LogFieldView& field) {
+					if (field.key == columns[c]) RenderValue(out, field);
+				});
+			}
+		}
+	}
+}
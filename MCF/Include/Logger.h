@@ -1,12 +1,15 @@
 #pragma once
 #include "EventMan.h"
+#include "LogRecord.h"
 #include <format>
 #include <string>
 #include <string_view>
+#include <atomic>
+#include <initializer_list>
 
 namespace MCF
 {
-	class Logger : public SharedInterface<Logger, "MCF_LOGGER_001">
+	class Logger : public SharedInterface<Logger, "MCF_LOGGER_002">
 	{
 	public:
 		struct LogEvent : Event<"MCF_LOG_EVENT">
@@ -14,6 +17,22 @@ namespace MCF
 			const char* source;
 			const char* sev;
 			const char* msg;
+			LogSourceId source_id; // After the original fields, so that older listeners can still read them
+		};
+
+		/// <summary>
+		/// Event raised for every logged message, carrying its structured fields in the binary layout of LogRecord.h. 
+		/// Sinks which listen to this event instead of LogEvent never pay for text formatting of structured messages.
+		/// Messages logged without fields have fields_size = 0.
+		/// </summary>
+		struct StructuredLogEvent : Event<"MCF_STRUCTURED_LOG_EVENT">
+		{
+			const char* source;
+			LogSourceId source_id;
+			const char* sev;
+			const char* msg;
+			const uint8_t* fields;
+			size_t fields_size;
 		};
 
 		static constexpr const char* SevDebug = "debug";
@@ -23,9 +42,83 @@ namespace MCF
 
 		static constexpr const char* FilterRemove = (const char*)1;
 
+		/// <summary>
+		/// Per-source flags, stored in a flat array indexed by LogSourceId.
+		/// </summary>
+		static constexpr uint32_t SourceEnabled = 1; // Messages from this source are formatted and logged at all
+		static constexpr uint32_t SourcePassesFilter = 2; // The source matches the source regex filter
+		static constexpr uint32_t SourceLimited = 4; // A rate limit or duplicate suppression rule applies to the source
+		static constexpr uint32_t SourceRecorded = 8; // The flight recorder is enabled, so messages of disabled sources are still formatted
+
+		/// <summary>
+		/// Size of the source table. Messages logged under an ID past it are logged under InvalidLogSource.
+		/// </summary>
+		static constexpr LogSourceId MaxLogSources = 4096;
+
+		/// <summary>
+		/// Number of sources which may be registered implicitly by logging under a source name (see FindSource).
+		/// </summary>
+		static constexpr LogSourceId MaxImplicitSources = 256;
+
+	protected:
+		/// <summary>
+		/// Flags of each registered source. Set by the implementation, and valid for the lifetime of the logger.
+		/// </summary>
+		const std::atomic<uint32_t>* source_flags = nullptr;
+
+	public:
+		/// <summary>
+		/// Register a log source by name, returning a small integer ID for it. Registering the same name twice 
+		/// returns the same ID. Returns InvalidLogSource (which logs under the "unknown" source) if the source 
+		/// table is full.
+		/// </summary>
+		virtual LogSourceId RegisterSource(const char* name) = 0;
+
+		/// <summary>
+		/// Get the name of a registered log source.
+		/// </summary>
+		virtual const char* SourceName(LogSourceId source) = 0;
+
+		/// <summary>
+		/// Enable or disable a log source. Messages from disabled sources are not passed to listeners. They are only
+		/// formatted if the flight recorder is enabled, which records them.
+		/// </summary>
+		virtual void SetSourceEnabled(LogSourceId source, bool enabled) = 0;
+
+		/// <summary>
+		/// Returns true if messages from this source are currently logged.
+		/// </summary>
+		inline bool IsSourceEnabled(LogSourceId source) const
+		{
+			if (source >= MaxLogSources) source = InvalidLogSource;
+			return source_flags[source].load(std::memory_order_relaxed) & SourceEnabled;
+		}
+
+		/// <summary>
+		/// Log a preformatted message. Rate limits and duplicate suppression are keyed on the text of the message.
+		/// </summary>
+		virtual void Log(LogSourceId source, const char* severity, const char* message) = 0;
 		virtual void Log(const char* source, const char* severity, const char* message) = 0;
 		virtual void Log(const char* source, const char* severity, const wchar_t* message) = 0;
 
+		/// <summary>
+		/// Log a message with typed key/value fields. The fields are encoded in a compact binary record which is passed
+		/// as-is to StructuredLogEvent listeners. The fields are only rendered as text (appended to the message as 
+		/// key=value pairs) if there are LogEvent listeners. Rate limits and duplicate suppression are keyed on message.
+		/// </summary>
+		virtual void LogFields(LogSourceId source, const char* severity, const char* message, const LogField* fields, size_t count) = 0;
+
+		inline void LogFields(LogSourceId source, const char* severity, const char* message, std::initializer_list<LogField> fields)
+		{
+			LogFields(source, severity, message, fields.begin(), fields.size());
+		}
+
+		template<class TComp> requires requires(TComp* c) { c->LogSource(); }
+		inline void LogFields(TComp* source, const char* severity, const char* message, std::initializer_list<LogField> fields)
+		{
+			LogFields(source->LogSource(), severity, message, fields.begin(), fields.size());
+		}
+
 		/// <summary>
 		/// Set a global filter on log messages, based on either the source, severity or message contents.
 		/// Passing NULL for a filter will leave it untouched, while passing FILTER_REMOVE (1) will remove it.
@@ -38,26 +131,134 @@ namespace MCF
 		/// </summary>
 		virtual void SetFilter(const char* source_regex, const char* sev_regex, const wchar_t* msg_regex) = 0;
 
-		template<class Fmt, class... Args>
-		inline void Log(const char* source, const char* severity, Fmt fmt, Args&&... args)
+		/// <summary>
+		/// (Re)open the flight recorder, a circular buffer of the last slot_count messages stored in a named shared memory 
+		/// segment (see FlightRecorder.h). Every message is recorded, including those rejected by filters and disabled
+		/// sources, but not those dropped by rate limits and duplicate suppression, which are never formatted.
+		/// slot_count must be at most FlightRecorder::MaxSlotCount.
+		/// If backing_file is not null, the segment is backed by this file so it can be read after the process dies.
+		/// The flight recorder is enabled with 4096 slots and no backing file by default.
+		/// </summary>
+		/// <returns>True if the shared memory segment could be created.</returns>
+		virtual bool EnableFlightRecorder(uint32_t slot_count, const char* backing_file = nullptr) = 0;
+
+		/// <summary>
+		/// Close the flight recorder shared memory segment.
+		/// </summary>
+		virtual void DisableFlightRecorder() = 0;
+
+		/// <summary>
+		/// Counters of messages dropped by rate limits and duplicate suppression.
+		/// </summary>
+		struct LogMetrics
+		{
+			uint64_t rate_limited;
+			uint64_t duplicates;
+		};
+
+		/// <summary>
+		/// Apply rate limits and duplicate suppression to a message about to be logged, before it is formatted.
+		/// fmt_key identifies the message, and is typically the address of the format string. 
+		/// The formatting helpers (Log with format arguments, Debug, Info, Warn, Error) call this automatically
+		/// for sources flagged with SourceLimited.
+		/// </summary>
+		/// <returns>True if the message should be logged.</returns>
+		virtual bool Admit(LogSourceId source, const char* severity, const void* fmt_key) = 0;
+
+		/// <summary>
+		/// Set a token bucket rate limit on messages from sources matching source_regex, allowing msgs_per_sec messages 
+		/// per second on average and bursts of up to burst messages. Passing NULL for the regex sets the default limit
+		/// of all sources. Passing msgs_per_sec = 0 removes the rate limit for this regex.
+		/// </summary>
+		virtual void SetRateLimit(const char* source_regex, float msgs_per_sec, uint32_t burst) = 0;
+
+		/// <summary>
+		/// Suppress repeated messages (same source and format string) logged within window_ms milliseconds of the first 
+		/// one. Once the window has ended, a "Previous message repeated N times" line is logged by the next message
+		/// logged from any source. Passing NULL for the regex sets the default for all sources. Passing window_ms = 0
+		/// removes duplicate suppression for this regex.
+		/// </summary>
+		virtual void SetDuplicateSuppression(const char* source_regex, uint32_t window_ms) = 0;
+
+		/// <summary>
+		/// Get the suppression metrics of a particular source.
+		/// </summary>
+		virtual LogMetrics GetMetrics(LogSourceId source) = 0;
+
+		/// <summary>
+		/// Log a message which was already admitted by Admit: record it, and pass it to listeners if its source is
+		/// enabled. Used by the formatting helpers, which call Admit before formatting.
+		/// </summary>
+		virtual void LogAdmitted(LogSourceId source, const char* severity, const char* message) = 0;
+
+		/// <summary>
+		/// Get the suppression metrics totalled over all sources.
+		/// </summary>
+		virtual LogMetrics GetTotalMetrics() = 0;
+
+		/// <summary>
+		/// Get the ID of a source by name, registering it if fewer than MaxImplicitSources sources were registered this
+		/// way. Returns InvalidLogSource otherwise. Used when logging under a source name, so that logging under many
+		/// distinct strings does not fill the source table.
+		/// </summary>
+		virtual LogSourceId FindSource(const char* name) = 0;
+
+		/// <summary>
+		/// Source IDs of the values accepted as a log source by the formatting helpers.
+		/// Components log under their cached source ID, avoiding the name lookup.
+		/// </summary>
+		inline LogSourceId SourceId(LogSourceId source) { return source; }
+		inline LogSourceId SourceId(const char* source) { return FindSource(source); }
+		inline LogSourceId SourceId(IComponent* source) { return RegisterSource(source->VersionString()); }
+
+		template<class TComp> requires requires(TComp* c) { c->LogSource(); }
+		inline LogSourceId SourceId(TComp* source) { return source->LogSource(); }
+
+		/// <summary>
+		/// Format and log a message. The format string is checked at compile time, and its address is the key of
+		/// duplicate suppression.
+		/// </summary>
+		template<class... Args>
+		inline void LogFormat(LogSourceId source, const char* severity, std::format_string<Args...> fmt, Args&&... args)
+		{
+			if (source >= MaxLogSources) source = InvalidLogSource;
+
+			uint32_t flags = source_flags[source].load(std::memory_order_relaxed);
+			if (!(flags & (SourceEnabled | SourceRecorded))) return;
+			if ((flags & SourceLimited) && !Admit(source, severity, fmt.get().data())) return;
+
+			auto message = std::format(fmt, std::forward<Args>(args)...);
+			LogAdmitted(source, severity, message.c_str());
+		}
+
+		template<class Source, class... Args>
+		inline void Log(Source source, const char* severity, std::format_string<Args...> fmt, Args&&... args)
+		{
+			LogFormat<Args...>(SourceId(source), severity, fmt, std::forward<Args>(args)...);
+		}
+
+		template<class Source, class... Args>
+		inline void Debug(Source source, std::format_string<Args...> fmt, Args&&... args)
+		{
+			LogFormat<Args...>(SourceId(source), SevDebug, fmt, std::forward<Args>(args)...);
+		}
+
+		template<class Source, class... Args>
+		inline void Info(Source source, std::format_string<Args...> fmt, Args&&... args)
 		{
-			auto message = std::format(fmt, args...);
-			Log(source, severity, message.c_str());
+			LogFormat<Args...>(SourceId(source), SevInfo, fmt, std::forward<Args>(args)...);
 		}
 
-		template<class Fmt, class... Args>
-		inline void Log(IComponent* source, const char* severity, Fmt fmt, Args&&... args)
+		template<class Source, class... Args>
+		inline void Warn(Source source, std::format_string<Args...> fmt, Args&&... args)
 		{
-			Log(source->VersionString(), severity, fmt, args...);
+			LogFormat<Args...>(SourceId(source), SevWarn, fmt, std::forward<Args>(args)...);
 		}
 
-		template<class Source, class Fmt, class... Args>
-		inline void Debug(Source source, Fmt fmt, Args&&... args) { Log(source, SevDebug, fmt, args...); }
-		template<class Source, class Fmt, class... Args>
-		inline void Info(Source source, Fmt fmt, Args&&... args) { Log(source, SevInfo, fmt, args...); }
-		template<class Source, class Fmt, class... Args>
-		inline void Warn(Source source, Fmt fmt, Args&&... args) { Log(source, SevWarn, fmt, args...); }
-		template<class Source, class Fmt, class... Args>
-		inline void Error(Source source, Fmt fmt, Args&&... args) { Log(source, SevError, fmt, args...); }
+		template<class Source, class... Args>
+		inline void Error(Source source, std::format_string<Args...> fmt, Args&&... args)
+		{
+			LogFormat<Args...>(SourceId(source), SevError, fmt, std::forward<Args>(args)...);
+		}
 	};
 }
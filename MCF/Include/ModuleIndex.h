@@ -0,0 +1,77 @@
+#pragma once
+#include "SharedInterface.h"
+#include "EventMan.h"
+#include "ModuleTypes.h"
+
+namespace MCF
+{
+	/// <summary>
+	/// Index of the modules loaded in the process and of their sections, enumerated once and kept up to date as
+	/// modules are loaded and unloaded. Sections are those of the PE headers on Windows, and the loadable segments
+	/// of the ELF program headers elsewhere. Lookups by address are O(log n).
+	/// </summary>
+	class ModuleIndex : public SharedInterface<ModuleIndex, "MCF_MODULE_INDEX_001">
+	{
+	public:
+		using SectionFlags = ModuleTypes::SectionFlags;
+		using enum ModuleTypes::SectionFlags;
+		using ModuleInfo = ModuleTypes::ModuleInfo;
+		using SectionInfo = ModuleTypes::SectionInfo;
+
+		/// <summary>
+		/// Raised after a module is added to the index. Modules loaded after the index was created are reported by a
+		/// loader notification, which only records them: the event is then raised from a worker thread.
+		/// </summary>
+		struct ModuleLoadedEvent : public Event<"MCF_MODULE_LOADED_EVENT">
+		{
+			ModuleInfo module;
+		};
+
+		/// <summary>
+		/// Raised after a module is removed from the index. When it was unloaded by the loader, the event is raised
+		/// from a worker thread and its memory may already be unmapped, so handlers must not read it.
+		/// </summary>
+		struct ModuleUnloadedEvent : public Event<"MCF_MODULE_UNLOADED_EVENT">
+		{
+			ModuleInfo module;
+		};
+
+		/// <summary>
+		/// Find the module containing an address.
+		/// </summary>
+		virtual bool FindModule(uintptr_t address, ModuleInfo* out) = 0;
+
+		/// <summary>
+		/// Find a module by file name (case insensitive), or the main module if name is NULL.
+		/// </summary>
+		virtual bool FindModuleByName(const char* name, ModuleInfo* out) = 0;
+
+		/// <summary>
+		/// Find the section containing an address.
+		/// </summary>
+		virtual bool FindSection(uintptr_t address, SectionInfo* out) = 0;
+
+		/// <summary>
+		/// Get the loaded modules, sorted by base address.
+		/// </summary>
+		/// <returns>The total number of modules, which may be larger than max.</returns>
+		virtual size_t GetModules(ModuleInfo* out, size_t max) = 0;
+
+		/// <summary>
+		/// Get the sections of the module at the given base address, sorted by address.
+		/// </summary>
+		/// <returns>The total number of sections of the module, which may be larger than max.</returns>
+		virtual size_t GetSections(uintptr_t module_base, SectionInfo* out, size_t max) = 0;
+
+		/// <summary>
+		/// Counter incremented every time a module is added or removed, for caches derived from the index.
+		/// </summary>
+		virtual uint64_t Generation() = 0;
+
+		/// <summary>
+		/// Enumerate the loaded modules again and apply the differences. Only needed on platforms without module
+		/// load notifications (i.e. not Windows), after loading or unloading libraries.
+		/// </summary>
+		virtual void Refresh() = 0;
+	};
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+namespace MCF
+{
+	/// <summary>
+	/// Modules and sections of ModuleIndex, in their own header so that the code reading them builds without the
+	/// component headers.
+	/// </summary>
+	struct ModuleTypes
+	{
+		enum SectionFlags : uint32_t
+		{
+			SectionRead = 1,
+			SectionWrite = 2,
+			SectionExecute = 4
+		};
+
+		struct ModuleInfo
+		{
+			uintptr_t base;
+			size_t size;
+			uint32_t timestamp; // PE TimeDateStamp, or 0 for ELF modules
+			uint32_t num_sections;
+			char name[256]; // File name, without the directory
+		};
+
+		struct SectionInfo
+		{
+			uintptr_t begin;
+			size_t size;
+			uintptr_t module_base;
+			uint32_t flags; // SectionFlags
+			char name[9]; // Name in the section header, or the flags of an ELF segment (ex. "r-x")
+			const void* header; // IMAGE_SECTION_HEADER on Windows, ElfW(Phdr) elsewhere
+		};
+	};
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "SharedInterface.h"
+
+namespace MCF
+{
+	/// <summary>
+	/// Console served over a local socket (a named pipe on Windows, a Unix domain socket elsewhere). Each line sent
+	/// by a client is run with CommandMan::RunCommandAsync, its output being sent back to that client only, and 
+	/// all clients receive the log stream.
+	/// </summary>
+	class RemoteConsole : public SharedInterface<RemoteConsole, "MCF_REMOTE_CONSOLE_001">
+	{
+	public:
+		struct ClientStats
+		{
+			uint32_t id;
+			uint64_t bytes_sent;
+			uint64_t dropped_lines; // Lines dropped because the client did not read fast enough
+			size_t pending_bytes;
+		};
+
+		/// <summary>
+		/// Start listening at the given named pipe or socket path. The default, used when address is NULL, is
+		/// "\\.\pipe\MCF_RemoteConsole_PID" on Windows and "/tmp/MCF_RemoteConsole_PID.sock" elsewhere.
+		/// The console starts listening at the default address when loaded.
+		/// </summary>
+		/// <returns>False if already listening or the address could not be bound.</returns>
+		virtual bool Listen(const char* address = nullptr) = 0;
+
+		/// <summary>
+		/// Stop listening and disconnect all clients.
+		/// </summary>
+		virtual void Stop() = 0;
+
+		/// <summary>
+		/// Set the maximum number of bytes waiting to be sent to a client, after which lines sent to it are dropped.
+		/// </summary>
+		virtual void SetClientBufferSize(size_t bytes) = 0;
+
+		virtual size_t ClientCount() = 0;
+
+		/// <summary>
+		/// Get the statistics of the connected clients.
+		/// </summary>
+		/// <returns>The number of clients written to out.</returns>
+		virtual size_t GetClientStats(ClientStats* out, size_t max) = 0;
+	};
+}
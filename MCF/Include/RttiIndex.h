@@ -0,0 +1,61 @@
+#pragma once
+#include "SharedInterface.h"
+#include "EventMan.h"
+
+namespace MCF
+{
+	/// <summary>
+	/// Index of the vtables of the classes of a module by name, built from its RTTI: MSVC complete object locators
+	/// on Windows, and Itanium typeinfo objects elsewhere. A module is indexed in parallel the first time it is
+	/// looked up, after which lookups are O(1). The index is cached on disk alongside the AOB cache, and is reused
+	/// as long as the module is unchanged.
+	/// </summary>
+	class RttiIndex : public SharedInterface<RttiIndex, "MCF_RTTI_INDEX_001">
+	{
+	public:
+		struct VTableInfo
+		{
+			uintptr_t address; // Address of the first virtual function pointer
+			uintptr_t module_base;
+			uint32_t num_methods;
+			int32_t offset; // Offset of the subobject using this vtable in the complete object, 0 for the primary one
+		};
+
+		/// <summary>
+		/// Find the vtables of a class in a module, or in the main module if module_name is NULL. The class name is
+		/// either demangled (ex. CS::ChrIns) or decorated (ex. .?AVChrIns@CS@@ or N2CS6ChrInsE). Classes with several
+		/// polymorphic bases have one vtable per base, sorted by offset.
+		/// </summary>
+		/// <param name="out">Array receiving up to max vtables.</param>
+		/// <returns>The total number of vtables of the class, which may be larger than max.</returns>
+		virtual size_t FindVTables(const char* class_name, VTableInfo* out, size_t max, const char* module_name = nullptr) = 0;
+
+		/// <summary>
+		/// Find the primary vtable of a class. See FindVTables.
+		/// </summary>
+		/// <returns>The address of the vtable, or 0 if not found.</returns>
+		uintptr_t FindVTable(const char* class_name, const char* module_name = nullptr)
+		{
+			VTableInfo info;
+			return FindVTables(class_name, &info, 1, module_name) ? info.address : 0;
+		}
+
+		/// <summary>
+		/// Get the demangled name of the class of a vtable from its RTTI. Works for any module, indexed or not.
+		/// </summary>
+		/// <returns>False if the address is not a vtable with RTTI, or the buffer is too small.</returns>
+		virtual bool ClassNameOf(uintptr_t vtable, char* out, size_t size) = 0;
+
+		/// <summary>
+		/// Index a module now rather than on first lookup, or the main module if module_name is NULL.
+		/// </summary>
+		/// <returns>The number of vtables found.</returns>
+		virtual size_t IndexModule(const char* module_name = nullptr) = 0;
+
+		/// <summary>
+		/// Set the file in which the index is cached between launches, or NULL to disable the cache.
+		/// By default, the cache is stored in the temp directory.
+		/// </summary>
+		virtual void SetCachePath(const char* path) = 0;
+	};
+}
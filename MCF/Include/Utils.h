@@ -10,7 +10,7 @@ namespace MCF
 		/// </summary>
 		/// <param name="c"></param>
 		/// <returns></returns>
-		inline uint8_t ChrToHex(char c)
+		constexpr uint8_t ChrToHex(char c)
 		{
 			if (c >= 'a' && c <= 'f')
 				return 10 + c - 'a';
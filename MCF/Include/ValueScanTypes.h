@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+namespace MCF
+{
+	/// <summary>
+	/// Types of the values and comparisons of ValueScanner, in their own header so that the scanning code builds
+	/// without the component headers.
+	/// </summary>
+	struct ValueScanTypes
+	{
+		enum class ValueType : uint8_t
+		{
+			I8, I16, I32, I64, F32, F64
+		};
+
+		enum class ScanCompare : uint8_t
+		{
+			Exact, // Equal to a
+			Range, // Between a and b, inclusive
+			Unknown, // Any value, to compare against in next scans. First scan only
+			Changed, // Different from the previous scan. Next scans only, as are the following ones
+			Unchanged,
+			Increased,
+			Decreased
+		};
+
+		/// <summary>
+		/// Value compared against. i is used by integer scans, and f by floating point ones.
+		/// </summary>
+		struct ScanValue
+		{
+			int64_t i;
+			double f;
+
+			static constexpr ScanValue Int(int64_t i) { return { i, (double)i }; }
+			static constexpr ScanValue Float(double f) { return { (int64_t)f, f }; }
+		};
+	};
+}
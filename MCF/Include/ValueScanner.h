@@ -0,0 +1,60 @@
+#pragma once
+#include "SharedInterface.h"
+#include "EventMan.h"
+#include "ValueScanTypes.h"
+
+namespace MCF
+{
+	typedef int ScanHandle;
+
+	/// <summary>
+	/// In-process memory value scanner, to find runtime data such as player stats or entity lists without an
+	/// external tool. A first scan searches the committed writable memory of the process for a value, and next
+	/// scans narrow down the candidates it found by comparing them again, e.g. against their previous value.
+	/// </summary>
+	class ValueScanner : public SharedInterface<ValueScanner, "MCF_VALUE_SCANNER_001">
+	{
+	public:
+		using ValueType = ValueScanTypes::ValueType;
+		using ScanCompare = ValueScanTypes::ScanCompare;
+		using ScanValue = ValueScanTypes::ScanValue;
+
+		/// <summary>
+		/// Create a scan for values of a type. Values are searched at multiples of alignment, or of the size of the
+		/// type if it is 0. Only scans aligned to the size of their type use the vectorized compares.
+		/// </summary>
+		/// <returns>The handle of the scan, or 0 if the alignment is not a power of two.</returns>
+		virtual ScanHandle NewScan(ValueType type, size_t alignment = 0) = 0;
+
+		/// <summary>
+		/// Search all committed writable memory, replacing the candidates of the scan. Changed and later
+		/// comparisons are not valid here.
+		/// </summary>
+		/// <returns>The number of candidates found.</returns>
+		virtual size_t FirstScan(ScanHandle handle, ScanCompare compare, ScanValue a = { }, ScanValue b = { }) = 0;
+
+		/// <summary>
+		/// Compare the candidates of the scan again, keeping those which match. Candidates in memory which was
+		/// freed since the last scan are dropped. Unknown is not valid here.
+		/// </summary>
+		/// <returns>The number of remaining candidates.</returns>
+		virtual size_t NextScan(ScanHandle handle, ScanCompare compare, ScanValue a = { }, ScanValue b = { }) = 0;
+
+		/// <summary>
+		/// Get the addresses of the candidates of a scan, in increasing order, starting from the first-th one.
+		/// </summary>
+		/// <param name="out">Array receiving up to max addresses.</param>
+		/// <returns>The total number of candidates.</returns>
+		virtual size_t GetResults(ScanHandle handle, uintptr_t* out, size_t max, size_t first = 0) = 0;
+
+		/// <summary>
+		/// Free a scan and its candidates.
+		/// </summary>
+		virtual void CloseScan(ScanHandle handle) = 0;
+
+		/// <summary>
+		/// Set the number of threads scanning memory in parallel, or 0 for one per hardware thread (the default).
+		/// </summary>
+		virtual void SetScanThreadCount(size_t count) = 0;
+	};
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "SharedInterface.h"
+#include "EventMan.h"
+
+namespace MCF
+{
+	/// <summary>
+	/// Index of the references made by the code of a module: RIP-relative (or absolute) memory operands, immediates
+	/// pointing into the module, and the targets of direct calls and jumps. Modules are decoded with Zydis in 
+	/// parallel chunks on a background thread. References are sorted by target, so lookups are O(log n).
+	/// </summary>
+	class XrefIndex : public SharedInterface<XrefIndex, "MCF_XREF_INDEX_001">
+	{
+	public:
+		enum class XrefType : uint8_t
+		{
+			Data, // Memory operand or immediate
+			Call, // Direct call
+			Jump // Direct unconditional jump with a 32-bit displacement, usually a tail call
+		};
+
+		struct Xref
+		{
+			uintptr_t from; // Address of the referencing instruction
+			uintptr_t to;
+			XrefType type;
+		};
+
+		/// <summary>
+		/// Queue a module for indexing on the background thread, or the main module if module_name is NULL.
+		/// If no module was queued by the first query, the main module is.
+		/// </summary>
+		/// <returns>False if the module is not loaded.</returns>
+		virtual bool IndexModule(const char* module_name = nullptr) = 0;
+
+		/// <summary>
+		/// Find the code referencing [address, address + size) in the indexed modules, sorted by target and then
+		/// by referencing address. Waits for the queued modules to be indexed.
+		/// </summary>
+		/// <param name="out">Array receiving up to max references.</param>
+		/// <returns>The total number of references, which may be larger than max.</returns>
+		virtual size_t FindReferences(uintptr_t address, Xref* out, size_t max, size_t size = 1) = 0;
+
+		/// <summary>
+		/// Find the direct calls and tail calls to a function. See FindReferences.
+		/// </summary>
+		virtual size_t FindCallers(uintptr_t function, Xref* out, size_t max) = 0;
+
+		/// <summary>
+		/// Find the code referencing a string literal of a module, or of the main module if module_name is NULL. 
+		/// Every null-terminated occurrence of the string in the data sections of the module is searched, both as 
+		/// narrow and UTF-16 text. The module is indexed first if it was not. See FindReferences.
+		/// </summary>
+		virtual size_t FindStringReferences(const char* string, Xref* out, size_t max, const char* module_name = nullptr) = 0;
+	};
+}